@@ -0,0 +1,33 @@
+#include "alloc_counter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+thread_local size_t allocations = 0;
+
+void* countedAlloc(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+}
+
+size_t allocationCount() {return allocations;}
+
+void* operator new(size_t size) {return countedAlloc(size);}
+void* operator new[](size_t size) {return countedAlloc(size);}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    ++allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete[](void* p) noexcept {std::free(p);}
+void operator delete(void* p, size_t) noexcept {std::free(p);}
+void operator delete[](void* p, size_t) noexcept {std::free(p);}
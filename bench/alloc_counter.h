@@ -0,0 +1,14 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+
+// Number of global operator new calls made so far by the calling thread.
+// Linking alloc_counter.cpp replaces the global allocation functions.
+size_t allocationCount();
+
+// Reports the allocations made since `allocationsBefore` as allocs_per_op
+inline void reportAllocations(benchmark::State& state, size_t allocationsBefore) {
+    state.counters["allocs_per_op"] = benchmark::Counter(
+        static_cast<double>(allocationCount() - allocationsBefore), benchmark::Counter::kAvgIterations);
+}
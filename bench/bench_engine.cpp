@@ -0,0 +1,215 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.h"
+#include "attacks.h"
+#include "fen.h"
+#include "game.h"
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Middlegames with castling still possible, pieces pinned and captures on offer
+const char* const MIDGAME_FENS[] = {
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqk2r/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R1BQK2R b KQkq - 0 7",
+    "r2qr1k1/1b1nbppp/p2p1n2/1pp1p3/4P3/2PP1N1P/PPBN1PP1/R1BQR1K1 w - - 0 13",
+    "2rq1rk1/pb2bppp/1pn1pn2/3p4/2PP4/P1NBPN2/1P3PPP/R2Q1RK1 w - - 0 12",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 8",
+};
+
+// The corpus boards, loaded once and shared by every benchmark
+const std::vector<std::unique_ptr<Board>>& midgameBoards() {
+    static const std::vector<std::unique_ptr<Board>> boards = []() {
+        std::vector<std::unique_ptr<Board>> loaded;
+        for (const char* fen : MIDGAME_FENS) {
+            loaded.push_back(std::make_unique<Board>());
+            loadFen(*loaded.back(), fen);
+        }
+        rookAttacks(0, EMPTY_BITBOARD); // Build the slider tables outside the timed loops
+        return loaded;
+    }();
+    return boards;
+}
+
+// Constructed ahead of Game, which checks the players' colors
+struct CorpusPlayers {
+    Player white{Color::WHITE};
+    Player black{Color::BLACK};
+};
+
+// Opens up the end-of-game checks on a corpus board. The game is never started, so the pieces stay the board's.
+class CorpusGame : private CorpusPlayers, public Game {
+    public:
+        CorpusGame(Board* board, BoardRules* rules) : Game(&white, &black, board, rules) {};
+
+        using Game::_isStalemate;
+        using Game::_hasInsufficientMaterial;
+        using Game::_isHorcruxCaptured;
+};
+
+void BM_BoardConstruction(benchmark::State& state) {
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        Board board;
+        benchmark::DoNotOptimize(board);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_BoardConstruction);
+
+void BM_BoardCopy(benchmark::State& state) {
+    const auto& boards = midgameBoards();
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        for (const auto& pBoard : boards) {
+            Board copy(*pBoard);
+            benchmark::DoNotOptimize(copy);
+        }
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_BoardCopy);
+
+// Every square of every corpus board
+void BM_GetSquare(benchmark::State& state) {
+    const auto& boards = midgameBoards();
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        for (const auto& pBoard : boards) {
+            for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+                benchmark::DoNotOptimize(pBoard->getSquare(toPosition(square)));
+            }
+        }
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_GetSquare);
+
+// Pseudo-legal targets of every piece of one type, both colors, across the corpus
+void BM_GetPossiblePositions(benchmark::State& state, PieceType type) {
+    const auto& boards = midgameBoards();
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        size_t total = 0;
+        for (const auto& pBoard : boards) {
+            Bitboard pieces = pBoard->getPieces(type);
+            while (pieces) {
+                const int square = popLsb(pieces);
+                total += pBoard->getPiece(square)->getPossiblePositions(toPosition(square)).size();
+            }
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, pawn, PieceType::PAWN);
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, knight, PieceType::KNIGHT);
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, bishop, PieceType::BISHOP);
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, rook, PieceType::ROOK);
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, queen, PieceType::QUEEN);
+BENCHMARK_CAPTURE(BM_GetPossiblePositions, king, PieceType::KING);
+
+// Both kings of every corpus board
+void BM_IsInCheck(benchmark::State& state) {
+    const auto& boards = midgameBoards();
+    BoardRules rules;
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        int checks = 0;
+        for (const auto& pBoard : boards) {
+            checks += rules.isInCheck(*pBoard, Color::WHITE);
+            checks += rules.isInCheck(*pBoard, Color::BLACK);
+        }
+        benchmark::DoNotOptimize(checks);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_IsInCheck);
+
+// Both castling moves for each king still on its home square
+void BM_IsValidCastling(benchmark::State& state) {
+    const auto& boards = midgameBoards();
+    BoardRules rules;
+    std::vector<std::pair<const Board*, Move>> kingMoves;
+    for (const auto& pBoard : boards) {
+        for (Color color : {Color::WHITE, Color::BLACK}) {
+            const int rank = color == Color::WHITE ? 1 : 8;
+            const IPiece* king = pBoard->getSquare(Position('e', rank))->getPiece();
+            if (!king || king->getType() != PieceType::KING || king->getColor() != color) {continue;}
+            kingMoves.emplace_back(pBoard.get(), Move(king, Position('e', rank), Position('g', rank)));
+            kingMoves.emplace_back(pBoard.get(), Move(king, Position('e', rank), Position('c', rank)));
+        }
+    }
+
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        int valid = 0;
+        for (const auto& [pBoard, kingMove] : kingMoves) {
+            valid += rules.isValidCastling(*pBoard, kingMove);
+        }
+        benchmark::DoNotOptimize(valid);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_IsValidCastling);
+
+// Every piece of the side to move across the corpus, the work behind /game/positions
+void BM_GenerateValidPositionsMidgame(benchmark::State& state) {
+    const auto& boards = midgameBoards();
+    BoardRules rules;
+    const Move noPreviousMove;
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        size_t total = 0;
+        for (const auto& pBoard : boards) {
+            Bitboard pieces = pBoard->getOccupancy(pBoard->getSideToMove());
+            while (pieces) {
+                const int square = popLsb(pieces);
+                total += rules.generateValidPositions(*pBoard, toPosition(square), noPreviousMove).size();
+            }
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_GenerateValidPositionsMidgame);
+
+// Runs one of the end-of-game checks on a game over each corpus board
+template<typename Check>
+void runGameCheck(benchmark::State& state, Check check) {
+    const auto& boards = midgameBoards();
+    BoardRules rules;
+    std::vector<std::unique_ptr<CorpusGame>> games;
+    for (const auto& pBoard : boards) {
+        games.push_back(std::make_unique<CorpusGame>(pBoard.get(), &rules));
+    }
+
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        int results = 0;
+        for (const auto& pGame : games) {
+            results += check(*pGame);
+        }
+        benchmark::DoNotOptimize(results);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+
+void BM_IsStalemate(benchmark::State& state) {
+    runGameCheck(state, [](const CorpusGame& game) {return game._isStalemate();});
+}
+BENCHMARK(BM_IsStalemate);
+
+void BM_HasInsufficientMaterial(benchmark::State& state) {
+    runGameCheck(state, [](const CorpusGame& game) {return game._hasInsufficientMaterial();});
+}
+BENCHMARK(BM_HasInsufficientMaterial);
+
+// An ID no piece has, so every piece is scanned
+void BM_IsHorcruxCaptured(benchmark::State& state) {
+    runGameCheck(state, [](const CorpusGame& game) {return game._isHorcruxCaptured(MAX_PIECE_ID + 1);});
+}
+BENCHMARK(BM_IsHorcruxCaptured);
+
+} // namespace
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include "alloc_counter.h"
+#include "game.h"
+#include "attacks.h"
+
+namespace {
+
+// A started game gives the standard opening position with every piece in place
+class StartedGame {
+    public:
+        StartedGame()
+            : white_(Color::WHITE), black_(Color::BLACK),
+              game_(&white_, &black_, &board_, &rules_) {
+            game_.startGame();
+        }
+
+        const Board& getBoard() const {return board_;}
+        BoardRules& getRules() {return rules_;}
+
+    private:
+        Player white_;
+        Player black_;
+        Board board_;
+        BoardRules rules_;
+        Game game_;
+};
+
+// Every piece of the side to move, the work behind /game/positions for each square
+void BM_GenerateValidMoves(benchmark::State& state) {
+    StartedGame started;
+    const Board& board = started.getBoard();
+    const Move noPreviousMove;
+    rookAttacks(0, EMPTY_BITBOARD); // Build the slider tables outside the timed loop
+
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        size_t total = 0;
+        Bitboard pieces = board.getOccupancy(Color::WHITE);
+        while (pieces) {
+            int square = popLsb(pieces);
+            MoveList moves;
+            started.getRules().generateValidMoves(board, toPosition(square), noPreviousMove, moves);
+            total += moves.size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_GenerateValidMoves);
+
+// The same work through the unordered_set API, for comparison
+void BM_GenerateValidPositions(benchmark::State& state) {
+    StartedGame started;
+    const Board& board = started.getBoard();
+    const Move noPreviousMove;
+
+    size_t allocationsBefore = allocationCount();
+    for (auto _ : state) {
+        size_t total = 0;
+        Bitboard pieces = board.getOccupancy(Color::WHITE);
+        while (pieces) {
+            int square = popLsb(pieces);
+            total += started.getRules().generateValidPositions(board, toPosition(square), noPreviousMove).size();
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    reportAllocations(state, allocationsBefore);
+}
+BENCHMARK(BM_GenerateValidPositions);
+
+}
+
+BENCHMARK_MAIN();
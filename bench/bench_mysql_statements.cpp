@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+#include "mysql_pool.hpp"
+
+#include <cppconn/resultset.h>
+
+/*
+ * Per-call latency of a helper-sized query with and without the statement cache.
+ * Runs against the server named by the MYSQL_* variables, e.g. the docker-compose container.
+ */
+
+namespace {
+
+const std::string QUERY = "SELECT state FROM games WHERE id = ?";
+const std::string MISSING_GAME_ID = "00000000-0000-0000-0000-000000000000";
+
+std::unique_ptr<MySqlPool>& benchPool() {
+    static std::unique_ptr<MySqlPool> pool = createMySqlPool(mysqlConfigFromEnv());
+    return pool;
+}
+
+// What every helper did before the cache: one server-side prepare per call
+void BM_PreparePerCall(benchmark::State& state) {
+    auto con = benchPool()->acquire();
+    for (auto _ : state) {
+        std::unique_ptr<sql::PreparedStatement> pstmt(con->getConnection().prepareStatement(QUERY));
+        pstmt->setString(1, MISSING_GAME_ID);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        benchmark::DoNotOptimize(res->next());
+    }
+}
+BENCHMARK(BM_PreparePerCall)->Unit(benchmark::kMicrosecond);
+
+void BM_CachedStatement(benchmark::State& state) {
+    auto con = benchPool()->acquire();
+    for (auto _ : state) {
+        sql::PreparedStatement& pstmt = con->prepare(QUERY);
+        pstmt.setString(1, MISSING_GAME_ID);
+        std::unique_ptr<sql::ResultSet> res(pstmt.executeQuery());
+        benchmark::DoNotOptimize(res->next());
+    }
+    state.counters["prepares"] = static_cast<double>(con->getStatements().getMisses());
+}
+BENCHMARK(BM_CachedStatement)->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "attacks.h"
+#include "fen.h"
+#include "perft.h"
+
+/*
+ * chess_perft                     run the reference suite, up to 4 plies by default
+ * chess_perft --depth 5           deepen the suite (each position stops at its deepest known count)
+ * chess_perft --fen "<fen>" --depth 4 [--divide]
+ * Add --threads N to split the root moves across N workers (0 uses every core).
+ * The exit code is non-zero when a reference count does not match.
+ */
+
+namespace {
+
+struct Options {
+    std::string fen;
+    int depth = 4;
+    unsigned threads = 1;
+    bool divide = false;
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--fen" && hasValue) {
+            options.fen = argv[++i];
+        } else if (arg == "--depth" && hasValue) {
+            options.depth = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--divide") {
+            options.divide = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            std::exit(2);
+        }
+    }
+    if (options.threads == 0) {
+        options.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return options;
+}
+
+// Runs one search and prints its node count, time and speed
+uint64_t timedPerft(const Board& board, const BoardRules& rules, Color side, int depth, unsigned threads) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t nodes = perftParallel(board, rules, side, depth, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << std::setw(12) << nodes << " nodes  "
+              << std::fixed << std::setprecision(3) << std::setw(8) << seconds << " s  "
+              << std::setprecision(2) << std::setw(8) << (seconds > 0 ? nodes / seconds / 1e6 : 0.0) << " Mnps";
+    return nodes;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    const BoardRules rules;
+    rookAttacks(0, EMPTY_BITBOARD); // Build the slider tables before anything is timed
+
+    if (!options.fen.empty()) {
+        Board board;
+        Color side = loadFen(board, options.fen);
+
+        if (options.divide) {
+            uint64_t total = 0;
+            for (const auto& entry : perftDivide(board, rules, side, options.depth)) {
+                std::cout << entry.first.toUci() << ": " << entry.second << std::endl;
+                total += entry.second;
+            }
+            std::cout << "\nNodes searched: " << total << std::endl;
+            return 0;
+        }
+
+        std::cout << "depth " << options.depth << "  ";
+        timedPerft(board, rules, side, options.depth, options.threads);
+        std::cout << std::endl;
+        return 0;
+    }
+
+    bool allMatch = true;
+    for (const PerftPosition& position : referencePerftPositions()) {
+        Board board;
+        Color side = loadFen(board, position.fen);
+        int maxDepth = std::min<int>(options.depth, position.nodes.size());
+
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            std::cout << std::left << std::setw(10) << position.name << std::right << " depth " << depth << "  ";
+            uint64_t nodes = timedPerft(board, rules, side, depth, options.threads);
+
+            bool matches = nodes == position.nodes[depth - 1];
+            allMatch = allMatch && matches;
+            std::cout << (matches ? "  ok" : "  MISMATCH, expected " + std::to_string(position.nodes[depth - 1])) << std::endl;
+        }
+    }
+    return allMatch ? 0 : 1;
+}
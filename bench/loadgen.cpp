@@ -0,0 +1,351 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "attacks.h"
+#include "game_registry.h"
+#include "metrics.h"
+
+/*
+ * loadgen --port 8080 --games 16 --rounds 20
+ *
+ * Plays --games two-player games at once against a running server, --rounds
+ * games each, and prints throughput and latency percentiles per route. Every
+ * game goes startNew, join, both horcruxes, random legal moves until the game
+ * ends or --max-plies is reached, then end for both players. A local copy of
+ * the game picks the moves, so every move sent is one the server must accept.
+ * Start the server with STORAGE=memory to run it with no database.
+ */
+
+namespace {
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    unsigned games = 8;
+    unsigned rounds = 10;
+    int maxPlies = 200;
+    unsigned seed = 1;
+};
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--host" && hasValue) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && hasValue) {
+            options.port = argv[++i];
+        } else if (arg == "--games" && hasValue) {
+            options.games = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--rounds" && hasValue) {
+            options.rounds = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--max-plies" && hasValue) {
+            options.maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            std::exit(2);
+        }
+    }
+    if (options.games == 0) {
+        options.games = 1;
+    }
+    return options;
+}
+
+const char* const ROUTES[] = {"/game/startNew", "/game/join", "/game/select/horcrux", "/game/move", "/game/end"};
+
+struct RouteStats {
+    LatencyHistogram latency;
+    std::atomic<uint64_t> errors{0};
+};
+
+// Filled in before any worker starts, so workers only ever look routes up
+std::map<std::string, RouteStats> routeStats;
+
+
+/*
+ * One player's keep-alive HTTP/1.1 connection.
+ *
+ * Only what the server's responses need: Content-Length bodies and the
+ * cookies it sets, which are sent back on every later request.
+ */
+class HttpClient {
+    public:
+        struct Response {
+            int status;
+            std::string body;
+        };
+
+        HttpClient(const std::string& host, const std::string& port) : host_(host), port_(port) {};
+        ~HttpClient() {_close();}
+
+        HttpClient(const HttpClient&) = delete;
+        HttpClient& operator=(const HttpClient&) = delete;
+
+        // Times the request into its route's stats; a non-2xx status counts as an error
+        Response request(const char* method, const char* route, const std::string& body = "") {
+            RouteStats& stats = routeStats.at(route);
+            const auto start = std::chrono::steady_clock::now();
+            Response response{0, ""};
+            try {
+                response = _exchange(method, route, body);
+            } catch (const std::runtime_error&) {
+                // The server may have closed an idle connection; one fresh attempt
+                _close();
+                try {
+                    response = _exchange(method, route, body);
+                } catch (const std::runtime_error&) {
+                    _close();
+                }
+            }
+            stats.latency.record(std::chrono::steady_clock::now() - start);
+            if (response.status < 200 || response.status >= 300) {stats.errors++;}
+            return response;
+        }
+
+        const std::string& getCookie(const std::string& name) const {return cookies_.at(name);}
+        void clearCookies() {cookies_.clear();}
+
+    private:
+        Response _exchange(const char* method, const char* route, const std::string& body) {
+            if (fd_ < 0) {_connect();}
+
+            std::string request = std::string(method) + " " + route + " HTTP/1.1\r\nHost: " + host_ + "\r\n";
+            if (!cookies_.empty()) {
+                request += "Cookie: ";
+                for (const auto& [name, value] : cookies_) {
+                    request += name + "=" + value + "; ";
+                }
+                request.resize(request.size() - 2);
+                request += "\r\n";
+            }
+            request += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            _send(request);
+
+            size_t headerEnd;
+            while ((headerEnd = buffer_.find("\r\n\r\n")) == std::string::npos) {_receive();}
+            const std::string header = buffer_.substr(0, headerEnd);
+            buffer_.erase(0, headerEnd + 4);
+
+            Response response{0, ""};
+            size_t contentLength = 0;
+            size_t lineStart = 0;
+            while (lineStart < header.size()) {
+                size_t lineEnd = header.find("\r\n", lineStart);
+                if (lineEnd == std::string::npos) {lineEnd = header.size();}
+                const std::string line = header.substr(lineStart, lineEnd - lineStart);
+                lineStart = lineEnd + 2;
+
+                if (line.rfind("HTTP/", 0) == 0) {
+                    response.status = std::atoi(line.c_str() + line.find(' ') + 1);
+                } else if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) {
+                    contentLength = std::stoul(line.substr(15));
+                } else if (strncasecmp(line.c_str(), "Set-Cookie:", 11) == 0) {
+                    _storeCookie(line.substr(11));
+                }
+            }
+
+            while (buffer_.size() < contentLength) {_receive();}
+            response.body = buffer_.substr(0, contentLength);
+            buffer_.erase(0, contentLength);
+            return response;
+        }
+
+        // "gameID=abc; Path=/; HttpOnly" keeps gameID=abc
+        void _storeCookie(const std::string& value) {
+            const size_t start = value.find_first_not_of(' ');
+            const size_t equals = value.find('=', start);
+            if (start == std::string::npos || equals == std::string::npos) {return;}
+            const size_t end = value.find(';', equals);
+            cookies_[value.substr(start, equals - start)] = value.substr(equals + 1, end == std::string::npos ? std::string::npos : end - equals - 1);
+        }
+
+        void _connect() {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* addresses = nullptr;
+            if (getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addresses) != 0) {
+                throw std::runtime_error("Cannot resolve " + host_);
+            }
+            for (addrinfo* address = addresses; address; address = address->ai_next) {
+                fd_ = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+                if (fd_ < 0) {continue;}
+                if (::connect(fd_, address->ai_addr, address->ai_addrlen) == 0) {break;}
+                ::close(fd_);
+                fd_ = -1;
+            }
+            freeaddrinfo(addresses);
+            if (fd_ < 0) {
+                throw std::runtime_error("Cannot connect to " + host_ + ":" + port_);
+            }
+            // Requests are small and each waits for its answer, so Nagle would only add delay
+            const int noDelay = 1;
+            ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+
+        void _close() {
+            if (fd_ >= 0) {::close(fd_);}
+            fd_ = -1;
+            buffer_.clear();
+        }
+
+        void _send(const std::string& data) {
+            size_t sent = 0;
+            while (sent < data.size()) {
+                const ssize_t count = ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+                if (count <= 0) {throw std::runtime_error("Connection lost while sending");}
+                sent += static_cast<size_t>(count);
+            }
+        }
+
+        void _receive() {
+            char chunk[4096];
+            const ssize_t count = ::recv(fd_, chunk, sizeof(chunk), 0);
+            if (count <= 0) {throw std::runtime_error("Connection lost while receiving");}
+            buffer_.append(chunk, static_cast<size_t>(count));
+        }
+
+        const std::string host_;
+        const std::string port_;
+        int fd_ = -1;
+        std::string buffer_;
+        std::map<std::string, std::string> cookies_;
+};
+
+
+// "e,2" as the server's routes expect squares
+std::string squareText(int square) {
+    const Position position = toPosition(square);
+    return std::string(1, position.getFile()) + "," + std::to_string(position.getRank());
+}
+
+// Plays one game to its end or the ply limit. Returns false if the server turned a request down.
+bool playGame(HttpClient& white, HttpClient& black, std::mt19937& random, int maxPlies) {
+    white.clearCookies();
+    black.clearCookies();
+    if (white.request("GET", "/game/startNew").status != 200) {return false;}
+    const std::string gameID = white.getCookie("gameID");
+    if (black.request("POST", "/game/join", "{\"gameID\":\"" + gameID + "\"}").status != 200) {return false;}
+
+    // The local copy referees the moves, pieces keeping the same IDs as on the server
+    GameSession mirror(gameID, "white");
+    mirror.join("black");
+    bool isAccepted = true;
+
+    for (Color color : {Color::WHITE, Color::BLACK}) {
+        Player* pPlayer = mirror.getPlayer(color);
+        std::vector<int> squares;
+        Bitboard pieces = mirror.getGame().getBoard()->getOccupancy(color);
+        while (pieces) {squares.push_back(popLsb(pieces));}
+        const int square = squares[random() % squares.size()];
+
+        HttpClient& client = color == Color::WHITE ? white : black;
+        isAccepted = client.request("POST", "/game/select/horcrux", squareText(square)).status == 200;
+        if (!isAccepted) {break;}
+        mirror.selectHorcrux(pPlayer, mirror.getGame().getBoard()->getPiece(square)->getID());
+    }
+
+    const BoardRules rules;
+    for (int ply = 0; isAccepted && ply < maxPlies && mirror.getGameState() != GameState::ENDED; ++ply) {
+        const Board& board = *mirror.getGame().getBoard();
+        const Color side = board.getSideToMove();
+        MoveList moves;
+        rules.generateLegalMoves(board, side, moves);
+        std::vector<CompactMove> candidates(moves.begin(), moves.end());
+
+        // The game's own rules have the last word, so keep drawing until one is accepted
+        bool isMoved = false;
+        while (!candidates.empty() && !isMoved) {
+            const size_t pick = random() % candidates.size();
+            const CompactMove move = candidates[pick];
+            candidates.erase(candidates.begin() + static_cast<std::ptrdiff_t>(pick));
+            try {
+                mirror.movePiece(mirror.getPlayer(side), toPosition(move.getFrom()), toPosition(move.getTo()));
+                isMoved = true;
+            } catch (const std::logic_error&) {}
+            if (isMoved) {
+                HttpClient& client = side == Color::WHITE ? white : black;
+                isAccepted = client.request("POST", "/game/move", squareText(move.getFrom()) + ";" + squareText(move.getTo())).status == 200;
+            }
+        }
+        if (!isMoved) {break;}
+    }
+
+    white.request("GET", "/game/end");
+    black.request("GET", "/game/end");
+    return isAccepted;
+}
+
+void printReport(double seconds, unsigned gamesPlayed, unsigned gamesFailed) {
+    std::printf("%-24s %10s %8s %10s %10s %10s %10s\n", "route", "requests", "errors", "req/s", "p50 ms", "p99 ms", "p999 ms");
+    uint64_t totalRequests = 0;
+    for (const char* route : ROUTES) {
+        const RouteStats& stats = routeStats.at(route);
+        const HistogramSnapshot snapshot = stats.latency.getSnapshot();
+        totalRequests += snapshot.count;
+        std::printf("%-24s %10llu %8llu %10.1f %10.3f %10.3f %10.3f\n", route,
+                    static_cast<unsigned long long>(snapshot.count), static_cast<unsigned long long>(stats.errors.load()),
+                    snapshot.count / seconds, snapshot.quantileNanos(0.5) / 1e6, snapshot.quantileNanos(0.99) / 1e6,
+                    snapshot.quantileNanos(0.999) / 1e6);
+    }
+    std::printf("\n%llu requests in %.2f s, %.1f req/s; %u games played, %u cut short by an error\n",
+                static_cast<unsigned long long>(totalRequests), seconds, totalRequests / seconds, gamesPlayed, gamesFailed);
+    std::printf("Percentiles are bucket upper bounds, within 25%% of the true value\n");
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    const Options options = parseOptions(argc, argv);
+    rookAttacks(0, EMPTY_BITBOARD); // Build the slider tables before anything is timed
+    for (const char* route : ROUTES) {
+        routeStats[route];
+    }
+
+    std::atomic<unsigned> gamesPlayed{0};
+    std::atomic<unsigned> gamesFailed{0};
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < options.games; ++worker) {
+        workers.emplace_back([&options, &gamesPlayed, &gamesFailed, worker]() {
+            std::mt19937 random(options.seed + worker);
+            HttpClient white(options.host, options.port);
+            HttpClient black(options.host, options.port);
+            for (unsigned round = 0; round < options.rounds; ++round) {
+                try {
+                    if (!playGame(white, black, random, options.maxPlies)) {gamesFailed++;}
+                } catch (const std::exception&) {
+                    gamesFailed++;
+                }
+                gamesPlayed++;
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printReport(seconds, gamesPlayed, gamesFailed);
+    return gamesFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include "bitboard.h"
+#include "piece.h"
+
+/*
+ * Precomputed attack sets.
+ *
+ * Knight, king and pawn tables are generated at compile time. Sliding pieces use
+ * magic bitboards (or PEXT when the compiler targets BMI2), built once on first use.
+ */
+
+struct Offset {
+    int file;
+    int rank;
+};
+
+constexpr std::array<Offset, 8> KNIGHT_OFFSETS = {{
+    {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
+    {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
+}};
+
+constexpr std::array<Offset, 8> KING_OFFSETS = {{
+    {0, 1}, {0, -1}, {1, 0}, {-1, 0},
+    {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
+}};
+
+template<size_t N>
+constexpr Bitboard leaperAttacks(int square, const std::array<Offset, N>& offsets) {
+    Bitboard attacks = EMPTY_BITBOARD;
+    for (const Offset& offset : offsets) {
+        int file = fileOf(square) + offset.file;
+        int rank = rankOf(square) + offset.rank;
+        if (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            attacks |= squareBit(squareIndex(file, rank));
+        }
+    }
+    return attacks;
+}
+
+template<size_t N>
+constexpr std::array<Bitboard, NUMBER_OF_SQUARES> makeLeaperTable(const std::array<Offset, N>& offsets) {
+    std::array<Bitboard, NUMBER_OF_SQUARES> table{};
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        table[square] = leaperAttacks(square, offsets);
+    }
+    return table;
+}
+
+constexpr std::array<std::array<Bitboard, NUMBER_OF_SQUARES>, 2> makePawnAttackTable() {
+    std::array<std::array<Bitboard, NUMBER_OF_SQUARES>, 2> table{};
+    const std::array<Offset, 2> whiteCaptures = {{{-1, 1}, {1, 1}}};
+    const std::array<Offset, 2> blackCaptures = {{{-1, -1}, {1, -1}}};
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        table[static_cast<int>(Color::WHITE)][square] = leaperAttacks(square, whiteCaptures);
+        table[static_cast<int>(Color::BLACK)][square] = leaperAttacks(square, blackCaptures);
+    }
+    return table;
+}
+
+inline constexpr std::array<Bitboard, NUMBER_OF_SQUARES> KNIGHT_ATTACKS = makeLeaperTable(KNIGHT_OFFSETS);
+inline constexpr std::array<Bitboard, NUMBER_OF_SQUARES> KING_ATTACKS = makeLeaperTable(KING_OFFSETS);
+inline constexpr std::array<std::array<Bitboard, NUMBER_OF_SQUARES>, 2> PAWN_ATTACKS = makePawnAttackTable();
+
+inline Bitboard knightAttacks(int square) {return KNIGHT_ATTACKS[square];}
+inline Bitboard kingAttacks(int square) {return KING_ATTACKS[square];}
+
+// Squares a pawn of the given color on `square` captures on
+inline Bitboard pawnAttacks(Color color, int square) {return PAWN_ATTACKS[static_cast<int>(color)][square];}
+
+Bitboard rookAttacks(int square, Bitboard occupied);
+Bitboard bishopAttacks(int square, Bitboard occupied);
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+// Squares strictly between two aligned squares, empty if they share no rank, file or diagonal
+Bitboard betweenMask(int from, int to);
+// The full rank, file or diagonal through two aligned squares, empty if they are not aligned
+Bitboard lineMask(int from, int to);
+
+// Attacks of a non-pawn piece of the given type standing on `square`
+Bitboard pieceAttacks(PieceType type, int square, Bitboard occupied);
@@ -12,6 +12,7 @@ class Bishop : public IPiece {
 
         virtual bool isValidMove(const Move& move) const;
         virtual std::unordered_set<Position> getPossiblePositions(const Position& from) const;
+        virtual void getPossibleMoves(const Position& from, MoveList& moves) const override;
         virtual PieceType getType() const {return type_;}
         virtual Color getColor() const {return color_;}
         virtual int getID() const {return id_;}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include "position.h"
+
+#define NUMBER_OF_SQUARES 64
+#define NO_SQUARE -1
+
+// One bit per square, a1 = bit 0 ... h8 = bit 63
+using Bitboard = uint64_t;
+
+constexpr Bitboard EMPTY_BITBOARD = 0ULL;
+
+constexpr Bitboard squareBit(int square) {return 1ULL << square;}
+
+constexpr int squareIndex(int fileIndex, int rankIndex) {return rankIndex * 8 + fileIndex;}
+constexpr int fileOf(int square) {return square & 7;}
+constexpr int rankOf(int square) {return square >> 3;}
+
+inline bool isOnBoard(const Position& position) {
+    return position.getFile() >= 'a' && position.getFile() <= 'h' &&
+           position.getRank() >= 1 && position.getRank() <= 8;
+}
+
+// Returns NO_SQUARE for positions outside the board
+inline int toSquare(const Position& position) {
+    if (!isOnBoard(position)) {return NO_SQUARE;}
+    return squareIndex(position.getFile() - 'a', position.getRank() - 1);
+}
+
+inline Position toPosition(int square) {
+    return Position(static_cast<char>('a' + fileOf(square)), rankOf(square) + 1);
+}
+
+inline int popCount(Bitboard bb) {return __builtin_popcountll(bb);}
+
+// Index of the least significant set bit. bb must not be empty.
+inline int lsb(Bitboard bb) {return __builtin_ctzll(bb);}
+
+inline int popLsb(Bitboard& bb) {
+    int square = lsb(bb);
+    bb &= bb - 1;
+    return square;
+}
@@ -2,9 +2,36 @@
 
 #include "square.h"
 #include "piece.h"
+#include "bitboard.h"
+#include "move_list.h"
+#include "zobrist.h"
 #include <unordered_map>
+#include <array>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
+#include <vector>
+
+#define NUMBER_OF_COLORS 2
+#define NUMBER_OF_PIECE_TYPES 7
+#define INVALID_PIECE_ID 0
+#define MAX_PIECE_ID 32
+
+#define WHITE_KING_SIDE_CASTLE 0x1
+#define WHITE_QUEEN_SIDE_CASTLE 0x2
+#define BLACK_KING_SIDE_CASTLE 0x4
+#define BLACK_QUEEN_SIDE_CASTLE 0x8
+#define ALL_CASTLING_RIGHTS 0xF
+
+// Everything makeMove overwrites that unmakeMove cannot recompute
+struct UndoRecord {
+    const IPiece* captured;
+    PieceType capturedType;
+    int8_t capturedSquare;
+    int8_t enPassantSquare;
+    uint8_t castlingRights;
+    ZobristKey key;
+};
 
 
 class Board {
@@ -14,12 +41,16 @@ class Board {
         virtual ~Board() = default;
 
         friend class BoardRules;
+        friend class Square;
 
         virtual Board& operator=(const Board& other);
 
         virtual void placePiece(const Position& position, const IPiece* piece);
+        // Places a piece the board owns from now on, for boards built without a Game
+        void adoptPiece(const Position& position, std::unique_ptr<IPiece> piece);
         virtual void removePiece(Square* pSquare);
         virtual Square* getSquare(const Position& position) const;
+        // Looked up through the piece-ID index, so no scan for the IDs a game hands out
         virtual Square* findSquare(int pieceID) const;
 
         static bool isLightSquare(const Position& pos);
@@ -28,17 +59,65 @@ class Board {
         virtual const Position* findKing(Color color) const;
 
         virtual bool isAttackedPosition(const Position& position, const Color playerColor) const;
+        // Looks outward from `square` for an attacker of `byColor`, stopping at the first one found
+        bool isSquareAttacked(int square, Color byColor) const;
+        // Every piece of `byColor` attacking `square`, with sliders seeing through anything not in `occupied`
+        Bitboard getAttackers(int square, Color byColor, Bitboard occupied) const;
+
+        // Bitboard representation. Squares are indexed a1 = 0 ... h8 = 63.
+        const IPiece* getPiece(int square) const {return mailbox_[square];}
+        Bitboard getOccupancy() const {return colorBB_[0] | colorBB_[1];}
+        Bitboard getOccupancy(Color color) const {return colorBB_[static_cast<int>(color)];}
+        Bitboard getPieces(PieceType type) const {return typeBB_[static_cast<int>(type)];}
+        Bitboard getPieces(Color color, PieceType type) const {return getOccupancy(color) & getPieces(type);}
+        int getKingSquare(Color color) const;
+        // Type of the piece on `square` as the bitboards see it, which differs from the piece's own type after a promotion
+        PieceType getPieceType(int square) const;
+
+        uint8_t getCastlingRights() const {return castlingRights_;}
+        void setCastlingRights(uint8_t rights);
+        // Only set after a double push that an enemy pawn could capture, so it never splits otherwise equal positions
+        int getEnPassantSquare() const {return enPassantSquare_;}
+        void setEnPassantSquare(int square);
+        Color getSideToMove() const {return sideToMove_;}
+        void setSideToMove(Color color);
 
-        /* TODO: Move this to private*/
+        // Kept up to date by every change to the board
+        ZobristKey getZobristKey() const {return key_;}
+        // The same key built from scratch, for checking the incremental one
+        ZobristKey computeZobristKey() const;
+
+        // Applies a pseudo-legal move in place. Pass the returned record to unmakeMove to restore the position.
+        UndoRecord makeMove(CompactMove move);
+        void unmakeMove(CompactMove move, const UndoRecord& undo);
+        // Updates castling rights, the en passant square and the side to move for a move already applied through the square views
+        void recordMove(CompactMove move);
+
+        /* Compatibility view over the mailbox, kept in sync by the board. TODO: Move this to private*/
         std::unordered_map<Position, std::unique_ptr<Square>> squares;
 
     private:
+        void setPiece_(int square, const IPiece* piece);
+        void clearPiece_(int square);
+        void movePiece_(int from, int to);
+        void setPieceType_(int square, PieceType type);
+        void createSquares_();
+        void copyPieces_(const Board& other);
 
         bool isObstructed(const Position& from, const Position& to, PieceType pieceType) const;
-        bool isObstructedBetweenRank_(const Position& from, const Position& to) const;
-        bool isObstructedBetweenFile_(const Position& from, const Position& to) const;
-        bool isObstructedDiagonally_(const Position& from, const Position& to) const;
-        
+
         bool isInsideBoard_(const Position& position) const;
-        std::unordered_set<Position> getAttackedPositions_(Color color) const;
+        static bool isIndexedID_(int pieceID) {return pieceID > INVALID_PIECE_ID && pieceID <= MAX_PIECE_ID;}
+
+        std::array<const IPiece*, NUMBER_OF_SQUARES> mailbox_{};
+        std::array<Square*, NUMBER_OF_SQUARES> squareViews_{};
+        std::array<int8_t, MAX_PIECE_ID + 1> pieceSquares_{}; // Piece ID -> square, NO_SQUARE when off the board
+        Bitboard colorBB_[NUMBER_OF_COLORS] = {};
+        Bitboard typeBB_[NUMBER_OF_PIECE_TYPES] = {};
+        uint8_t castlingRights_ = ALL_CASTLING_RIGHTS;
+        int enPassantSquare_ = NO_SQUARE;
+        Color sideToMove_ = Color::WHITE;
+        ZobristKey key_ = ZOBRIST.castling[ALL_CASTLING_RIGHTS];
+
+        std::vector<std::unique_ptr<IPiece>> ownedPieces_; // Clones made when copying another board, and adopted pieces
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+#include "game_event_log.h"
+
+#define BOARD_DIFF_CAPACITY 64 // Power of two
+
+// What one version of a game changed: the squares whose piece changed and the kind of change
+struct BoardDiff {
+    uint64_t version;
+    Bitboard squares;
+    GameEventType type;
+};
+
+/*
+ * The most recent changes of one game, so a client that is only a few versions behind
+ * can be sent the squares that changed instead of the whole board. Versions are pushed
+ * one after another; anything older than the ring, or than the last reset, is gone.
+ */
+class BoardDiffRing {
+    public:
+        BoardDiffRing() : baseVersion_(0), size_(0) {};
+
+        // Starts over at `version`, e.g. once the whole board has been set up anew
+        void reset(uint64_t version) {
+            baseVersion_ = version;
+            size_ = 0;
+        }
+
+        // Records the next version
+        void push(Bitboard squares, GameEventType type) {
+            size_++;
+            entries_[(baseVersion_ + size_) & (BOARD_DIFF_CAPACITY - 1)] = {baseVersion_ + size_, squares, type};
+        }
+
+        uint64_t getVersion() const {return baseVersion_ + size_;}
+
+        // Adds every change after `since` to `squares` and `diffs`. Returns false, touching
+        // neither, if those changes are no longer all in the ring.
+        bool collect(uint64_t since, Bitboard& squares, std::vector<BoardDiff>& diffs) const {
+            const uint64_t oldest = getVersion() - std::min<uint64_t>(size_, BOARD_DIFF_CAPACITY);
+            if (since < oldest || since > getVersion()) {return false;}
+
+            for (uint64_t version = since + 1; version <= getVersion(); ++version) {
+                const BoardDiff& diff = entries_[version & (BOARD_DIFF_CAPACITY - 1)];
+                squares |= diff.squares;
+                diffs.push_back(diff);
+            }
+            return true;
+        }
+
+    private:
+        std::array<BoardDiff, BOARD_DIFF_CAPACITY> entries_;
+        uint64_t baseVersion_;
+        uint64_t size_;
+};
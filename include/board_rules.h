@@ -4,6 +4,7 @@
 #include "king.h"
 #include "player.h"
 #include "board.h"
+#include "move_list.h"
 #include <unordered_set>
 #include <unordered_map>
 
@@ -18,11 +19,17 @@ class BoardRules {
         virtual bool isValidEnPassant(const Move& previousMove, const Move& move) const;
         virtual bool isValidPromotion(const Move& move) const;
         
-        virtual std::unordered_set<Position> generateValidPositions(const Board& board, const IPiece* piece, const Position& from, const Move& previousMove);
+        virtual std::unordered_set<Position> generateValidPositions(const Board& board, const Position& from, const Move& previousMove);
+        virtual void generateValidMoves(const Board& board, const Position& from, const Move& previousMove, MoveList& moves);
+        // Every legal move for `side`, using the board's own en passant square and castling rights
+        virtual void generateLegalMoves(const Board& board, Color side, MoveList& moves) const;
+        // Stops at the first legal move found instead of listing them all
+        virtual bool hasLegalMove(const Board& board, Color side) const;
 
     private:
-        void _availablePositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& position, const Move& previousMove);
-        void _addKingCastlingPositions(const Board& board, std::unordered_set<Position>& possiblePositions, const King* king, const Position& from) const;
-        void _addPawnCapturePositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& from, const Move& previousMove) const;
-        void _removeKingInCheckPositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& from); 
+        void _generateLegalMoves(const Board& board, Color side, int enPassantSquare, Bitboard fromMask, MoveList& moves) const;
+        void _addPawnMoves(const Board& board, Color side, int from, int enPassantSquare, Bitboard legalMask, MoveList& moves) const;
+        Bitboard _pinnedPieces(const Board& board, Color side, int kingSquare) const;
+        bool _canCastle(const Board& board, Color color, bool isKingSide) const;
+        int _enPassantSquare(const Board& board, const Move& previousMove) const;
 };
\ No newline at end of file
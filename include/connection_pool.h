@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct PoolStats {
+    size_t capacity;
+    size_t open;            // Connections currently established, idle or leased
+    size_t inUse;
+    uint64_t acquisitions;
+    uint64_t timeouts;
+    uint64_t reconnects;    // Connections replaced after a failed health check or an invalidated lease
+    uint64_t totalWaitMicros;
+    uint64_t maxWaitMicros;
+};
+
+
+/*
+ * Bounded pool of database connections.
+ *
+ * Connections are opened lazily up to `capacity`. A connection that has sat idle
+ * longer than the health check interval is checked before it is handed out, and
+ * replaced if the check fails. Callers hold a Lease for the duration of one request.
+ */
+template<typename Connection>
+class ConnectionPool {
+    public:
+        using Factory = std::function<std::unique_ptr<Connection>()>;
+        using HealthCheck = std::function<bool(Connection&)>;
+        using Clock = std::chrono::steady_clock;
+
+        // Returns its connection to the pool when it goes out of scope
+        class Lease {
+            public:
+                Lease(ConnectionPool* pool, std::unique_ptr<Connection> connection)
+                    : pool_(pool), connection_(std::move(connection)) {};
+                Lease(Lease&& other) noexcept : pool_(other.pool_), connection_(std::move(other.connection_)) {
+                    other.pool_ = nullptr;
+                }
+                Lease& operator=(Lease&& other) = delete;
+                Lease(const Lease&) = delete;
+                ~Lease() {if (pool_) {pool_->_release(std::move(connection_));}}
+
+                Connection* get() const {return connection_.get();}
+                Connection* operator->() const {return connection_.get();}
+                Connection& operator*() const {return *connection_;}
+
+                // Drops a connection that broke mid-request so the pool opens a fresh one next time
+                void invalidate() {
+                    if (connection_) {
+                        connection_.reset();
+                        pool_->_countReconnect();
+                    }
+                }
+
+            private:
+                ConnectionPool* pool_;
+                std::unique_ptr<Connection> connection_;
+        };
+
+        ConnectionPool(size_t capacity, Factory connect, HealthCheck isHealthy,
+                       std::chrono::milliseconds acquireTimeout = std::chrono::milliseconds(2000),
+                       std::chrono::milliseconds healthCheckInterval = std::chrono::milliseconds(30000))
+            : capacity_(capacity), connect_(std::move(connect)), isHealthy_(std::move(isHealthy)),
+              acquireTimeout_(acquireTimeout), healthCheckInterval_(healthCheckInterval) {
+            if (capacity_ == 0) {
+                throw std::logic_error("Connection pool needs at least one connection");
+            }
+        }
+
+        ConnectionPool(const ConnectionPool&) = delete;
+        ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+        // Blocks until a connection is free, throwing std::runtime_error once the timeout expires
+        Lease acquire() {
+            const Clock::time_point start = Clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            const bool isAvailable = available_.wait_until(lock, start + acquireTimeout_, [this]() {
+                return !idle_.empty() || open_ < capacity_;
+            });
+            const uint64_t waitMicros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+            stats_.totalWaitMicros += waitMicros;
+            stats_.maxWaitMicros = std::max(stats_.maxWaitMicros, waitMicros);
+
+            if (!isAvailable) {
+                stats_.timeouts++;
+                throw std::runtime_error("Timed out waiting for a database connection");
+            }
+
+            IdleConnection idle;
+            if (!idle_.empty()) {
+                idle = std::move(idle_.back());
+                idle_.pop_back();
+            }
+            // The slot is taken before connecting so other threads cannot overshoot the capacity
+            if (!idle.connection) {open_++;}
+            inUse_++;
+            stats_.acquisitions++;
+            lock.unlock();
+
+            try {
+                if (idle.connection && Clock::now() - idle.lastUsed > healthCheckInterval_ && !isHealthy_(*idle.connection)) {
+                    idle.connection.reset();
+                    _countReconnect();
+                }
+                if (!idle.connection) {
+                    idle.connection = connect_();
+                }
+            } catch (...) {
+                _release(nullptr);
+                throw;
+            }
+            return Lease(this, std::move(idle.connection));
+        }
+
+        PoolStats getStats() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            PoolStats stats = stats_;
+            stats.capacity = capacity_;
+            stats.open = open_;
+            stats.inUse = inUse_;
+            return stats;
+        }
+
+    private:
+        struct IdleConnection {
+            std::unique_ptr<Connection> connection;
+            Clock::time_point lastUsed;
+        };
+
+        void _release(std::unique_ptr<Connection> connection) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                inUse_--;
+                if (connection) {
+                    idle_.push_back(IdleConnection{std::move(connection), Clock::now()});
+                } else {
+                    open_--;
+                }
+            }
+            available_.notify_one();
+        }
+
+        void _countReconnect() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.reconnects++;
+        }
+
+        const size_t capacity_;
+        Factory connect_;
+        HealthCheck isHealthy_;
+        const std::chrono::milliseconds acquireTimeout_;
+        const std::chrono::milliseconds healthCheckInterval_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable available_;
+        std::vector<IdleConnection> idle_;
+        size_t open_ = 0;
+        size_t inUse_ = 0;
+        PoolStats stats_{};
+};
+
+
+// Prometheus text exposition of the pool's gauges and counters, under the given metric prefix
+inline void writePoolMetrics(std::ostream& out, const std::string& prefix, const PoolStats& stats) {
+    out << "# TYPE " << prefix << "_capacity gauge\n" << prefix << "_capacity " << stats.capacity << "\n"
+        << "# TYPE " << prefix << "_open gauge\n" << prefix << "_open " << stats.open << "\n"
+        << "# TYPE " << prefix << "_in_use gauge\n" << prefix << "_in_use " << stats.inUse << "\n"
+        << "# TYPE " << prefix << "_acquisitions_total counter\n" << prefix << "_acquisitions_total " << stats.acquisitions << "\n"
+        << "# TYPE " << prefix << "_timeouts_total counter\n" << prefix << "_timeouts_total " << stats.timeouts << "\n"
+        << "# TYPE " << prefix << "_reconnects_total counter\n" << prefix << "_reconnects_total " << stats.reconnects << "\n"
+        << "# TYPE " << prefix << "_wait_seconds_total counter\n" << prefix << "_wait_seconds_total " << stats.totalWaitMicros / 1e6 << "\n"
+        << "# TYPE " << prefix << "_wait_seconds_max gauge\n" << prefix << "_wait_seconds_max " << stats.maxWaitMicros / 1e6 << "\n";
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "crow/logging.h"
+#include "logger.h"
+
+// Sends Crow's own messages through the asynchronous logger instead of straight to stderr
+class CrowLogHandler : public crow::ILogHandler {
+    public:
+        void log(std::string message, crow::LogLevel level) override {
+            switch (level) {
+                case crow::LogLevel::Debug: CHESS_LOG_DEBUG(message, {{"source", "crow"}}); break;
+                case crow::LogLevel::Info: CHESS_LOG_INFO(message, {{"source", "crow"}}); break;
+                case crow::LogLevel::Warning: CHESS_LOG_WARNING(message, {{"source", "crow"}}); break;
+                default: CHESS_LOG_ERROR(message, {{"source", "crow"}}); break;
+            }
+        }
+};
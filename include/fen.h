@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include "board.h"
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+/*
+ * Forsyth-Edwards Notation.
+ *
+ * loadFen places freshly created pieces on an empty board, which takes ownership of them,
+ * and sets its castling rights and en passant square. Piece IDs are handed out in board
+ * order from MIN_WHITE_HORCRUXE_ID and MIN_BLACK_HORCRUXE_ID. The move counters are ignored
+ * when loading; the board does not track them, so toFen writes whatever it is given.
+ */
+
+// Returns the side to move. Throws std::logic_error on malformed input.
+Color loadFen(Board& board, const std::string& fen);
+std::string toFen(const Board& board, Color sideToMove, int halfmoveClock = 0, int fullmoveNumber = 1);
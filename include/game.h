@@ -3,6 +3,8 @@
 #include "board_rules.h"
 #include "move.h"
 #include "player.h"
+#include "position_history.h"
+#include "game_snapshot.h"
 #include <set>
 
 enum class GameState {
@@ -38,12 +40,22 @@ public:
     virtual const Player* getCurrentPlayer() const {return pCurrentPlayer_;}
     virtual Board* getBoard() const {return board_;}
     virtual GameEndType getGameResult();
-    virtual std::unordered_set<Position> getAvailablePositions(IPiece* piece, const Position& from);
+    virtual std::unordered_set<Position> getAvailablePositions(const IPiece* piece, const Position& from);
+    // Every legal move for `side` in one pass, instead of one getAvailablePositions per piece
+    virtual void getLegalMoves(Color side, MoveList& moves) const {boardRules_->generateLegalMoves(*board_, side, moves);}
     virtual const IPiece* getPieceFromID(int id) {return pieceMap.at(id);}
     virtual const IPiece* getPieceFromPosition(const Position& position) {
-        return board_->getSquare(position)->getPiece();
+        const Square* pSquare = board_->getSquare(position);
+        return pSquare ? pSquare->getPiece() : nullptr;
     }
     virtual bool isKingCaptured(Color kingColor) const;
+    // Zobrist key of the current position, side to move included
+    virtual ZobristKey getPositionKey() const {return board_->getZobristKey();}
+
+    // Only valid once the game has started
+    virtual GameSnapshot takeSnapshot() const;
+    // Puts a freshly started game into the snapshot's position, pieces keeping their IDs
+    virtual void restoreSnapshot(const GameSnapshot& snapshot);
 
     virtual bool horcruxGuess(const int guessedHorcruxID, Player* guessingPlayer, Player* playerToCheck);
     virtual bool checkHorcruxSet();
@@ -60,11 +72,13 @@ protected:
     virtual void _updateGameState();
     virtual bool _isHorcruxGuessed(const int horcruxID, const Player* pPlayer) const;
     virtual bool _isHorcruxCaptured(const int horcruxID) const;
+    virtual bool _isCheckmate() const;
     virtual bool _isStalemate() const;
     virtual bool _hasInsufficientMaterial() const;
-    //void _isThreefoldRepetition() const;
-    //void _isFifyMoveRule() const;
-    //std::vector<MoveRecord> moveHistory_;
+    virtual bool _isThreefoldRepetition() const;
+    virtual bool _isFiftyMoveRule() const;
+    void _clearBoard();
+    PositionHistory history_;
 
     void _cleanupPieces() {
         for (auto& id_piece_pair : pieceMap) {
@@ -85,4 +99,5 @@ private:
     BoardRules* boardRules_;
     GameState gameState_;
     GameEndType gameEndType_;
+    uint16_t fullmoveNumber_ = 1;
 };
\ No newline at end of file
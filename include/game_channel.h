@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Subscribers watching each game, so changes can be pushed rather than polled.
+ *
+ * A subscriber is identified by an opaque key, in practice its WebSocket connection.
+ * Messages are handed to the subscribers' send functions while the channel is locked,
+ * so once unsubscribe returns no send to that subscriber is in flight; send functions
+ * must therefore only queue the message, never block on the network.
+ */
+class GameChannel {
+    public:
+        using Send = std::function<void(const std::string& message)>;
+
+        void subscribe(const std::string& gameID, const void* subscriber, Send send);
+        void unsubscribe(const void* subscriber);
+
+        // Returns how many subscribers the message went to
+        size_t publish(const std::string& gameID, const std::string& message) const;
+        size_t getSubscriberCount() const;
+
+    private:
+        struct Subscription {
+            const void* subscriber;
+            Send send;
+        };
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::vector<Subscription>> games_;
+        std::unordered_map<const void*, std::string> gameOf_;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "game_snapshot.h"
+#include "move_list.h"
+
+enum class GameEventType : uint8_t {
+    CREATED = 1,        // White player ID
+    JOINED = 2,         // Black player ID
+    HORCRUX_SET = 3,    // Color, horcrux ID
+    MOVE = 4,           // CompactMove, little-endian. Always QUIET: Game leaves a pawn on the last rank a pawn,
+                        // so there is no promotion to record; the flag bits are there for when it can promote
+    HORCRUX_GUESS = 5,  // Guessing color, guessed piece ID
+    SNAPSHOT = 6        // SnapshotBytes
+};
+
+struct GameEvent {
+    GameEventType type;
+    std::string payload;
+};
+
+
+/*
+ * Append-only log of one game, the durable form of a game.
+ *
+ * Every record is a type byte, a length byte and the payload, so a move costs four
+ * bytes on disk. A snapshot is appended every so often; recovery restores the last
+ * one and replays only what follows it. Appends only reach the disk at sync(),
+ * which the session calls once per request, before the change is acknowledged.
+ */
+class GameEventLog {
+    public:
+        // Opens the log for appending, creating it if needed
+        explicit GameEventLog(const std::string& path);
+        ~GameEventLog();
+
+        GameEventLog(const GameEventLog&) = delete;
+        GameEventLog& operator=(const GameEventLog&) = delete;
+
+        void appendCreated(const std::string& whitePlayerID);
+        void appendJoined(const std::string& blackPlayerID);
+        void appendHorcruxSet(Color color, int horcruxID);
+        void appendMove(CompactMove move);
+        void appendHorcruxGuess(Color guessingColor, int pieceID);
+        void appendSnapshot(const GameSnapshot& snapshot);
+        // Returns once everything appended so far is on disk
+        void sync();
+
+        // Game events appended since the last snapshot, counting the ones read back on recovery
+        size_t getEventsSinceSnapshot() const {return eventsSinceSnapshot_;}
+        void setEventsSinceSnapshot(size_t count) {eventsSinceSnapshot_ = count;}
+
+        const std::string& getPath() const {return path_;}
+
+        // Every complete record in the file. A record cut short by a crash ends the log.
+        static std::vector<GameEvent> read(const std::string& path);
+
+    private:
+        void _append(GameEventType type, const std::string& payload);
+
+        std::string path_;
+        int fd_;
+        size_t eventsSinceSnapshot_ = 0;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "game.h"
+#include "board_diff_ring.h"
+#include "game_event_log.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#define REGISTRY_SHARDS 16
+#define GAME_SNAPSHOT_INTERVAL 32
+
+/*
+ * A live game together with the board, rules and players it points to.
+ *
+ * With a log attached, every change made through the session is appended to it
+ * once it has succeeded, and a snapshot follows every `snapshotInterval` changes.
+ * Every change also bumps the session's version and wakes whoever is watching it.
+ * Like the rest of the session, versions and watches are guarded by its mutex.
+ */
+class GameSession {
+    public:
+        GameSession(const std::string& gameID, const std::string& whitePlayerID,
+                    std::unique_ptr<GameEventLog> log = nullptr, size_t snapshotInterval = GAME_SNAPSHOT_INTERVAL);
+
+        const std::string& getGameID() const {return gameID_;}
+        // Seats the black player and starts the game
+        void join(const std::string& blackPlayerID);
+        bool isJoined() const {return !blackPlayerID_.empty();}
+
+        // Player sitting in the seat the ID was handed out for, nullptr for a stranger
+        Player* findPlayer(const std::string& playerID);
+        Player* getOpponent(const Player* pPlayer);
+        Player* getPlayer(Color color) {return (color == Color::WHITE) ? &whitePlayer_ : &blackPlayer_;}
+        Game& getGame() {return game_;}
+        const Game& getGame() const {return game_;}
+        // Reports WAITING_FOR_OPPONENT until the black player joins
+        GameState getGameState() const;
+
+        // Returns whether both horcruxes are now set
+        bool selectHorcrux(Player* pPlayer, int horcruxID);
+        void movePiece(Player* pPlayer, const Position& from, const Position& to);
+        // Returns whether the guess was right
+        bool guessHorcrux(Player* pPlayer, int pieceID);
+
+        // Counts the changes made so far, so a client can tell whether what it holds is current
+        uint64_t getVersion() const {return version_;}
+        // Calls `onChange` once, on the next change, with the mutex held. Returns an ID for unwatch.
+        uint64_t watch(std::function<void()> onChange);
+        void unwatch(uint64_t watchID);
+        // Recent changes by version, for clients catching up on the board
+        const BoardDiffRing& getDiffs() const {return diffs_;}
+        // Puts the started game into the snapshot's position, as one change
+        void restore(const GameSnapshot& snapshot);
+
+        // Starts logging changes from here on; used once a recovered game has been replayed
+        void attachLog(std::unique_ptr<GameEventLog> log) {log_ = std::move(log);}
+        GameEventLog* getLog() const {return log_.get();}
+
+        // Held by every request that reads or changes the game
+        std::mutex& getMutex() {return mutex_;}
+
+    private:
+        // Appends a snapshot if one is due, then syncs the log; once per logged request
+        void _commitLog();
+        void _changed(GameEventType type, Bitboard squares);
+
+        std::string gameID_;
+        std::string whitePlayerID_;
+        std::string blackPlayerID_;
+
+        // Declared before game_ so they outlive it
+        Board board_;
+        BoardRules boardRules_;
+        Player whitePlayer_;
+        Player blackPlayer_;
+        Game game_;
+
+        std::unique_ptr<GameEventLog> log_;
+        const size_t snapshotInterval_;
+
+        uint64_t version_ = 0;
+        BoardDiffRing diffs_;
+        uint64_t nextWatchID_ = 0;
+        std::unordered_map<uint64_t, std::function<void()>> watchers_;
+
+        std::mutex mutex_;
+};
+
+
+/*
+ * Every live game, keyed by game ID. The map is split into shards so lookups of different games rarely contend.
+ *
+ * Given a log directory, each game is logged to `<directory>/<gameID>.log` and
+ * recover() rebuilds the games found there after a restart.
+ */
+class GameRegistry {
+    public:
+        explicit GameRegistry(const std::string& logDirectory = "", size_t snapshotInterval = GAME_SNAPSHOT_INTERVAL)
+            : logDirectory_(logDirectory), snapshotInterval_(snapshotInterval) {};
+
+        std::shared_ptr<GameSession> create(const std::string& gameID, const std::string& whitePlayerID);
+        // nullptr if no such game is live
+        std::shared_ptr<GameSession> find(const std::string& gameID) const;
+        bool remove(const std::string& gameID);
+        size_t size() const;
+
+        // Replays every log in the log directory, returning how many games came back.
+        // Logs that cannot be replayed are reported and left where they are.
+        size_t recover();
+
+    private:
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<std::string, std::shared_ptr<GameSession>> games;
+        };
+
+        Shard& _shardFor(const std::string& gameID);
+        const Shard& _shardFor(const std::string& gameID) const;
+        std::string _logPath(const std::string& gameID) const;
+        std::shared_ptr<GameSession> _replay(const std::string& gameID, const std::string& path) const;
+
+        const std::string logDirectory_;
+        const size_t snapshotInterval_;
+        std::array<Shard, REGISTRY_SHARDS> shards_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "player.h"
+
+#define NUMBER_OF_PIECES 32
+#define CAPTURED_SQUARE 0xFF
+
+struct PlayerSnapshot {
+    uint8_t horcruxID;
+    uint8_t horcruxGuessesLeft;
+    bool horcruxFound;
+    bool horcruxCaptured;
+    bool kingCaptured;
+
+    bool operator==(const PlayerSnapshot& other) const {
+        return horcruxID == other.horcruxID && horcruxGuessesLeft == other.horcruxGuessesLeft &&
+               horcruxFound == other.horcruxFound && horcruxCaptured == other.horcruxCaptured &&
+               kingCaptured == other.kingCaptured;
+    }
+};
+
+// Everything needed to rebuild a started game without replaying its moves
+struct GameSnapshot {
+    std::array<uint8_t, NUMBER_OF_PIECES> pieceSquares; // Indexed by piece ID - 1, CAPTURED_SQUARE once taken
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    uint8_t sideToMove;         // Color
+    uint8_t gameState;          // GameState
+    uint8_t gameEndType;        // GameEndType, meaningful once the game has ended
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;    // Starts at 1 and goes up after each black move
+    std::array<PlayerSnapshot, 2> players; // Indexed by Color
+
+    bool operator==(const GameSnapshot& other) const {
+        return pieceSquares == other.pieceSquares && castlingRights == other.castlingRights &&
+               enPassantSquare == other.enPassantSquare && sideToMove == other.sideToMove &&
+               gameState == other.gameState && gameEndType == other.gameEndType &&
+               halfmoveClock == other.halfmoveClock && fullmoveNumber == other.fullmoveNumber &&
+               players == other.players;
+    }
+};
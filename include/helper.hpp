@@ -1,11 +1,26 @@
 #include "game.h"
+#include "game_registry.h"
+#include "game_channel.h"
+#include "logger.h"
+#include "metrics.h"
+#include "tracing.h"
 #include "crow.h"
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <functional>
 #include <sstream>
 #include <uuid/uuid.h>
 #include <nlohmann/json.hpp>
 
+#include "write_behind_queue.h"
+
 using json = nlohmann::json;
 
+#define ERROR_STATUS -1
+#define LONG_POLL_TIMEOUT_SECONDS 25
+
 /* Helper Function Definitions */
 enum class MoveStatus {
     INVALID,
@@ -13,7 +28,6 @@ enum class MoveStatus {
 };
 
 int GameStateToInt(GameState state) {
-    std::cout << "Game State: " << int(state) << std::endl;
     switch (state) {
         case GameState::WAITING_FOR_OPPONENT:
             return static_cast<int>(GameState::WAITING_FOR_OPPONENT);
@@ -70,40 +84,31 @@ std::string generatePlayerToken() {
     return uuidToString(cookie);
 }
 
-void createGame(sql::Connection* con, const std::string& gameID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("INSERT INTO games(id, state) VALUES (?, ?)"));
-        pstmt->setString(1, gameID);
-        pstmt->setInt(2, static_cast<int>(GameState::WAITING_FOR_OPPONENT));
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error creating game: " << e.what() << std::endl;
-        throw;
-    }
+// Latency a request sees from one persistence helper, labelled by the helper's name
+LatencyHistogram& dbCallDuration(const std::string& call) {
+    return MetricsRegistry::global().histogram("db_call_duration_seconds", "call=\"" + call + "\"");
 }
 
-void createPlayer(sql::Connection* con, const std::string& playerID, Color color) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("INSERT INTO players(id, color) VALUES (?, ?)"));
-        pstmt->setString(1, playerID);
-        pstmt->setInt(2, static_cast<int>(color));
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error creating player: " << e.what() << std::endl;
-        throw;
-    }
+// The persistence helpers only enqueue; the write-behind queue commits them to MySQL in batches
+void createGame(WriteBehindQueue& persistence, const std::string& gameID) {
+    TraceSpan span("createGame");
+    static LatencyHistogram& duration = dbCallDuration("createGame");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::CREATE_GAME, gameID, "", static_cast<int>(GameState::WAITING_FOR_OPPONENT)});
 }
 
-void updateGameState(sql::Connection* con, const std::string& gameID, GameState state) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("UPDATE games SET state = ? WHERE id = ?"));
-        pstmt->setInt(1, static_cast<int>(state));
-        pstmt->setString(2, gameID);
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error updating game state: " << e.what() << std::endl;
-        throw;
-    }
+void createPlayer(WriteBehindQueue& persistence, const std::string& playerID, Color color) {
+    TraceSpan span("createPlayer");
+    static LatencyHistogram& duration = dbCallDuration("createPlayer");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::CREATE_PLAYER, "", playerID, static_cast<int>(color)});
+}
+
+void updateGameState(WriteBehindQueue& persistence, const std::string& gameID, GameState state) {
+    TraceSpan span("updateGameState");
+    static LatencyHistogram& duration = dbCallDuration("updateGameState");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::GAME_STATE, gameID, "", static_cast<int>(state)});
 }
 
 std::string generateGameID() {
@@ -112,22 +117,6 @@ std::string generateGameID() {
     return uuidToString(gameID);
 }
 
-bool validateGame(sql::Connection* con, const std::string& gameID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("SELECT COUNT(*) AS count FROM games WHERE id = ?"));
-        pstmt->setString(1, gameID);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-        if (res->next()) {
-            return res->getInt("count") > 0;
-        }
-        return false;
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error validating game: " << e.what() << std::endl;
-        throw;
-    }
-}
-
 void validateJsonFields(const json& j, const std::initializer_list<std::string>& fields) {
     for (const auto& field : fields) {
         if (!j.contains(field)) {
@@ -136,69 +125,37 @@ void validateJsonFields(const json& j, const std::initializer_list<std::string>&
     }
 }
 
-std::shared_ptr<Player> findPlayer(sql::Connection* con, const std::string& playerID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("SELECT * FROM players WHERE id = ?"));
-        pstmt->setString(1, playerID);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-        if (res->next()) {
-            // Construct player object from database data
-            return std::make_shared<Player>(res);
-        } else {
-            throw std::runtime_error("Player not found");
-        }
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error finding player: " << e.what() << std::endl;
-        throw;
+// Live game the request's cookie points at
+std::shared_ptr<GameSession> findGame(const GameRegistry& registry, const std::string& gameID) {
+    TraceSpan span("findGame");
+    auto pSession = registry.find(gameID);
+    if (!pSession) {
+        throw std::runtime_error("Game not found");
     }
+    return pSession;
 }
 
-std::shared_ptr<Game> findGame(sql::Connection* con, const std::string& gameID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("SELECT * FROM games WHERE id = ?"));
-        pstmt->setString(1, gameID);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-        if (res->next()) {
-            // Construct game from database result
-            return std::make_shared<Game>(res);
-        } else {
-            throw std::runtime_error("Game not found");
-        }
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error finding game: " << e.what() << std::endl;
-        throw;
+Player* findPlayer(GameSession& session, const std::string& playerID) {
+    TraceSpan span("findPlayer");
+    Player* pPlayer = session.findPlayer(playerID);
+    if (!pPlayer) {
+        throw std::runtime_error("Player not found");
     }
+    return pPlayer;
 }
 
-std::unique_ptr<Game> initializeGame(std::shared_ptr<Player> whitePlayer, std::shared_ptr<Player> blackPlayer) {
-    // Assume this method now initializes a game object based on player info and possibly existing game states.
-    auto pGame = std::make_unique<Game>(whitePlayer, blackPlayer);
-    pGame->startGame();  // This method should be designed to handle game initialization logic.
-    return pGame;
-}
-
-void removePlayer(sql::Connection* con, const std::string& playerID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("DELETE FROM players WHERE id = ?"));
-        pstmt->setString(1, playerID);
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error removing player: " << e.what() << std::endl;
-        throw;
-    }
+void removePlayer(WriteBehindQueue& persistence, const std::string& playerID) {
+    TraceSpan span("removePlayer");
+    static LatencyHistogram& duration = dbCallDuration("removePlayer");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::REMOVE_PLAYER, "", playerID, 0});
 }
 
-void killGame(sql::Connection* con, const std::string& gameID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("DELETE FROM games WHERE id = ?"));
-        pstmt->setString(1, gameID);
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error killing game: " << e.what() << std::endl;
-        throw;
-    }
+void killGame(WriteBehindQueue& persistence, const std::string& gameID) {
+    TraceSpan span("killGame");
+    static LatencyHistogram& duration = dbCallDuration("killGame");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::KILL_GAME, gameID, "", 0});
 }
 
 std::pair<char, int> parseFileAndRank(const std::string& input) {
@@ -213,12 +170,17 @@ std::pair<char, int> parseFileAndRank(const std::string& input) {
     }
 
     char file = fileStr.length() == 1 ? fileStr[0] : throw std::invalid_argument("Invalid file character");
-    int rank = std::stoi(rankStr); // This might throw std::invalid_argument if conversion fails
+    int rank = rankStr.length() == 1 ? rankStr[0] - '0' : throw std::invalid_argument("Invalid rank");
 
+    // Everything past here looks squares up on the board, which has nothing off it
+    if (!isOnBoard(Position(file, rank))) {
+        throw std::invalid_argument("Square is not on the board");
+    }
     return {file, rank};
 }
 
 crow::response createErrorResponse(const std::exception& e) {
+    CHESS_LOG_WARNING("Request failed", {{"error", e.what()}});
     json status;
     status["status"] = ERROR_STATUS;
     status["message"] = e.what();
@@ -228,14 +190,237 @@ crow::response createErrorResponse(const std::exception& e) {
     return response;
 }
 
-void updatePlayerHorcrux(sql::Connection* con, const std::string& playerID, int horcruxID) {
-    try {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("UPDATE players SET horcrux_id = ? WHERE id = ?"));
-        pstmt->setInt(1, horcruxID);
-        pstmt->setString(2, playerID);
-        pstmt->execute();
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error updating player's horcrux: " << e.what() << std::endl;
-        throw;
+void updatePlayerHorcrux(WriteBehindQueue& persistence, const std::string& playerID, int horcruxID) {
+    TraceSpan span("updatePlayerHorcrux");
+    static LatencyHistogram& duration = dbCallDuration("updatePlayerHorcrux");
+    ScopedTimer timer(duration);
+    persistence.enqueue({PersistEventType::PLAYER_HORCRUX, "", playerID, horcruxID});
+}
+
+
+// Value of one cookie in a Cookie header, empty if it is not there
+std::string cookieValue(const std::string& header, const std::string& name) {
+    std::istringstream cookies(header);
+    std::string cookie;
+    while (std::getline(cookies, cookie, ';')) {
+        const size_t start = cookie.find_first_not_of(' ');
+        const size_t equals = cookie.find('=');
+        if (start != std::string::npos && equals != std::string::npos && cookie.substr(start, equals - start) == name) {
+            return cookie.substr(equals + 1);
+        }
+    }
+    return "";
+}
+
+
+// Pushes a change to everyone watching the game. Called with the session locked so events arrive in order.
+void publishGameEvent(const GameChannel& channel, GameSession& session, const std::string& event, json message = json::object()) {
+    TraceSpan span("publishGameEvent");
+    message["event"] = event;
+    message["status"] = static_cast<int>(session.getGameState());
+    if (session.getGameState() == GameState::ENDED) {
+        message["result"] = static_cast<int>(session.getGame().getGameResult());
     }
-}
\ No newline at end of file
+    channel.publish(session.getGameID(), message.dump());
+}
+
+
+// False unless `text` is a whole decimal version number
+bool parseVersion(const char* text, uint64_t& version) {
+    const char* end = text + std::strlen(text);
+    const auto [parsed, error] = std::from_chars(text, end, version);
+    return error == std::errc() && parsed == end;
+}
+
+
+/*
+ * Serves one view of a game with its version as the ETag.
+ *
+ * A client sending the current ETag in If-None-Match gets a bare 304, so an unchanged
+ * poll never renders anything. With `?waitFor=<version>`, a client already holding that
+ * version is parked until the game changes, or answered with a 304 after the timeout.
+ * Ahead of the version sits a prefix unique to this server run, since a recovered game
+ * counts its versions afresh.
+ * The wake-up and the timeout both run on the request's own IO thread.
+ */
+void respondVersioned(const crow::request& req, crow::response& res, std::shared_ptr<GameSession> pSession,
+                      const std::string& etagPrefix, std::function<crow::response(GameSession&)> render) {
+    auto etagOf = [etagPrefix](uint64_t version) {return "\"" + etagPrefix + std::to_string(version) + "\"";};
+    auto respond = [&res, pSession, etagOf, render](const std::string& ifNoneMatch) {
+        std::lock_guard<std::mutex> lock(pSession->getMutex());
+        const std::string etag = etagOf(pSession->getVersion());
+        if (ifNoneMatch == etag) {
+            res = crow::response(304);
+        } else {
+            res = render(*pSession);
+        }
+        res.set_header("ETag", etag);
+        res.end();
+    };
+    const std::string ifNoneMatch = req.get_header_value("If-None-Match");
+
+    const char* waitFor = req.url_params.get("waitFor");
+    uint64_t waitedForVersion = 0;
+    if (waitFor && !parseVersion(waitFor, waitedForVersion)) {
+        res = crow::response(400, "Invalid waitFor version.");
+        res.end();
+        return;
+    }
+    std::unique_lock<std::mutex> lock(pSession->getMutex());
+    if (!waitFor || waitedForVersion != pSession->getVersion()) {
+        lock.unlock();
+        respond(ifNoneMatch);
+        return;
+    }
+
+    // Whichever of the change and the timeout comes first answers; the other does nothing
+    auto isAnswered = std::make_shared<std::atomic<bool>>(false);
+    auto timer = std::make_shared<asio::steady_timer>(*req.io_service, std::chrono::seconds(LONG_POLL_TIMEOUT_SECONDS));
+    asio::io_service& io = *req.io_service;
+    const uint64_t watchID = pSession->watch([&io, isAnswered, timer, respond]() {
+        asio::post(io, [isAnswered, timer, respond]() {
+            if (!isAnswered->exchange(true)) {
+                timer->cancel();
+                respond("");
+            }
+        });
+    });
+    lock.unlock();
+
+    // Nothing changed while parked, so the client's copy is still current
+    const std::string waitedForETag = etagOf(waitedForVersion);
+    timer->async_wait([isAnswered, pSession, watchID, respond, waitedForETag](const asio::error_code& error) {
+        if (error || isAnswered->exchange(true)) {return;}
+        {
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            pSession->unwatch(watchID);
+        }
+        respond(waitedForETag);
+    });
+}
+
+
+std::string squareJsonName(const Position& position) {
+    return std::string(1, position.getFile()) + std::to_string(position.getRank());
+}
+
+
+json squareJson(const Board& board, int square) {
+    const Position pos = toPosition(square);
+    json squareJson;
+    squareJson["position"] = { {"file", std::string(1, pos.getFile())}, {"rank", pos.getRank()} };
+
+    if (const IPiece* piece = board.getPiece(square)) {
+        squareJson["piece"]["id"] = piece->getID();
+        squareJson["piece"]["type"] = piece->getType();
+        squareJson["piece"]["color"] = piece->getColor();
+    }
+    return squareJson;
+}
+
+
+// The given squares of the board, every one of them by default, with the piece standing on each if any
+json boardJson(const Game& game, Bitboard squares = ~0ULL) {
+    json squaresJson = json::array();
+    while (squares) {
+        squaresJson.push_back(squareJson(*game.getBoard(), popLsb(squares)));
+    }
+    return squaresJson;
+}
+
+
+std::string gameEventName(GameEventType type) {
+    switch (type) {
+        case GameEventType::JOINED: return "joined";
+        case GameEventType::HORCRUX_SET: return "horcrux";
+        case GameEventType::MOVE: return "move";
+        case GameEventType::HORCRUX_GUESS: return "guess";
+        case GameEventType::SNAPSHOT: return "restored";
+        default: return "created";
+    }
+}
+
+
+/*
+ * The board as changed since the client's version: the current contents of every square
+ * that changed, and the changes themselves. Falls back to the whole board, flagged "full",
+ * when the client is too far behind or holds a version from another run of the server.
+ * Call with the session locked.
+ */
+json boardDiffJson(const GameSession& session, const std::string& runID, uint64_t since, const std::string& run) {
+    json diff;
+    diff["version"] = session.getVersion();
+    diff["run"] = runID;
+
+    Bitboard squares = 0;
+    std::vector<BoardDiff> diffs;
+    if (run != runID || !session.getDiffs().collect(since, squares, diffs)) {
+        diff["full"] = true;
+        diff["squares"] = boardJson(session.getGame());
+        return diff;
+    }
+
+    diff["full"] = false;
+    diff["changes"] = boardJson(session.getGame(), squares);
+    json events = json::array();
+    for (const BoardDiff& change : diffs) {
+        events.push_back({{"version", change.version}, {"event", gameEventName(change.type)}});
+    }
+    diff["events"] = events;
+    return diff;
+}
+
+
+/*
+ * Everything one player's screen shows, in one response: state, board, their color,
+ * guesses left, horcrux status and version. While it is their move, "moves" maps each
+ * of their pieces' squares to where it can go. Call with the session locked.
+ */
+json gameSnapshotJson(GameSession& session, const Player& player) {
+    Game& game = session.getGame();
+    const GameState state = session.getGameState();
+
+    json snapshot;
+    snapshot["gameID"] = session.getGameID();
+    snapshot["version"] = session.getVersion();
+    snapshot["status"] = static_cast<int>(state);
+    if (state == GameState::ENDED) {
+        snapshot["result"] = static_cast<int>(game.getGameResult());
+    }
+    snapshot["playerColor"] = static_cast<int>(player.getColor());
+    snapshot["horcruxGuessesLeft"] = player.getNumberOfHorcruxGuessesLeft();
+    snapshot["squares"] = boardJson(game);
+
+    const Player* pWhite = session.getPlayer(Color::WHITE);
+    const Player* pBlack = session.getPlayer(Color::BLACK);
+    // A horcrux ID is only revealed to its owner, or to both once it has been found
+    snapshot["horcruxStatus"] = {
+        {"horcruxID", player.getHorcruxID()},
+        {"whiteHasBeenGuessed", pWhite->getHorcruxFound()},
+        {"whiteFoundID", pWhite->getHorcruxFound() ? pWhite->getHorcruxID() : INVALID_HORCRUXE_ID},
+        {"blackHasBeenGuessed", pBlack->getHorcruxFound()},
+        {"blackFoundID", pBlack->getHorcruxFound() ? pBlack->getHorcruxID() : INVALID_HORCRUXE_ID}
+    };
+
+    json moves = json::object();
+    const GameState playerMove = (player.getColor() == Color::WHITE) ? GameState::WHITE_MOVE : GameState::BLACK_MOVE;
+    if (state == playerMove) {
+        // Pins and check masks are worked out once for the position, not once per piece
+        MoveList legalMoves;
+        game.getLegalMoves(player.getColor(), legalMoves);
+        // Bucketed by from-square; the four promotions to one square share a bit
+        std::array<Bitboard, NUMBER_OF_SQUARES> targets{};
+        for (const CompactMove& move : legalMoves) {
+            targets[move.getFrom()] |= squareBit(move.getTo());
+        }
+        for (int from = 0; from < NUMBER_OF_SQUARES; ++from) {
+            Bitboard to = targets[from];
+            if (!to) {continue;}
+            json names = json::array();
+            while (to) {names.push_back(squareJsonName(toPosition(popLsb(to))));}
+            moves[squareJsonName(toPosition(from))] = names;
+        }
+    }
+    snapshot["moves"] = moves;
+    return snapshot;
+}
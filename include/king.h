@@ -12,6 +12,7 @@ class King : public IPiece {
 
         virtual bool isValidMove(const Move& move) const;
         virtual std::unordered_set<Position> getPossiblePositions(const Position& from) const;
+        virtual void getPossibleMoves(const Position& from, MoveList& moves) const override;
         
         virtual void setHasMoved() {hasMoved_ = true;};
         virtual bool getHasMoved() const {return hasMoved_;}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARNING,
+    ERROR
+};
+
+// Messages below this level are compiled out, arguments and all. Build with -DCHESS_LOG_MIN_LEVEL=0 for debug logs.
+#ifndef CHESS_LOG_MIN_LEVEL
+#define CHESS_LOG_MIN_LEVEL 1
+#endif
+
+#define LOG_QUEUE_CAPACITY 4096 // Power of two
+#define LOG_RECORD_BYTES 256    // Longer lines are cut short
+
+#define CHESS_LOG(level, ...) \
+    do { \
+        if constexpr (static_cast<int>(level) >= CHESS_LOG_MIN_LEVEL) {Logger::global().log(level, __VA_ARGS__);} \
+    } while (0)
+#define CHESS_LOG_DEBUG(...) CHESS_LOG(LogLevel::DEBUG, __VA_ARGS__)
+#define CHESS_LOG_INFO(...) CHESS_LOG(LogLevel::INFO, __VA_ARGS__)
+#define CHESS_LOG_WARNING(...) CHESS_LOG(LogLevel::WARNING, __VA_ARGS__)
+#define CHESS_LOG_ERROR(...) CHESS_LOG(LogLevel::ERROR, __VA_ARGS__)
+
+// One key=value pair of a structured log line, e.g. {"gameID", gameID}
+struct LogField {
+    LogField(const char* key, const std::string& value) : key(key), value(value) {};
+    LogField(const char* key, const char* value) : key(key), value(value) {};
+    template<typename Number, typename = std::enable_if_t<std::is_arithmetic_v<Number>>>
+    LogField(const char* key, Number value) : key(key), value(std::to_string(value)) {};
+
+    const char* key;
+    std::string value;
+};
+
+
+/*
+ * Asynchronous logger.
+ *
+ * The calling thread formats its line into a slot of a bounded lock-free ring and
+ * returns; one background thread writes the lines out in batches. When the ring is
+ * full the line is dropped and counted rather than making the caller wait.
+ */
+class Logger {
+    public:
+        using Sink = std::function<void(const char* data, size_t size)>;
+
+        explicit Logger(Sink sink, size_t capacity = LOG_QUEUE_CAPACITY);
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        void log(LogLevel level, const std::string& message, std::initializer_list<LogField> fields = {});
+        // Blocks until every line logged so far has reached the sink
+        void flush();
+
+        // Lines below this level are dropped at run time, on top of the compile-time cut
+        void setLevel(LogLevel level) {level_.store(level, std::memory_order_relaxed);}
+        LogLevel getLevel() const {return level_.load(std::memory_order_relaxed);}
+        uint64_t getDropped() const {return dropped_.load(std::memory_order_relaxed);}
+
+        // Writes to stderr, at the level named by the LOG_LEVEL environment variable
+        static Logger& global();
+        static const char* levelName(LogLevel level);
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            uint16_t length;
+            char text[LOG_RECORD_BYTES];
+        };
+
+        void _run();
+        // Moves every published line into `batch`, returning how many there were
+        size_t _drain(std::string& batch);
+
+        Sink sink_;
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+        std::atomic<LogLevel> level_{LogLevel::DEBUG};
+        std::atomic<uint64_t> dropped_{0};
+
+        alignas(64) std::atomic<size_t> head_{0};       // Next slot a producer claims
+        alignas(64) std::atomic<size_t> consumed_{0};   // Lines handed to the sink so far
+        size_t tail_ = 0;                               // Writer thread only
+
+        std::atomic<bool> isStopping_{false};
+        std::thread writer_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "write_behind_queue.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#define NO_HORCRUX -1
+
+struct StoredPlayer {
+    int color;
+    int horcruxID = NO_HORCRUX;
+};
+
+
+/*
+ * Keeps the rows MySqlSink would write in process memory.
+ *
+ * Lets the server run on one box with no database, e.g. under loadgen. Events
+ * are applied with the same meaning as MySqlSink's statements: creates
+ * insert-or-overwrite, updates touch only rows that exist, removes delete. Nothing survives a restart
+ * beyond what the write-behind WAL replays.
+ */
+class MemorySink : public PersistenceSink {
+    public:
+        void writeBatch(const std::vector<PersistEvent>& events) override;
+
+        // False if the game has no row
+        bool findGameState(const std::string& gameID, int& state) const;
+        // False if the player has no row
+        bool findPlayer(const std::string& playerID, StoredPlayer& player) const;
+
+        size_t getGameCount() const;
+        size_t getPlayerCount() const;
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, int> games_;
+        std::unordered_map<std::string, StoredPlayer> players_;
+};
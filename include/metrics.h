@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#define METRICS_SHARDS 8                // Threads spread over this many copies of each counter
+#define HISTOGRAM_SUB_BUCKETS 4         // Buckets per power of two, so a value is known to within 25%
+#define HISTOGRAM_MAX_OCTAVE 40         // Values from 2^40 ns (about 18 minutes) up share the last bucket
+#define HISTOGRAM_BUCKETS (HISTOGRAM_MAX_OCTAVE * HISTOGRAM_SUB_BUCKETS)
+
+// Prometheus only sees bucket bounds from 2^10 ns (about a microsecond) to 2^36 ns (about a minute)
+#define HISTOGRAM_EXPORT_MIN_OCTAVE 10
+#define HISTOGRAM_EXPORT_MAX_OCTAVE 36
+
+namespace metrics_detail {
+    // Each thread keeps to one shard, so threads rarely write the same cache line
+    size_t shardIndex();
+}
+
+
+// Monotonic count, added to without locking
+class Counter {
+    public:
+        void add(uint64_t amount = 1) {
+            shards_[metrics_detail::shardIndex()].value.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        uint64_t getValue() const;
+
+    private:
+        struct alignas(64) Shard {
+            std::atomic<uint64_t> value{0};
+        };
+
+        std::array<Shard, METRICS_SHARDS> shards_;
+};
+
+
+struct HistogramSnapshot {
+    std::array<uint64_t, HISTOGRAM_BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t sumNanos = 0;
+
+    // Number of recorded values below 2^octave ns
+    uint64_t countBelow(int octave, int subBucket = 0) const;
+    // Upper bound of the bucket holding the value at the given quantile, e.g. 0.99, or 0 if empty
+    uint64_t quantileNanos(double quantile) const;
+};
+
+
+/*
+ * Latency histogram with log-linear buckets, in the manner of HdrHistogram.
+ *
+ * Every power of two of nanoseconds is split into HISTOGRAM_SUB_BUCKETS equal
+ * buckets, so the relative error is the same from microseconds to seconds.
+ * Recording is a count-leading-zeros and two relaxed atomic adds on the
+ * calling thread's shard; reading sums the shards.
+ */
+class LatencyHistogram {
+    public:
+        void record(uint64_t nanos) {
+            Shard& shard = shards_[metrics_detail::shardIndex()];
+            shard.buckets[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+            shard.sumNanos.fetch_add(nanos, std::memory_order_relaxed);
+        }
+
+        void record(std::chrono::steady_clock::duration elapsed) {
+            record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+        HistogramSnapshot getSnapshot() const;
+
+        // Smallest value past the bucket
+        static uint64_t bucketEnd(size_t index) {
+            if (index < 2 * HISTOGRAM_SUB_BUCKETS) {return index + 1;}
+            const size_t octave = index / HISTOGRAM_SUB_BUCKETS + 1;
+            return static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS + 1 + index % HISTOGRAM_SUB_BUCKETS) << (octave - 2);
+        }
+
+        static size_t bucketIndex(uint64_t nanos) {
+            if (nanos < 2 * HISTOGRAM_SUB_BUCKETS) {return static_cast<size_t>(nanos);}
+            const int octave = 63 - __builtin_clzll(nanos);
+            if (octave >= HISTOGRAM_MAX_OCTAVE) {return HISTOGRAM_BUCKETS - 1;}
+            // The two bits below the leading one pick the sub-bucket
+            const size_t subBucket = (nanos >> (octave - 2)) & (HISTOGRAM_SUB_BUCKETS - 1);
+            return static_cast<size_t>(octave - 1) * HISTOGRAM_SUB_BUCKETS + subBucket;
+        }
+
+    private:
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+            std::atomic<uint64_t> sumNanos{0};
+        };
+
+        std::array<Shard, METRICS_SHARDS> shards_;
+};
+
+
+// Records the time from construction to destruction
+class ScopedTimer {
+    public:
+        explicit ScopedTimer(LatencyHistogram& histogram)
+            : histogram_(histogram), start_(std::chrono::steady_clock::now()) {};
+        ~ScopedTimer() {histogram_.record(std::chrono::steady_clock::now() - start_);}
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        LatencyHistogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+};
+
+
+/*
+ * Named counters and histograms of the process.
+ *
+ * Looking a metric up takes a lock, so callers look it up once and keep the
+ * reference, which stays valid for the registry's lifetime. Labels are given
+ * pre-formatted, e.g. `route="/game/move"`.
+ */
+class MetricsRegistry {
+    public:
+        Counter& counter(const std::string& name, const std::string& labels = "");
+        LatencyHistogram& histogram(const std::string& name, const std::string& labels = "");
+
+        // Prometheus text exposition of every metric, histograms in seconds
+        void write(std::ostream& out) const;
+
+        static MetricsRegistry& global();
+
+    private:
+        using Key = std::pair<std::string, std::string>;
+
+        mutable std::mutex mutex_;
+        std::map<Key, std::unique_ptr<Counter>> counters_;
+        std::map<Key, std::unique_ptr<LatencyHistogram>> histograms_;
+};
+
+
+// Prometheus text exposition of one gauge read at scrape time
+inline void writeGauge(std::ostream& out, const std::string& name, double value) {
+    out << "# TYPE " << name << " gauge\n" << name << " " << value << "\n";
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "crow/http_request.h"
+#include "crow/http_response.h"
+#include "metrics.h"
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Times every request from the moment Crow hands it to the middlewares until its
+ * response is complete, long-polls included, into http_request_duration_seconds.
+ *
+ * Only routes registered with track() get a series of their own; any other URL is
+ * counted as "other" so that stray requests cannot grow the label set.
+ */
+class RouteMetrics {
+    public:
+        struct context {
+            std::chrono::steady_clock::time_point start;
+        };
+
+        RouteMetrics() : other_(_metrics("other")) {};
+
+        // Must be called for every route before the app starts serving
+        void track(const std::string& route) {
+            routes_.emplace(route, _metrics(route));
+        }
+
+        void before_handle(crow::request& req, crow::response& res, context& ctx) {
+            ctx.start = std::chrono::steady_clock::now();
+        }
+
+        void after_handle(crow::request& req, crow::response& res, context& ctx) {
+            auto it = routes_.find(req.url);
+            const Metrics& metrics = it != routes_.end() ? it->second : other_;
+            metrics.duration->record(std::chrono::steady_clock::now() - ctx.start);
+            if (res.code >= 500) {metrics.errors->add();}
+        }
+
+    private:
+        struct Metrics {
+            LatencyHistogram* duration;
+            Counter* errors;
+        };
+
+        static Metrics _metrics(const std::string& route) {
+            const std::string labels = "route=\"" + route + "\"";
+            MetricsRegistry& registry = MetricsRegistry::global();
+            return Metrics{&registry.histogram("http_request_duration_seconds", labels),
+                           &registry.counter("http_server_errors_total", labels)};
+        }
+
+        Metrics other_;
+        std::unordered_map<std::string, Metrics> routes_;
+};
@@ -9,6 +9,9 @@ public:
     MOCK_METHOD(bool, isValidEnPassant, (const Move& previousMove, const Move& move), (const, override));
     MOCK_METHOD(bool, isValidPromotion, (const Move& move), (const, override));
 
-    MOCK_METHOD(std::unordered_set<Position>, generateValidPositions, (const Board& board, const IPiece* piece, const Position& from, const Move& previousMove), (override));
+    MOCK_METHOD(std::unordered_set<Position>, generateValidPositions, (const Board& board, const Position& from, const Move& previousMove), (override));
+    MOCK_METHOD(void, generateValidMoves, (const Board& board, const Position& from, const Move& previousMove, MoveList& moves), (override));
+    MOCK_METHOD(void, generateLegalMoves, (const Board& board, Color side, MoveList& moves), (const, override));
+    MOCK_METHOD(bool, hasLegalMove, (const Board& board, Color side), (const, override));
 
 };
\ No newline at end of file
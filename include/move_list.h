@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include "bitboard.h"
+#include "piece.h"
+
+#define MAX_MOVES 256
+
+enum class MoveFlag : uint8_t {
+    QUIET = 0,
+    DOUBLE_PAWN_PUSH = 1,
+    KING_CASTLE = 2,
+    QUEEN_CASTLE = 3,
+    CAPTURE = 4,
+    EN_PASSANT = 5,
+    KNIGHT_PROMOTION = 8,
+    BISHOP_PROMOTION = 9,
+    ROOK_PROMOTION = 10,
+    QUEEN_PROMOTION = 11,
+    KNIGHT_PROMOTION_CAPTURE = 12,
+    BISHOP_PROMOTION_CAPTURE = 13,
+    ROOK_PROMOTION_CAPTURE = 14,
+    QUEEN_PROMOTION_CAPTURE = 15
+};
+
+// A move packed into 16 bits: from (6) | to (6) | flag (4)
+class CompactMove {
+    public:
+        CompactMove() : data_(0) {};
+        CompactMove(int from, int to, MoveFlag flag = MoveFlag::QUIET)
+            : data_(static_cast<uint16_t>(from | (to << 6) | (static_cast<int>(flag) << 12))) {};
+
+        int getFrom() const {return data_ & 0x3F;}
+        int getTo() const {return (data_ >> 6) & 0x3F;}
+        MoveFlag getFlag() const {return static_cast<MoveFlag>(data_ >> 12);}
+
+        bool isCapture() const {return (data_ >> 12) & 0x4;}
+        bool isPromotion() const {return (data_ >> 12) & 0x8;}
+        bool isCastling() const {return getFlag() == MoveFlag::KING_CASTLE || getFlag() == MoveFlag::QUEEN_CASTLE;}
+
+        PieceType getPromotionType() const {
+            static constexpr PieceType PROMOTIONS[4] = {PieceType::KNIGHT, PieceType::BISHOP, PieceType::ROOK, PieceType::QUEEN};
+            return PROMOTIONS[(data_ >> 12) & 0x3];
+        }
+
+        uint16_t getRaw() const {return data_;}
+        static CompactMove fromRaw(uint16_t raw) {
+            CompactMove move;
+            move.data_ = raw;
+            return move;
+        }
+
+        // Long algebraic form, e.g. "e2e4" or "e7e8q"
+        std::string toUci() const {
+            static constexpr char PROMOTIONS[4] = {'n', 'b', 'r', 'q'};
+            std::string uci = {static_cast<char>('a' + fileOf(getFrom())), static_cast<char>('1' + rankOf(getFrom())),
+                               static_cast<char>('a' + fileOf(getTo())), static_cast<char>('1' + rankOf(getTo()))};
+            if (isPromotion()) {uci += PROMOTIONS[(data_ >> 12) & 0x3];}
+            return uci;
+        }
+
+        bool operator==(const CompactMove& other) const {return data_ == other.data_;}
+        bool operator!=(const CompactMove& other) const {return data_ != other.data_;}
+
+    private:
+        uint16_t data_;
+};
+
+// Fixed-capacity move buffer meant to live on the stack. No position has more than 218 legal moves.
+class MoveList {
+    public:
+        MoveList() : size_(0) {};
+
+        void push_back(CompactMove move) {moves_[size_++] = move;}
+
+        // Adds one move per target square, flagging the ones that land on `captures`
+        void addMoves(int from, Bitboard targets, Bitboard captures) {
+            while (targets) {
+                int to = popLsb(targets);
+                push_back(CompactMove(from, to, (captures & squareBit(to)) ? MoveFlag::CAPTURE : MoveFlag::QUIET));
+            }
+        }
+
+        void addPromotions(int from, int to, bool isCapture) {
+            const int base = isCapture ? static_cast<int>(MoveFlag::KNIGHT_PROMOTION_CAPTURE)
+                                       : static_cast<int>(MoveFlag::KNIGHT_PROMOTION);
+            for (int promotion = 3; promotion >= 0; --promotion) {
+                push_back(CompactMove(from, to, static_cast<MoveFlag>(base + promotion)));
+            }
+        }
+
+        size_t size() const {return size_;}
+        bool empty() const {return size_ == 0;}
+        void clear() {size_ = 0;}
+
+        const CompactMove& operator[](size_t index) const {return moves_[index];}
+        const CompactMove* begin() const {return moves_.data();}
+        const CompactMove* end() const {return moves_.data() + size_;}
+
+        bool contains(int from, int to) const {
+            for (const CompactMove& move : *this) {
+                if (move.getFrom() == from && move.getTo() == to) {return true;}
+            }
+            return false;
+        }
+
+        Bitboard getTargets() const {
+            Bitboard targets = EMPTY_BITBOARD;
+            for (const CompactMove& move : *this) {
+                targets |= squareBit(move.getTo());
+            }
+            return targets;
+        }
+
+        // Conversion to the REST-facing shape, only meant for the API edge
+        std::unordered_set<Position> toPositions() const {
+            return IPiece::toPositions(getTargets());
+        }
+
+    private:
+        std::array<CompactMove, MAX_MOVES> moves_;
+        size_t size_;
+};
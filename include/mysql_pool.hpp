@@ -0,0 +1,127 @@
+#pragma once
+
+#include "connection_pool.h"
+#include "logger.h"
+#include "statement_cache.h"
+#include "write_behind_queue.h"
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include <mysql_driver.h>
+#include <mysql_connection.h>
+#include <cppconn/exception.h>
+#include <cppconn/prepared_statement.h>
+
+// A pooled connection together with the statements prepared on it
+class MySqlConnection {
+    public:
+        explicit MySqlConnection(std::unique_ptr<sql::Connection> con)
+            : con_(std::move(con)),
+              statements_([this](const std::string& query) {
+                  return std::unique_ptr<sql::PreparedStatement>(con_->prepareStatement(query));
+              }) {};
+        MySqlConnection(const MySqlConnection&) = delete;
+        MySqlConnection& operator=(const MySqlConnection&) = delete;
+
+        // Prepared once per connection; parameters left over from the last call are cleared
+        sql::PreparedStatement& prepare(const std::string& query) {
+            sql::PreparedStatement& pstmt = statements_.get(query);
+            pstmt.clearParameters();
+            return pstmt;
+        }
+
+        sql::Connection& getConnection() {return *con_;}
+        bool isValid() {return con_->isValid();}
+        const StatementCache<sql::PreparedStatement>& getStatements() const {return statements_;}
+
+    private:
+        std::unique_ptr<sql::Connection> con_;
+        StatementCache<sql::PreparedStatement> statements_; // Declared after con_ so the statements close first
+};
+
+using MySqlPool = ConnectionPool<MySqlConnection>;
+
+// Connection settings, read from the MYSQL_* variables set in docker-compose.yml
+struct MySqlConfig {
+    std::string host;
+    int port;
+    std::string user;
+    std::string password;
+    std::string database;
+    size_t poolSize;
+    std::chrono::milliseconds acquireTimeout;
+};
+
+
+std::string envOr(const char* name, const std::string& fallback) {
+    const char* value = std::getenv(name);
+    return (value && *value) ? std::string(value) : fallback;
+}
+
+
+MySqlConfig mysqlConfigFromEnv() {
+    // One connection per Crow worker thread unless told otherwise
+    const unsigned workers = std::max(1U, std::thread::hardware_concurrency());
+
+    MySqlConfig config;
+    config.host = envOr("MYSQL_HOST", "127.0.0.1");
+    config.port = std::stoi(envOr("MYSQL_PORT", "3306"));
+    config.user = envOr("MYSQL_USER", "root");
+    config.password = envOr("MYSQL_PASSWORD", "my_secret_pw");
+    config.database = envOr("MYSQL_DB", "mystery_mate_database");
+    config.poolSize = std::stoul(envOr("MYSQL_POOL_SIZE", std::to_string(workers)));
+    config.acquireTimeout = std::chrono::milliseconds(std::stol(envOr("MYSQL_POOL_TIMEOUT_MS", "2000")));
+    return config;
+}
+
+
+std::unique_ptr<MySqlPool> createMySqlPool(const MySqlConfig& config) {
+    auto connect = [config]() {
+        sql::mysql::MySQL_Driver* driver = sql::mysql::get_mysql_driver_instance();
+        std::unique_ptr<sql::Connection> con(driver->connect(
+            "tcp://" + config.host + ":" + std::to_string(config.port), config.user, config.password));
+        con->setSchema(config.database);
+        return std::make_unique<MySqlConnection>(std::move(con));
+    };
+    auto isHealthy = [](MySqlConnection& con) {
+        try {
+            return con.isValid();
+        } catch (sql::SQLException&) {
+            return false;
+        }
+    };
+    return std::make_unique<MySqlPool>(config.poolSize, connect, isHealthy, config.acquireTimeout);
+}
+
+
+// Runs `work` on a pooled connection, dropping the connection if a failed query left it unusable
+template<typename Work>
+auto withConnection(MySqlPool& pool, Work&& work) {
+    auto con = pool.acquire();
+    try {
+        return work(con.get());
+    } catch (sql::SQLException& e) {
+        bool isValid = false;
+        try {
+            isValid = con->isValid();
+        } catch (sql::SQLException&) {}
+        if (!isValid) {
+            CHESS_LOG_WARNING("Dropping broken MySQL connection", {{"error", e.what()}});
+            con.invalidate();
+        }
+        throw;
+    }
+}
+
+
+// Write-behind settings for the MySQL sink; MYSQL_WAL_PATH turns on fsync-before-acknowledge
+WriteBehindConfig writeBehindConfigFromEnv() {
+    WriteBehindConfig config;
+    config.capacity = std::stoul(envOr("MYSQL_WRITE_QUEUE", std::to_string(config.capacity)));
+    config.flushSize = std::stoul(envOr("MYSQL_WRITE_BATCH", std::to_string(config.flushSize)));
+    config.flushInterval = std::chrono::milliseconds(std::stol(envOr("MYSQL_WRITE_FLUSH_MS", std::to_string(config.flushInterval.count()))));
+    config.maxAttempts = std::stoul(envOr("MYSQL_WRITE_ATTEMPTS", std::to_string(config.maxAttempts)));
+    config.walPath = envOr("MYSQL_WAL_PATH", "");
+    return config;
+}
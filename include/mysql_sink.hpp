@@ -0,0 +1,118 @@
+#pragma once
+
+#include "metrics.h"
+#include "mysql_pool.hpp"
+#include "write_behind_queue.h"
+
+// Rows per multi-row insert or delete come in powers of two up to this, so each run needs at most five statements
+#define MAX_ROWS_PER_STATEMENT 16
+
+/*
+ * Writes coalesced batches to MySQL in one transaction, in the order the events
+ * arrived. Consecutive creates or deletes of the same kind share multi-row
+ * statements; updates are plain UPDATEs, one per row, so they never bring back
+ * a game or player deleted earlier.
+ */
+class MySqlSink : public PersistenceSink {
+    public:
+        explicit MySqlSink(MySqlPool& pool)
+            : pool_(pool), batchDuration_(MetricsRegistry::global().histogram("db_batch_duration_seconds")) {};
+
+        void writeBatch(const std::vector<PersistEvent>& events) override {
+            // Connection wait, statements and commit of the whole transaction
+            ScopedTimer timer(batchDuration_);
+            withConnection(pool_, [&events](MySqlConnection* con) {
+                sql::Connection& raw = con->getConnection();
+                raw.setAutoCommit(false);
+                try {
+                    // Each run of events of one kind is written before the next run starts
+                    size_t runStart = 0;
+                    for (size_t i = 1; i <= events.size(); ++i) {
+                        if (i == events.size() || events[i].type != events[runStart].type) {
+                            _writeRun(*con, &events[runStart], i - runStart);
+                            runStart = i;
+                        }
+                    }
+                    raw.commit();
+                } catch (...) {
+                    raw.rollback();
+                    raw.setAutoCommit(true);
+                    throw;
+                }
+                raw.setAutoCommit(true);
+            });
+        }
+
+    private:
+        static bool _isUpdate(PersistEventType type) {
+            return type == PersistEventType::GAME_STATE || type == PersistEventType::PLAYER_HORCRUX;
+        }
+
+        static void _writeRun(MySqlConnection& con, const PersistEvent* run, size_t count) {
+            const PersistEventType type = run->type;
+            size_t offset = 0;
+            while (offset < count) {
+                size_t rows = _isUpdate(type) ? 1 : MAX_ROWS_PER_STATEMENT;
+                while (rows > count - offset) {rows /= 2;}
+
+                sql::PreparedStatement& pstmt = con.prepare(_query(type, rows));
+                unsigned parameter = 1;
+                for (size_t row = offset; row < offset + rows; ++row) {
+                    const PersistEvent& event = run[row];
+                    switch (type) {
+                        case PersistEventType::CREATE_GAME:
+                            pstmt.setString(parameter++, event.gameID);
+                            pstmt.setInt(parameter++, event.value);
+                            break;
+                        case PersistEventType::CREATE_PLAYER:
+                            pstmt.setString(parameter++, event.playerID);
+                            pstmt.setInt(parameter++, event.value);
+                            break;
+                        case PersistEventType::GAME_STATE:
+                            pstmt.setInt(parameter++, event.value);
+                            pstmt.setString(parameter++, event.gameID);
+                            break;
+                        case PersistEventType::PLAYER_HORCRUX:
+                            pstmt.setInt(parameter++, event.value);
+                            pstmt.setString(parameter++, event.playerID);
+                            break;
+                        case PersistEventType::REMOVE_PLAYER:
+                            pstmt.setString(parameter++, event.playerID);
+                            break;
+                        case PersistEventType::KILL_GAME:
+                            pstmt.setString(parameter++, event.gameID);
+                            break;
+                    }
+                }
+                pstmt.execute();
+                offset += rows;
+            }
+        }
+
+        static std::string _query(PersistEventType type, size_t rows) {
+            auto repeat = [rows](const std::string& item) {
+                std::string list = item;
+                for (size_t i = 1; i < rows; ++i) {list += ", " + item;}
+                return list;
+            };
+
+            switch (type) {
+                case PersistEventType::CREATE_GAME:
+                    return "INSERT INTO games(id, state) VALUES " + repeat("(?, ?)");
+                case PersistEventType::CREATE_PLAYER:
+                    return "INSERT INTO players(id, color) VALUES " + repeat("(?, ?)");
+                case PersistEventType::GAME_STATE:
+                    return "UPDATE games SET state = ? WHERE id = ?";
+                case PersistEventType::PLAYER_HORCRUX:
+                    return "UPDATE players SET horcrux_id = ? WHERE id = ?";
+                case PersistEventType::REMOVE_PLAYER:
+                    return "DELETE FROM players WHERE id IN (" + repeat("?") + ")";
+                case PersistEventType::KILL_GAME:
+                    return "DELETE FROM games WHERE id IN (" + repeat("?") + ")";
+            }
+            throw std::logic_error("Unknown persistence event");
+        }
+
+        MySqlPool& pool_;
+        LatencyHistogram& batchDuration_;
+};
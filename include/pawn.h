@@ -12,11 +12,14 @@ class Pawn : public IPiece {
         
         virtual bool isValidMove(const Move& move) const;
         virtual std::unordered_set<Position> getPossiblePositions(const Position& from) const;
+        virtual void getPossibleMoves(const Position& from, MoveList& moves) const override;
         virtual PieceType getType() const {return type_;}
         virtual Color getColor() const {return color_;}
         virtual int getID() const {return id_;}
 
     private:
+        Bitboard pushTargets_(int from) const;
+
         const int id_;
         const PieceType type_;
         const Color color_;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "board.h"
+#include "board_rules.h"
+
+/*
+ * Perft: counts the leaf nodes of the legal move tree to a fixed depth. The counts for the
+ * reference positions below are well known, which makes perft the correctness oracle for
+ * move generation as well as its throughput benchmark.
+ */
+
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    std::vector<uint64_t> nodes; // nodes[d - 1] is the count at depth d
+};
+
+const std::vector<PerftPosition>& referencePerftPositions();
+
+uint64_t perft(Board& board, const BoardRules& rules, Color sideToMove, int depth);
+
+// Node count below each root move
+std::vector<std::pair<CompactMove, uint64_t>> perftDivide(Board& board, const BoardRules& rules, Color sideToMove, int depth);
+
+// Splits the root moves across `threads` workers, each searching its own copy of the board
+uint64_t perftParallel(const Board& board, const BoardRules& rules, Color sideToMove, int depth, unsigned threads);
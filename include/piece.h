@@ -5,9 +5,12 @@
 #include <stdexcept>
 #include "move.h"
 #include "position.h"
+#include "bitboard.h"
 
 #define GRID_SIZE 8
 
+class MoveList;
+
 enum class Color {
     WHITE,
     BLACK
@@ -34,10 +37,25 @@ class IPiece {
         virtual bool isValidMove(const Move& move) const = 0;
 
         virtual std::unordered_set<Position> getPossiblePositions(const Position& from) const = 0;
+        // Fills `moves` in place with the same targets as getPossiblePositions
+        virtual void getPossibleMoves(const Position& from, MoveList& moves) const;
         virtual PieceType getType() const = 0;
         virtual Color getColor() const = 0;
         virtual int getID() const = 0;
 
         static char fileToChar(int fileInt) {return 'a' + fileInt;}
         static int charToFile(char fileChar) {return fileChar - 'a';}
+
+        static std::unordered_set<Position> toPositions(Bitboard squares) {
+            std::unordered_set<Position> positions;
+            while (squares) {
+                positions.emplace(toPosition(popLsb(squares)));
+            }
+            return positions;
+        }
+
+        static bool containsPosition(Bitboard squares, const Position& position) {
+            int square = toSquare(position);
+            return square != NO_SQUARE && (squares & squareBit(square));
+        }
 };
\ No newline at end of file
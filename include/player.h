@@ -62,6 +62,10 @@ class Player {
             horcruxGuessLeft_--;
         }
 
+        virtual void setNumberOfHorcruxGuessesLeft(int guessesLeft) {
+            horcruxGuessLeft_ = guessesLeft;
+        }
+
         virtual Color getColor() const { return color_; }
 
         virtual void setHorcruxID(int horcruxID) {
@@ -86,15 +90,12 @@ class Player {
             if (color_ == Color::WHITE && (horcruxID < MIN_WHITE_HORCRUXE_ID || horcruxID >= MIN_BLACK_HORCRUXE_ID)) {
                 throw std::logic_error("White player must have horcrux ID starting at the white range");
                 return false;
-            } else {
-                return true;
             }
             if (color_ == Color::BLACK && (horcruxID < MIN_BLACK_HORCRUXE_ID || horcruxID > MAX_HORCRUXE_ID)) {
                 throw std::logic_error("Black player must have horcrux ID in the black range");
                 return false;
-            } else {
-                return true;
             }
+            return true;
         }
 
         bool horcruxFound_;
@@ -25,6 +25,7 @@ class Position {
 template<>
 struct std::hash<Position> {
     size_t operator()(const Position& position) const {
-        return std::hash<int>()(position.getRank()) ^ std::hash<char>()(position.getFile());
+        // Rank and file go into separate bits so no two positions share a hash
+        return std::hash<int>()((position.getRank() << 8) | static_cast<unsigned char>(position.getFile()));
     }
 };
\ No newline at end of file
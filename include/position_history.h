@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include "zobrist.h"
+
+#define HISTORY_CAPACITY 128 // Power of two above the 100 plies the fifty-move rule needs
+#define FIFTY_MOVE_RULE_PLIES 100
+
+/*
+ * Keys of the positions reached in a game, newest last, each paired with the halfmove
+ * clock (plies since the last capture or pawn move). Positions before an irreversible
+ * move can never recur, so the ring only has to reach back as far as the clock does.
+ */
+class PositionHistory {
+    public:
+        PositionHistory() : size_(0) {};
+
+        // Records the position reached by a move. Captures and pawn moves reset the clock.
+        void push(ZobristKey key, bool isIrreversible) {
+            uint16_t clock = (isIrreversible || size_ == 0) ? 0 : entries_[(size_ - 1) & (HISTORY_CAPACITY - 1)].halfmoveClock + 1;
+            entries_[size_ & (HISTORY_CAPACITY - 1)] = {key, clock};
+            size_++;
+        }
+
+        void clear() {size_ = 0;}
+
+        // Starts over from a restored position whose earlier keys are gone
+        void reset(ZobristKey key, uint16_t halfmoveClock) {
+            entries_[0] = {key, halfmoveClock};
+            size_ = 1;
+        }
+        size_t size() const {return size_;}
+
+        uint16_t getHalfmoveClock() const {
+            return size_ ? entries_[(size_ - 1) & (HISTORY_CAPACITY - 1)].halfmoveClock : 0;
+        }
+
+        // How many times the latest position has occurred, itself included
+        int repetitionCount() const {
+            if (size_ == 0) {return 0;}
+            const Entry& latest = entries_[(size_ - 1) & (HISTORY_CAPACITY - 1)];
+
+            size_t reach = std::min<size_t>({latest.halfmoveClock, size_ - 1, HISTORY_CAPACITY - 1});
+            int count = 1;
+            // Same side to move means every other ply
+            for (size_t back = 2; back <= reach; back += 2) {
+                if (entries_[(size_ - 1 - back) & (HISTORY_CAPACITY - 1)].key == latest.key) {count++;}
+            }
+            return count;
+        }
+
+    private:
+        struct Entry {
+            ZobristKey key;
+            uint16_t halfmoveClock;
+        };
+
+        std::array<Entry, HISTORY_CAPACITY> entries_;
+        size_t size_;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include "game.h"
+#include "game_snapshot.h"
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTES 64
+
+using SnapshotBytes = std::array<uint8_t, SNAPSHOT_BYTES>;
+
+/*
+ * Fixed-size binary form of a GameSnapshot, the form a game is stored and handed around in.
+ *
+ *   0       version
+ *   1..32   square of each piece by ID, 0xFF once captured
+ *   33      castling rights in the low nibble, side to move in bit 4
+ *   34      en passant square, 0xFF for none
+ *   35..36  game state, game end type
+ *   37..40  halfmove clock, fullmove number, little-endian
+ *   41..46  per player, white first: horcrux ID, guesses left, found/horcrux captured/king captured bits
+ *   47..62  reserved, zero
+ *   63      XOR of the bytes before it
+ */
+SnapshotBytes encodeSnapshot(const GameSnapshot& snapshot);
+// Throws std::runtime_error on a blob of the wrong size, version or checksum, or with a field out of range
+GameSnapshot decodeSnapshot(const uint8_t* data, size_t size);
+
+/*
+ * FEN of the game's position followed by one field per player, white first, for logs
+ * and debugging: the horcrux square ('-' while unchosen, 'x' once captured), '!' if the
+ * opponent has found it, then ':' and the guesses left. For example
+ *   rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1 d1:1 e8!:2
+ */
+std::string toSnapshotText(const Game& game);
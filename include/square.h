@@ -2,16 +2,22 @@
 
 #include "piece.h"
 
+class Board;
+
 class Square {
     public:
         Square() {};
         Square(Position position)
             : position_(position) {};
+        Square(Position position, Board* pBoard)
+            : position_(position), pBoard_(pBoard) {};
         ~Square() = default;
 
+        friend class Board;
+
         virtual bool isOccupied() const;
         virtual const Position& getPosition() const;
-        
+
         virtual void placePiece(const IPiece* pPiece);
         virtual const IPiece* getPiece() const;
         virtual void removePiece();
@@ -19,4 +25,5 @@ class Square {
     private:
         const Position position_;
         const IPiece* pPiece_ = nullptr;
+        Board* pBoard_ = nullptr; // Owning board when the square is a view onto it
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#define STATEMENT_CACHE_CAPACITY 32
+
+/*
+ * Prepared statements of one connection, keyed by their query text.
+ *
+ * A statement is prepared on first use and reused afterwards, so each query
+ * costs one server-side prepare per connection rather than one per call.
+ * The helpers only ever send a handful of fixed queries; should the cache
+ * fill up anyway it is emptied rather than tracking recency.
+ */
+template<typename Statement>
+class StatementCache {
+    public:
+        using Prepare = std::function<std::unique_ptr<Statement>(const std::string& query)>;
+
+        explicit StatementCache(Prepare prepare, size_t capacity = STATEMENT_CACHE_CAPACITY)
+            : prepare_(std::move(prepare)), capacity_(capacity) {};
+
+        Statement& get(const std::string& query) {
+            auto it = statements_.find(query);
+            if (it != statements_.end()) {
+                hits_++;
+                return *it->second;
+            }
+
+            misses_++;
+            std::unique_ptr<Statement> statement = prepare_(query);
+            if (statements_.size() >= capacity_) {
+                statements_.clear();
+            }
+            return *statements_.emplace(query, std::move(statement)).first->second;
+        }
+
+        // Statements die with their connection, so this must run before reconnecting
+        void clear() {statements_.clear();}
+
+        size_t size() const {return statements_.size();}
+        uint64_t getHits() const {return hits_;}
+        uint64_t getMisses() const {return misses_;}
+
+    private:
+        Prepare prepare_;
+        size_t capacity_;
+        std::unordered_map<std::string, std::unique_ptr<Statement>> statements_;
+        uint64_t hits_ = 0;
+        uint64_t misses_ = 0;
+};
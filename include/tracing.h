@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define TRACE_MAX_SPANS 64              // Spans past this many in one request are counted, not kept
+#define TRACE_RING_CAPACITY 128         // Slow traces kept for /debug/traces
+#define TRACE_SLOW_MILLISECONDS 50      // Requests at least this slow are kept
+
+// One timed section of a request. Names are string literals, so recording one never allocates.
+struct SpanRecord {
+    const char* name;
+    uint64_t startNanos;        // From the start of the request
+    uint64_t durationNanos;
+    uint16_t depth;             // 0 for sections called straight from the handler
+};
+
+// A finished request and its spans
+struct CompletedTrace {
+    uint64_t traceID;
+    std::string route;
+    uint64_t startMicros;       // Steady clock, so traces of one run line up with each other
+    uint64_t durationNanos;
+    uint32_t threadID;
+    uint32_t droppedSpans;
+    std::vector<SpanRecord> spans;
+};
+
+
+/*
+ * The request a thread is working on.
+ *
+ * Each thread has one, reused from request to request, so the spans vector
+ * only allocates while it grows to its largest size.
+ */
+class ActiveTrace {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        void begin(uint64_t traceID, const std::string& route);
+        // Index to pass to close, or -1 once the trace is full
+        int open(const char* name);
+        void close(int index);
+
+        uint64_t getTraceID() const {return traceID_;}
+        CompletedTrace finish(uint32_t threadID) const;
+
+    private:
+        uint64_t traceID_ = 0;
+        std::string route_;
+        Clock::time_point start_;
+        std::vector<SpanRecord> spans_;
+        uint16_t depth_ = 0;
+        uint32_t droppedSpans_ = 0;
+};
+
+
+/*
+ * Request tracing.
+ *
+ * A trace is opened on the request's thread before its handler runs, and
+ * TraceSpan guards inside the handler and the code it calls add spans to it.
+ * On a thread with no open trace, such as the persistence writer, a guard
+ * does nothing. Finished traces at least as slow as the threshold are kept
+ * in a bounded ring, newest last.
+ */
+class Tracer {
+    public:
+        // Opens a trace on the calling thread, replacing any left open, and returns its ID
+        uint64_t begin(const std::string& route);
+        // Closes the trace if it is still open on this thread. Otherwise, as when an
+        // async response completes elsewhere, only the total duration is known.
+        void end(uint64_t traceID, const std::string& route, std::chrono::steady_clock::time_point start);
+
+        void setSlowThreshold(std::chrono::nanoseconds threshold);
+        std::vector<CompletedTrace> getSlowTraces() const;
+
+        // The calling thread's open trace, or null
+        static ActiveTrace* active();
+        static Tracer& global();
+
+    private:
+        void _keep(CompletedTrace trace);
+
+        std::atomic<uint64_t> nextTraceID_{1};
+        std::atomic<int64_t> slowNanos_{std::chrono::nanoseconds(std::chrono::milliseconds(TRACE_SLOW_MILLISECONDS)).count()};
+
+        mutable std::mutex mutex_;
+        std::deque<CompletedTrace> slowTraces_;
+};
+
+
+// Adds a span covering its own lifetime to the thread's open trace, if there is one
+class TraceSpan {
+    public:
+        explicit TraceSpan(const char* name) : pTrace_(Tracer::active()) {
+            if (pTrace_) {index_ = pTrace_->open(name);}
+        }
+        ~TraceSpan() {
+            if (pTrace_) {pTrace_->close(index_);}
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        ActiveTrace* pTrace_;
+        int index_ = -1;
+};
+
+
+// One line per trace followed by its spans, indented by depth
+void writeTraceText(std::ostream& out, const std::vector<CompletedTrace>& traces);
+// Chrome trace-event JSON, for chrome://tracing or Perfetto
+void writeChromeTrace(std::ostream& out, const std::vector<CompletedTrace>& traces);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "crow/http_request.h"
+#include "crow/http_response.h"
+#include "tracing.h"
+#include <chrono>
+
+/*
+ * Opens a trace for every request and closes it once the response is complete.
+ *
+ * Listed first among the app's middlewares so its trace covers the others; time
+ * before a trace's first span is middleware work such as cookie parsing.
+ */
+struct RequestTracing {
+    struct context {
+        uint64_t traceID = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        ctx.start = std::chrono::steady_clock::now();
+        ctx.traceID = Tracer::global().begin(req.url);
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        Tracer::global().end(ctx.traceID, req.url, ctx.start);
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class PersistEventType : uint8_t {
+    CREATE_GAME,
+    CREATE_PLAYER,
+    GAME_STATE,
+    PLAYER_HORCRUX,
+    REMOVE_PLAYER,
+    KILL_GAME
+};
+
+// One state change waiting to be written. `value` holds the state, color or horcrux ID.
+struct PersistEvent {
+    PersistEventType type;
+    std::string gameID;
+    std::string playerID;
+    int value;
+
+    bool operator==(const PersistEvent& other) const {
+        return type == other.type && gameID == other.gameID && playerID == other.playerID && value == other.value;
+    }
+};
+
+
+// Where batches end up. A batch is written in one transaction; throwing leaves it to be retried.
+class PersistenceSink {
+    public:
+        virtual ~PersistenceSink() = default;
+        virtual void writeBatch(const std::vector<PersistEvent>& events) = 0;
+};
+
+
+struct WriteBehindConfig {
+    size_t capacity = 4096;                                  // Producers wait once this many events are pending
+    size_t flushSize = 64;                                   // Flush as soon as this many are pending...
+    std::chrono::milliseconds flushInterval{50};             // ...or once the oldest has waited this long
+    size_t maxAttempts = 5;                                  // A batch failing this often is dead-lettered...
+    std::chrono::milliseconds retryBackoff{100};             // ...after waits starting here and doubling
+    std::string walPath;                                     // Empty disables the write-ahead log
+};
+
+struct WriteBehindStats {
+    size_t depth;
+    uint64_t enqueued;
+    uint64_t written;
+    uint64_t coalesced;     // Updates dropped because a later one in the same batch overwrote them
+    uint64_t batches;
+    uint64_t failures;
+    uint64_t deadLettered;  // Events given up on after maxAttempts failed writes
+};
+
+
+/*
+ * Write-behind persistence queue.
+ *
+ * Request threads enqueue events and return immediately; a single writer thread
+ * drains them in batches, coalescing repeated updates of the same game or player.
+ * With a WAL path set, enqueue only returns once the event is fsynced to a local
+ * log, and the log is replayed by the next queue started on the same path.
+ * Threads enqueueing together share one fsync, taken outside the queue lock.
+ * A batch the sink keeps refusing is set aside after maxAttempts, to a ".dead"
+ * file next to the WAL or else to the error log, so it cannot stall the queue.
+ */
+class WriteBehindQueue {
+    public:
+        WriteBehindQueue(PersistenceSink& sink, const WriteBehindConfig& config);
+        ~WriteBehindQueue();
+
+        WriteBehindQueue(const WriteBehindQueue&) = delete;
+        WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+        void enqueue(PersistEvent event);
+        // Blocks until everything enqueued so far has been written
+        void flush();
+        WriteBehindStats getStats() const;
+
+        // Keeps the last update per game and per player, everything else in order
+        static std::vector<PersistEvent> coalesce(const std::vector<PersistEvent>& events);
+
+    private:
+        void _run();
+        // False if the queue stopped before the batch was written or dead-lettered
+        bool _writeBatch(const std::vector<PersistEvent>& batch);
+        void _deadLetter(const std::vector<PersistEvent>& events);
+        void _openWal(bool truncate);
+        void _appendWal(const PersistEvent& event);
+        void _syncWal(uint64_t walSequence);
+        void _rotateWal();
+        void _recoverWal();
+
+        PersistenceSink& sink_;
+        const WriteBehindConfig config_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable hasWork_;
+        std::condition_variable hasRoom_;
+        std::condition_variable isDrained_;
+        std::deque<PersistEvent> pending_;
+        std::chrono::steady_clock::time_point oldestPending_;
+        bool isWriting_ = false;
+        bool isFlushRequested_ = false;
+        bool isStopping_ = false;
+        WriteBehindStats stats_{};
+
+        int walFd_ = -1;
+        uint64_t walWritten_ = 0;   // Records written to the WAL so far, counting from 1
+        uint64_t walSynced_ = 0;    // Records known to be on disk
+        std::mutex walSyncMutex_;   // Taken before mutex_, by the one producer fsyncing at a time
+        std::thread writer_;
+};
+
+
+// Prometheus text exposition of the queue's depth and counters, under the given metric prefix
+inline void writeQueueMetrics(std::ostream& out, const std::string& prefix, const WriteBehindStats& stats) {
+    out << "# TYPE " << prefix << "_depth gauge\n" << prefix << "_depth " << stats.depth << "\n"
+        << "# TYPE " << prefix << "_enqueued_total counter\n" << prefix << "_enqueued_total " << stats.enqueued << "\n"
+        << "# TYPE " << prefix << "_written_total counter\n" << prefix << "_written_total " << stats.written << "\n"
+        << "# TYPE " << prefix << "_coalesced_total counter\n" << prefix << "_coalesced_total " << stats.coalesced << "\n"
+        << "# TYPE " << prefix << "_batches_total counter\n" << prefix << "_batches_total " << stats.batches << "\n"
+        << "# TYPE " << prefix << "_failures_total counter\n" << prefix << "_failures_total " << stats.failures << "\n"
+        << "# TYPE " << prefix << "_dead_lettered_total counter\n" << prefix << "_dead_lettered_total " << stats.deadLettered << "\n";
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "bitboard.h"
+
+/*
+ * Zobrist keys. A position's key is the XOR of one key per (color, piece type, square),
+ * one per castling-rights combination, one per en passant file and one when black is to
+ * move. The keys are generated at compile time from a fixed seed, so hashes are stable
+ * across runs and can be persisted.
+ */
+
+#define ZOBRIST_PIECE_KEYS (2 * 7 * NUMBER_OF_SQUARES)
+
+using ZobristKey = uint64_t;
+
+// SplitMix64: every output of a full-period generator is distinct, so no two keys collide
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct ZobristTables {
+    std::array<ZobristKey, ZOBRIST_PIECE_KEYS> pieces{};
+    std::array<ZobristKey, 16> castling{};
+    std::array<ZobristKey, 8> enPassantFile{};
+    ZobristKey blackToMove = 0;
+};
+
+constexpr ZobristTables makeZobristTables() {
+    ZobristTables tables;
+    uint64_t state = 0x5EED0F0C4E55ULL;
+    for (ZobristKey& key : tables.pieces) {key = splitMix64(state);}
+    for (ZobristKey& key : tables.castling) {key = splitMix64(state);}
+    for (ZobristKey& key : tables.enPassantFile) {key = splitMix64(state);}
+    tables.blackToMove = splitMix64(state);
+    return tables;
+}
+
+inline constexpr ZobristTables ZOBRIST = makeZobristTables();
+
+// Key for a piece of the given color and type (both as their enum values) on `square`
+inline ZobristKey zobristPiece(int color, int type, int square) {
+    return ZOBRIST.pieces[(color * 7 + type) * NUMBER_OF_SQUARES + square];
+}
@@ -33,22 +33,85 @@ export default function Game() {
     const [home, setHome] = useState(false);
 
     const intervalRef = useRef();
+    const socketRef = useRef();
+    const boardVersionRef = useRef(null);
+
+    const fetchData = async () => {
+        const response = await fetch(apiBaseUrl + '/snapshot', {
+            method: 'GET',
+            credentials: 'include',
+        });
+        if (!response.ok) {
+            // No game yet, so only the state is worth asking for
+            await fetchGameState();
+            return;
+        }
+        const data = await response.json();
+        const fetchedGameState = GameStateLookup[data.status];
+        console.log("GameState: " + fetchedGameState);
+        setGameID(data.gameID);
+        if (gameState !== fetchedGameState) {
+            setGameState(fetchedGameState);
+        }
+        if (fetchedGameState !== GameState.WAITING_FOR_OPPONENT && fetchedGameState !== GameState.ENDED) {
+            setHome(false);
+            setBoard(transformBoard(data.squares));
+            ColorLookup[data.playerColor] === Color.WHITE ? setPlayer(whitePlayer) : setPlayer(blackPlayer);
+            setHorcruxGuessLeft(data.horcruxGuessesLeft);
+            setHorcruxsStatus({
+                WHITE: {
+                    hasBeenGuessed: data.horcruxStatus.whiteHasBeenGuessed,
+                    id: data.horcruxStatus.whiteHasBeenGuessed ? data.horcruxStatus.whiteFoundID : null
+                },
+                BLACK: {
+                    hasBeenGuessed: data.horcruxStatus.blackHasBeenGuessed,
+                    id: data.horcruxStatus.blackHasBeenGuessed ? data.horcruxStatus.blackFoundID : null
+                },
+                playerHorcruxID: data.horcruxStatus.horcruxID
+            });
+        }
+    };
+
+    const isGameOver = gameState === GameState.ENDED;
 
     useEffect(() => {
-        const fetchData = async () => {
-            await fetchGameID();
-            const fetchedGameState = await fetchGameState();
-            console.log("GameState: " + fetchedGameState);
-            if (fetchedGameState !== GameState.WAITING_FOR_OPPONENT && fetchedGameState !== GameState.ENDED) {
-                setHome(false);
-                await fetchBoard();
-                await fetchPlayer();
-                await fetchNumberOfHorcruxGuessesLeft();
-                await fetchHorcruxStatus();
-            }
+        // The server pushes an event whenever the game changes, so data is only refetched then.
+        // It refuses the socket until the cookies name a game, so this waits for the game ID,
+        // and it reconnects with backoff after a drop while the poll below fills in.
+        if (!gameID || isGameOver) return;
+        let socket;
+        let retryTimeout;
+        let retryDelay = 500;
+        let isUnmounted = false;
+
+        const connect = () => {
+            socket = new WebSocket(apiBaseUrl.replace(/^http/, 'ws') + '/ws');
+            // The server's first message on every connection is the current state, which triggers a refetch
+            socket.onopen = () => {retryDelay = 500;};
+            socket.onmessage = () => fetchData();
+            socket.onclose = () => {
+                if (isUnmounted) return;
+                retryTimeout = setTimeout(connect, retryDelay);
+                retryDelay = Math.min(retryDelay * 2, 10000);
+            };
+            socketRef.current = socket;
         };
-    
-        intervalRef.current = setInterval(fetchData, 2000); // Poll every 2 seconds
+        connect();
+
+        return () => {
+            isUnmounted = true;
+            clearTimeout(retryTimeout);
+            socket.close();
+        };
+    }, [gameID, isGameOver]);
+
+    useEffect(() => {
+        // Poll every 2 seconds only while the push channel is down
+        intervalRef.current = setInterval(() => {
+            if (!socketRef.current || socketRef.current.readyState !== WebSocket.OPEN) {
+                fetchData();
+            }
+        }, 2000);
     
         let timeoutRef;
         if (gameState === GameState.ENDED) {
@@ -91,13 +154,26 @@ export default function Game() {
     }
 
     const fetchBoard = async () => {
-        const response = await fetch(apiBaseUrl + '/board', {
+        // Only the squares changed since the board we hold come back, unless we are too far behind
+        const known = boardVersionRef.current;
+        const query = known ? '?since=' + known.version + '&run=' + known.run : '';
+        const response = await fetch(apiBaseUrl + '/board' + query, {
             method: 'GET', 
             credentials: 'include',
         });
         if (!response.ok) console.log('Network response was not ok');
         const data = await response.json();
-        const transformedBoard = transformBoard(data.squares);
+
+        let transformedBoard;
+        if (!known || data.full) {
+            transformedBoard = transformBoard(data.squares);
+        } else {
+            transformedBoard = board.map(row => row.slice());
+            transformBoard(data.changes).forEach(row => row.forEach(square => {
+                if (square) transformedBoard[8 - square.rank][square.file.charCodeAt(0) - 'a'.charCodeAt(0)] = square;
+            }));
+        }
+        boardVersionRef.current = { version: data.version, run: data.run };
         setBoard(transformedBoard);
         return transformedBoard;
     }
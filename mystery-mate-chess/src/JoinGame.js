@@ -28,16 +28,15 @@ export default function JoinGame() {
 
             if (data.status == ErrorStatus) throw new Error(data.message);
             if (data.status != GameState.WHITE_MOVE) throw new Error('Game is not waiting for opponent');
-
-            joinedGame = true;
         } catch (error) {
             console.error('There was a problem with the fetch operation:', error);
         }
     }
 
-    const handleJoinButtonClick = () => {
+    const handleJoinButtonClick = async () => {
+        // The game's push socket needs the cookies the join sets, so it only mounts once the join is done
+        await joinGame();
         setJoinedGame(true);
-        joinGame();
     }
     
     return (
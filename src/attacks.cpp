@@ -0,0 +1,216 @@
+#include "attacks.h"
+#include <vector>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H = FILE_A << 7;
+constexpr Bitboard RANK_1 = 0xFFULL;
+constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+constexpr std::array<Offset, 4> ROOK_DIRECTIONS = {{{0, 1}, {0, -1}, {1, 0}, {-1, 0}}};
+constexpr std::array<Offset, 4> BISHOP_DIRECTIONS = {{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+
+// Walks each ray until it leaves the board or hits a blocker, blocker included
+Bitboard slidingAttacks(int square, Bitboard occupied, const std::array<Offset, 4>& directions) {
+    Bitboard attacks = EMPTY_BITBOARD;
+    for (const Offset& direction : directions) {
+        int file = fileOf(square) + direction.file;
+        int rank = rankOf(square) + direction.rank;
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            Bitboard bit = squareBit(squareIndex(file, rank));
+            attacks |= bit;
+            if (occupied & bit) {break;}
+            file += direction.file;
+            rank += direction.rank;
+        }
+    }
+    return attacks;
+}
+
+struct Magic {
+    Bitboard mask = EMPTY_BITBOARD;
+    Bitboard magic = EMPTY_BITBOARD;
+    Bitboard* attacks = nullptr;
+    unsigned shift = 0;
+
+    unsigned index(Bitboard occupied) const {
+#ifdef __BMI2__
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+// Per-rank seeds known to find every magic after few attempts
+constexpr uint64_t MAGIC_SEEDS[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+// xorshift64*, seeded so the magics (and therefore the table layout) are reproducible
+class MagicRng {
+    public:
+        explicit MagicRng(uint64_t seed) : state_(seed) {}
+
+        uint64_t next() {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return state_ * 2685821657736338717ULL;
+        }
+
+        // Candidates with few set bits make good magics
+        uint64_t sparse() {return next() & next() & next();}
+
+    private:
+        uint64_t state_;
+};
+
+class SliderTables {
+    public:
+        SliderTables() : rookTable_(0x19000), bishopTable_(0x1480) {
+            initMagics_(rookMagics_, rookTable_.data(), ROOK_DIRECTIONS);
+            initMagics_(bishopMagics_, bishopTable_.data(), BISHOP_DIRECTIONS);
+            initLines_();
+        }
+
+        Bitboard rook(int square, Bitboard occupied) const {
+            const Magic& m = rookMagics_[square];
+            return m.attacks[m.index(occupied)];
+        }
+
+        Bitboard bishop(int square, Bitboard occupied) const {
+            const Magic& m = bishopMagics_[square];
+            return m.attacks[m.index(occupied)];
+        }
+
+        Bitboard between(int from, int to) const {return between_[from][to];}
+        Bitboard line(int from, int to) const {return line_[from][to];}
+
+    private:
+        void initMagics_(Magic* magics, Bitboard* table, const std::array<Offset, 4>& directions) {
+            std::vector<Bitboard> occupancy(4096);
+            std::vector<Bitboard> reference(4096);
+            std::vector<int> epoch(4096, 0);
+            int attempt = 0;
+            Bitboard* next = table;
+
+            for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+                // Board edges never block a ray, so they are left out of the mask
+                Bitboard edges = ((RANK_1 | RANK_8) & ~(RANK_1 << (8 * rankOf(square)))) |
+                                 ((FILE_A | FILE_H) & ~(FILE_A << fileOf(square)));
+
+                Magic& m = magics[square];
+                m.mask = slidingAttacks(square, EMPTY_BITBOARD, directions) & ~edges;
+                m.shift = 64 - popCount(m.mask);
+                m.attacks = next;
+
+                // Enumerate every subset of the mask (Carry-Rippler)
+                int size = 0;
+                Bitboard subset = EMPTY_BITBOARD;
+                do {
+                    occupancy[size] = subset;
+                    reference[size] = slidingAttacks(square, subset, directions);
+#ifdef __BMI2__
+                    m.attacks[_pext_u64(subset, m.mask)] = reference[size];
+#endif
+                    size++;
+                    subset = (subset - m.mask) & m.mask;
+                } while (subset);
+                next += size;
+
+#ifndef __BMI2__
+                MagicRng rng(MAGIC_SEEDS[rankOf(square)]);
+                for (int i = 0; i < size; ) {
+                    for (m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6; ) {
+                        m.magic = rng.sparse();
+                    }
+                    // A magic is good if no two occupancies with different attacks collide
+                    for (++attempt, i = 0; i < size; ++i) {
+                        unsigned idx = m.index(occupancy[i]);
+                        if (epoch[idx] < attempt) {
+                            epoch[idx] = attempt;
+                            m.attacks[idx] = reference[i];
+                        } else if (m.attacks[idx] != reference[i]) {
+                            break;
+                        }
+                    }
+                }
+#endif
+            }
+        }
+
+        void initLines_() {
+            for (int from = 0; from < NUMBER_OF_SQUARES; ++from) {
+                for (int to = 0; to < NUMBER_OF_SQUARES; ++to) {
+                    between_[from][to] = EMPTY_BITBOARD;
+                    line_[from][to] = EMPTY_BITBOARD;
+                    if (from == to) {continue;}
+
+                    for (const auto* directions : {&ROOK_DIRECTIONS, &BISHOP_DIRECTIONS}) {
+                        if (slidingAttacks(from, EMPTY_BITBOARD, *directions) & squareBit(to)) {
+                            between_[from][to] = slidingAttacks(from, squareBit(to), *directions) &
+                                                 slidingAttacks(to, squareBit(from), *directions);
+                            line_[from][to] = (slidingAttacks(from, EMPTY_BITBOARD, *directions) &
+                                               slidingAttacks(to, EMPTY_BITBOARD, *directions)) |
+                                              squareBit(from) | squareBit(to);
+                        }
+                    }
+                }
+            }
+        }
+
+        Magic rookMagics_[NUMBER_OF_SQUARES];
+        Magic bishopMagics_[NUMBER_OF_SQUARES];
+        std::vector<Bitboard> rookTable_;
+        std::vector<Bitboard> bishopTable_;
+        Bitboard between_[NUMBER_OF_SQUARES][NUMBER_OF_SQUARES];
+        Bitboard line_[NUMBER_OF_SQUARES][NUMBER_OF_SQUARES];
+};
+
+const SliderTables& sliderTables() {
+    static const SliderTables tables;
+    return tables;
+}
+
+} // namespace
+
+
+Bitboard rookAttacks(int square, Bitboard occupied) {
+    return sliderTables().rook(square, occupied);
+}
+
+
+Bitboard bishopAttacks(int square, Bitboard occupied) {
+    return sliderTables().bishop(square, occupied);
+}
+
+
+Bitboard betweenMask(int from, int to) {
+    return sliderTables().between(from, to);
+}
+
+
+Bitboard lineMask(int from, int to) {
+    return sliderTables().line(from, to);
+}
+
+
+Bitboard pieceAttacks(PieceType type, int square, Bitboard occupied) {
+    switch (type) {
+        case PieceType::KNIGHT:
+            return knightAttacks(square);
+        case PieceType::BISHOP:
+            return bishopAttacks(square, occupied);
+        case PieceType::ROOK:
+            return rookAttacks(square, occupied);
+        case PieceType::QUEEN:
+            return queenAttacks(square, occupied);
+        case PieceType::KING:
+            return kingAttacks(square);
+        default:
+            return EMPTY_BITBOARD;
+    }
+}
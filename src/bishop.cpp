@@ -1,29 +1,24 @@
 #include "bishop.h"
+#include "move_list.h"
+#include "attacks.h"
 
 std::unordered_set<Position> Bishop::getPossiblePositions(const Position& from) const {
-    std::unordered_set<Position> positions;
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return {};}
 
-    // Directions for diagonal movements
-    std::vector<std::pair<int, int>> directions = {
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-    };
+    return toPositions(bishopAttacks(square, EMPTY_BITBOARD));
+}
 
-    // Diagonal movements
-    for (const auto& direction : directions) {
-        for (int i = 1; i < GRID_SIZE; ++i) {
-            int newFile = charToFile(from.getFile()) + i * direction.first;
-            int newRank = from.getRank() + i * direction.second;
-            if (newFile >= charToFile('a') && newFile <= charToFile('h') && newRank >= 1 && newRank <= GRID_SIZE) {
-                positions.emplace(fileToChar(newFile), newRank);
-            }
-        }
-    }
+void Bishop::getPossibleMoves(const Position& from, MoveList& moves) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return;}
 
-    return positions;
+    moves.addMoves(square, bishopAttacks(square, EMPTY_BITBOARD), EMPTY_BITBOARD);
 }
 
 bool Bishop::isValidMove(const Move& move) const {
-    std::unordered_set possiblePositions = getPossiblePositions(move.getFrom());
+    int from = toSquare(move.getFrom());
+    if (from == NO_SQUARE) {return false;}
 
-    return possiblePositions.find(move.getTo()) != possiblePositions.end();
+    return containsPosition(bishopAttacks(from, EMPTY_BITBOARD), move.getTo());
 };
\ No newline at end of file
@@ -1,25 +1,14 @@
 #include "board.h"
+#include "attacks.h"
 
 Board::Board() {
-    for(int rank = 1; rank <= GRID_SIZE; ++rank) {
-        for(char file = 'a'; file <= 'h'; ++file) {
-            squares[Position(file, rank)] = std::make_unique<Square>(Position(file, rank));
-        }
-    }
+    createSquares_();
 };
 
 
 Board::Board(const Board& other) {
-    for (int rank = 1; rank <= GRID_SIZE; ++rank) {
-        for (char file = 'a'; file <= 'h'; ++file) {
-            const Position pos(file, rank);
-            squares[pos] = std::make_unique<Square>(pos);
-            if (other.squares.at(pos)->getPiece()) {
-                IPiece* pClonedPiece = other.squares.at(pos)->getPiece()->clone();
-                squares.at(pos)->placePiece(pClonedPiece);
-            }
-        }
-    }
+    createSquares_();
+    copyPieces_(other);
 };
 
 
@@ -27,49 +16,280 @@ Board& Board::operator=(const Board& other) {
     // Handle self-assignment
     if (this == &other) {return *this;}
 
-    squares.clear();
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        clearPiece_(square);
+    }
+    ownedPieces_.clear();
+    copyPieces_(other);
+
+    return *this;
+}
+
+
+void Board::createSquares_() {
+    pieceSquares_.fill(NO_SQUARE);
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        const Position pos = toPosition(square);
+        auto pSquare = std::make_unique<Square>(pos, this);
+        squareViews_[square] = pSquare.get();
+        squares[pos] = std::move(pSquare);
+    }
+}
+
+
+void Board::copyPieces_(const Board& other) {
+    Bitboard occupied = other.getOccupancy();
+    while (occupied) {
+        int square = popLsb(occupied);
+        ownedPieces_.emplace_back(other.mailbox_[square]->clone());
+        setPiece_(square, ownedPieces_.back().get());
+        setPieceType_(square, other.getPieceType(square));
+    }
+    setCastlingRights(other.castlingRights_);
+    setEnPassantSquare(other.enPassantSquare_);
+    setSideToMove(other.sideToMove_);
+}
+
+
+void Board::setPiece_(int square, const IPiece* piece) {
+    if (!piece) {
+        clearPiece_(square);
+        return;
+    }
+    if (mailbox_[square]) {
+        clearPiece_(square);
+    }
+
+    const Bitboard bit = squareBit(square);
+    mailbox_[square] = piece;
+    if (isIndexedID_(piece->getID())) {
+        pieceSquares_[piece->getID()] = static_cast<int8_t>(square);
+    }
+    colorBB_[static_cast<int>(piece->getColor())] |= bit;
+    typeBB_[static_cast<int>(piece->getType())] |= bit;
+    squareViews_[square]->pPiece_ = piece;
+    key_ ^= zobristPiece(static_cast<int>(piece->getColor()), static_cast<int>(piece->getType()), square);
+}
+
+
+void Board::clearPiece_(int square) {
+    const IPiece* piece = mailbox_[square];
+    if (!piece) {return;}
+
+    const Bitboard bit = squareBit(square);
+    const int type = static_cast<int>(getPieceType(square));
+    key_ ^= zobristPiece(static_cast<int>(piece->getColor()), type, square);
+    colorBB_[static_cast<int>(piece->getColor())] &= ~bit;
+    typeBB_[type] &= ~bit;
+    mailbox_[square] = nullptr;
+    squareViews_[square]->pPiece_ = nullptr;
+    if (isIndexedID_(piece->getID()) && pieceSquares_[piece->getID()] == square) {
+        pieceSquares_[piece->getID()] = NO_SQUARE;
+    }
+}
+
+
+void Board::movePiece_(int from, int to) {
+    const IPiece* piece = mailbox_[from];
+    const Bitboard fromTo = squareBit(from) | squareBit(to);
+    const int color = static_cast<int>(piece->getColor());
+    const int type = static_cast<int>(getPieceType(from));
+    key_ ^= zobristPiece(color, type, from) ^ zobristPiece(color, type, to);
+    colorBB_[color] ^= fromTo;
+    typeBB_[type] ^= fromTo;
+    mailbox_[to] = piece;
+    mailbox_[from] = nullptr;
+    squareViews_[to]->pPiece_ = piece;
+    squareViews_[from]->pPiece_ = nullptr;
+    if (isIndexedID_(piece->getID())) {
+        pieceSquares_[piece->getID()] = static_cast<int8_t>(to);
+    }
+}
+
+
+void Board::setPieceType_(int square, PieceType type) {
+    const Bitboard bit = squareBit(square);
+    const int color = static_cast<int>(mailbox_[square]->getColor());
+    const int oldType = static_cast<int>(getPieceType(square));
+    key_ ^= zobristPiece(color, oldType, square) ^ zobristPiece(color, static_cast<int>(type), square);
+    typeBB_[oldType] &= ~bit;
+    typeBB_[static_cast<int>(type)] |= bit;
+}
+
+
+void Board::setCastlingRights(uint8_t rights) {
+    key_ ^= ZOBRIST.castling[castlingRights_] ^ ZOBRIST.castling[rights];
+    castlingRights_ = rights;
+}
+
+
+void Board::setEnPassantSquare(int square) {
+    if (enPassantSquare_ != NO_SQUARE) {key_ ^= ZOBRIST.enPassantFile[fileOf(enPassantSquare_)];}
+    if (square != NO_SQUARE) {key_ ^= ZOBRIST.enPassantFile[fileOf(square)];}
+    enPassantSquare_ = square;
+}
+
+
+void Board::setSideToMove(Color color) {
+    if (color != sideToMove_) {key_ ^= ZOBRIST.blackToMove;}
+    sideToMove_ = color;
+}
+
+
+ZobristKey Board::computeZobristKey() const {
+    ZobristKey key = ZOBRIST.castling[castlingRights_];
+    if (enPassantSquare_ != NO_SQUARE) {key ^= ZOBRIST.enPassantFile[fileOf(enPassantSquare_)];}
+    if (sideToMove_ == Color::BLACK) {key ^= ZOBRIST.blackToMove;}
+
+    Bitboard occupied = getOccupancy();
+    while (occupied) {
+        int square = popLsb(occupied);
+        key ^= zobristPiece(static_cast<int>(mailbox_[square]->getColor()), static_cast<int>(getPieceType(square)), square);
+    }
+    return key;
+}
+
+
+PieceType Board::getPieceType(int square) const {
+    const Bitboard bit = squareBit(square);
+    for (int type = 0; type < NUMBER_OF_PIECE_TYPES; ++type) {
+        if (typeBB_[type] & bit) {return static_cast<PieceType>(type);}
+    }
+    throw std::logic_error("Square is not occupied");
+}
+
+
+namespace {
+
+// Castling rights that survive a move touching each square
+constexpr std::array<uint8_t, NUMBER_OF_SQUARES> makeCastlingMasks() {
+    std::array<uint8_t, NUMBER_OF_SQUARES> masks{};
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        masks[square] = ALL_CASTLING_RIGHTS;
+    }
+    masks[squareIndex(0, 0)] &= ~WHITE_QUEEN_SIDE_CASTLE;
+    masks[squareIndex(7, 0)] &= ~WHITE_KING_SIDE_CASTLE;
+    masks[squareIndex(4, 0)] &= ~(WHITE_KING_SIDE_CASTLE | WHITE_QUEEN_SIDE_CASTLE);
+    masks[squareIndex(0, 7)] &= ~BLACK_QUEEN_SIDE_CASTLE;
+    masks[squareIndex(7, 7)] &= ~BLACK_KING_SIDE_CASTLE;
+    masks[squareIndex(4, 7)] &= ~(BLACK_KING_SIDE_CASTLE | BLACK_QUEEN_SIDE_CASTLE);
+    return masks;
+}
+
+constexpr std::array<uint8_t, NUMBER_OF_SQUARES> CASTLING_MASKS = makeCastlingMasks();
+
+}
+
 
-    for (int rank = 1; rank <= GRID_SIZE; ++rank) {
-        for (char file = 'a'; file <= 'h'; ++file) {
-            const Position pos(file, rank);
+UndoRecord Board::makeMove(CompactMove move) {
+    const int from = move.getFrom();
+    const int to = move.getTo();
+    const MoveFlag flag = move.getFlag();
+
+    int capturedSquare = (flag == MoveFlag::EN_PASSANT) ? squareIndex(fileOf(to), rankOf(from)) : to;
+    UndoRecord undo{mailbox_[capturedSquare], PieceType::MOCK, static_cast<int8_t>(capturedSquare),
+                    static_cast<int8_t>(enPassantSquare_), castlingRights_, key_};
+
+    if (undo.captured) {
+        undo.capturedType = getPieceType(capturedSquare);
+        clearPiece_(capturedSquare);
+    }
+    movePiece_(from, to);
+
+    if (move.isPromotion()) {
+        setPieceType_(to, move.getPromotionType());
+    } else if (move.isCastling()) {
+        const int rank = rankOf(from);
+        const bool isKingSide = flag == MoveFlag::KING_CASTLE;
+        movePiece_(squareIndex(isKingSide ? 7 : 0, rank), squareIndex(isKingSide ? 5 : 3, rank));
+    }
 
-            squares[pos] = std::make_unique<Square>(pos);
+    recordMove(move);
 
-            if (other.squares.at(pos)->getPiece()) {
-                IPiece* pClonedPiece = other.squares.at(pos)->getPiece()->clone();
-                squares.at(pos)->placePiece(pClonedPiece);
-            }
+    return undo;
+}
+
+
+void Board::recordMove(CompactMove move) {
+    const int from = move.getFrom();
+    const int to = move.getTo();
+    // The piece has already been moved, so its color tells whose turn it was
+    const Color moverColor = mailbox_[to] ? mailbox_[to]->getColor() : sideToMove_;
+    const Color opponentColor = (moverColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+    int enPassantSquare = NO_SQUARE;
+    if (move.getFlag() == MoveFlag::DOUBLE_PAWN_PUSH) {
+        const int skipped = (from + to) / 2;
+        if (pawnAttacks(moverColor, skipped) & getPieces(opponentColor, PieceType::PAWN)) {
+            enPassantSquare = skipped;
         }
     }
+    setEnPassantSquare(enPassantSquare);
+    setCastlingRights(castlingRights_ & CASTLING_MASKS[from] & CASTLING_MASKS[to]);
+    setSideToMove(opponentColor);
+}
 
-    return *this;
+
+void Board::unmakeMove(CompactMove move, const UndoRecord& undo) {
+    const int from = move.getFrom();
+    const int to = move.getTo();
+
+    if (move.isPromotion()) {
+        setPieceType_(to, PieceType::PAWN);
+    } else if (move.isCastling()) {
+        const int rank = rankOf(from);
+        const bool isKingSide = move.getFlag() == MoveFlag::KING_CASTLE;
+        movePiece_(squareIndex(isKingSide ? 5 : 3, rank), squareIndex(isKingSide ? 7 : 0, rank));
+    }
+    movePiece_(to, from);
+
+    if (undo.captured) {
+        setPiece_(undo.capturedSquare, undo.captured);
+        setPieceType_(undo.capturedSquare, undo.capturedType);
+    }
+    enPassantSquare_ = undo.enPassantSquare;
+    castlingRights_ = undo.castlingRights;
+    sideToMove_ = mailbox_[from]->getColor();
+    key_ = undo.key;
 }
 
 
 void Board::placePiece(const Position& position, const IPiece* piece) {
-    auto it = squares.find(position);
-    if (it != squares.end()) {
-        it->second->placePiece(piece);
-    } else {
+    int square = toSquare(position);
+    if (square == NO_SQUARE) {
         throw std::logic_error("Invalid square position");
     }
+    if (mailbox_[square]) {
+        throw std::logic_error("Square already occupied");
+    }
+    setPiece_(square, piece);
 };
 
 
+void Board::adoptPiece(const Position& position, std::unique_ptr<IPiece> piece) {
+    placePiece(position, piece.get());
+    ownedPieces_.push_back(std::move(piece));
+}
+
+
 Square* Board::getSquare(const Position& position) const {
-    auto it = squares.find(position);
-    if (it != squares.end()) {
-        return it->second.get();
-    } else {
-        return nullptr;
-    }
+    int square = toSquare(position);
+    return square == NO_SQUARE ? nullptr : squareViews_[square];
 };
 
 Square* Board::findSquare(int pieceID) const {
-    for (const auto& [position, pSquare] : squares) {
-        const IPiece* foundPiece = pSquare->getPiece();
-        if (foundPiece && pieceID == foundPiece->getID()) {
-            return pSquare.get();
+    if (isIndexedID_(pieceID)) {
+        const int square = pieceSquares_[pieceID];
+        if (square == NO_SQUARE) {throw std::logic_error("Piece not found.");}
+        return squareViews_[square];
+    }
+
+    // IDs outside the game's range are not indexed
+    Bitboard occupied = getOccupancy();
+    while (occupied) {
+        int square = popLsb(occupied);
+        if (mailbox_[square]->getID() == pieceID) {
+            return squareViews_[square];
         }
     }
 
@@ -87,7 +307,7 @@ void Board::removePiece(Square* pSquare) {
 
 
 bool Board::isInsideBoard_(const Position& position) const {
-    return squares.find(position) != squares.end();
+    return isOnBoard(position);
 }
 
 
@@ -95,115 +315,62 @@ bool Board::isObstructed(const Position& from, const Position& to, PieceType pie
     if (pieceType == PieceType::KNIGHT) {
         return false;
     }
-    // If the move is horizontal
-    if (from.getRank() == to.getRank()) {
-        return isObstructedBetweenFile_(from, to);
-    }
-    // If the move is vertical
-    else if (from.getFile() == to.getFile()) {
-        return isObstructedBetweenRank_(from, to);
-    }
-    // If the move is diagonal (implement a similar method for diagonal obstructions)
-    else {
-        return isObstructedDiagonally_(from, to);
+    int fromSq = toSquare(from);
+    int toSq = toSquare(to);
+    if (fromSq == NO_SQUARE || toSq == NO_SQUARE) {
+        return false;
     }
+    return (betweenMask(fromSq, toSq) & getOccupancy()) != EMPTY_BITBOARD;
 }
 
+bool Board::isAttackedPosition(const Position& position, const Color playerColor) const {
+    int square = toSquare(position);
+    if (square == NO_SQUARE) {return false;}
 
-bool Board::isObstructedBetweenRank_(const Position& from, const Position& to) const {
-    int fromRank = from.getRank();
-    int toRank = to.getRank();
-    char file = from.getFile();
-
-    int step = (fromRank < toRank) ? 1 : -1;
-
-    for (int rank = fromRank + step; rank != toRank; rank += step) {
-        auto it = squares.find(Position(file, rank));
-        if (it != squares.end() && it->second->isOccupied()) {
-            return true; // If a square is occupied, then there's an obstruction
-        }
-    }
-    return false;
-};
-
-
-bool Board::isObstructedBetweenFile_(const Position& from, const Position& to) const {
-    char fromFile = from.getFile();
-    char toFile = to.getFile();
-    int rank = from.getRank();
-
-    int step = (fromFile < toFile) ? 1 : -1;
-
-    for (char file = fromFile + step; file != toFile; file += step) {
-        auto it = squares.find(Position(file, rank));
-        if (it != squares.end() && it->second->isOccupied()) {
-            return true; // If a square is occupied, then there's an obstruction
-        }
-    }
-    return false;
-};
-
-bool Board::isObstructedDiagonally_(const Position& from, const Position& to) const {
-    int fromRank = from.getRank();
-    int toRank = to.getRank();
-    char fromFile = from.getFile();
-    char toFile = to.getFile();
+    Color opponentColor = (playerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    return isSquareAttacked(square, opponentColor);
+}
 
-    // Determine the step direction for both file and rank
-    int fileStep = (fromFile < toFile) ? 1 : -1;
-    int rankStep = (fromRank < toRank) ? 1 : -1;
+bool Board::isSquareAttacked(int square, Color byColor) const {
+    const Bitboard attackers = getOccupancy(byColor);
+    const Color defenderColor = (byColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
 
-    // Start from the next square to avoid checking the square where the piece currently is
-    char file = fromFile + fileStep;
-    int rank = fromRank + rankStep;
+    // A pawn attacks `square` exactly when a defending pawn on `square` would attack it back
+    if (pawnAttacks(defenderColor, square) & attackers & getPieces(PieceType::PAWN)) {return true;}
+    if (knightAttacks(square) & attackers & getPieces(PieceType::KNIGHT)) {return true;}
+    if (kingAttacks(square) & attackers & getPieces(PieceType::KING)) {return true;}
 
-    while (file != toFile && rank != toRank) {
-        auto it = squares.find(Position(file, rank));
-        if (it != squares.end() && it->second->isOccupied()) {
-            return true; // If a square is occupied, then there's an obstruction
-        }
-
-        file += fileStep;
-        rank += rankStep;
-    }
-    return false;
+    const Bitboard occupied = getOccupancy();
+    const Bitboard queens = getPieces(PieceType::QUEEN);
+    if (bishopAttacks(square, occupied) & attackers & (getPieces(PieceType::BISHOP) | queens)) {return true;}
+    return (rookAttacks(square, occupied) & attackers & (getPieces(PieceType::ROOK) | queens)) != EMPTY_BITBOARD;
 }
 
-bool Board::isAttackedPosition(const Position& position, const Color playerColor) const {
-    Color opponentColor = (playerColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
-    std::unordered_set<Position> attackedPositions = getAttackedPositions_(opponentColor);
 
-    return attackedPositions.find(position) != attackedPositions.end();
+Bitboard Board::getAttackers(int square, Color byColor, Bitboard occupied) const {
+    const Color defenderColor = (byColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard queens = getPieces(PieceType::QUEEN);
+
+    const Bitboard attackers = (pawnAttacks(defenderColor, square) & getPieces(PieceType::PAWN)) |
+                               (knightAttacks(square) & getPieces(PieceType::KNIGHT)) |
+                               (kingAttacks(square) & getPieces(PieceType::KING)) |
+                               (bishopAttacks(square, occupied) & (getPieces(PieceType::BISHOP) | queens)) |
+                               (rookAttacks(square, occupied) & (getPieces(PieceType::ROOK) | queens));
+    return attackers & getOccupancy(byColor) & occupied;
 }
 
-std::unordered_set<Position> Board::getAttackedPositions_(Color color) const {
-    std::unordered_set<Position> attackedPositions;
 
-    for (const auto& [position, pSquare] : squares) {
-        const IPiece* piece = pSquare->getPiece();
-        if (piece && piece->getColor() == color) {
-            std::unordered_set<Position> possiblePositions = piece->getPossiblePositions(position);
-            for (const Position& pos : possiblePositions) {
-                // Check for obstructions
-                if (!isObstructed(position, pos, piece->getType())) {
-                    attackedPositions.insert(pos);
-                }
-            }
-        }
-    }
-    return attackedPositions;
+int Board::getKingSquare(Color color) const {
+    Bitboard kings = getPieces(color, PieceType::KING);
+    return kings ? lsb(kings) : NO_SQUARE;
 }
 
 
 const Position* Board::findKing(Color color) const {
-    for (const auto& [position, pSquare] : squares) {
-        const IPiece* piece = pSquare->getPiece();
-        if (piece && piece->getColor() == color && piece->getType() == PieceType::KING) {
-            return reinterpret_cast<const Position*>(&position);
-        }
-    }
+    int square = getKingSquare(color);
+    if (square == NO_SQUARE) {return nullptr;}
 
-    return nullptr;
+    return &squareViews_[square]->getPosition();
 };
 
 
@@ -1,25 +1,28 @@
 #include "board_rules.h"
-#include "rook.h"
 #include "king.h"
-#include <iostream> 
+#include "attacks.h"
+#include "metrics.h"
+#include "tracing.h"
 
+namespace {
 
-bool BoardRules::isValidMove(const Board& board, const Move& move, const Move& previousMove) {
+// Move generation for a single piece, which every move check and move hint goes through
+LatencyHistogram& moveGenerationDuration() {
+    static LatencyHistogram& histogram = MetricsRegistry::global().histogram("movegen_duration_seconds");
+    return histogram;
+}
 
-    if (move.getPiece()->getType() == PieceType::KING) {
-        if (isValidCastling(board, move)) { return true; }
-    }
-    if (move.getPiece()->getType() == PieceType::PAWN) {
-        if (isValidPromotion(move)) { return true; }
-    }
+} // namespace
 
-    Position to = move.getTo();
-    std::unordered_set<Position> possiblePositions = move.getPiece()->getPossiblePositions(move.getFrom());
 
-    // En Passant checked in addPawnCapturePositions in _availablePositions
-    _availablePositions(board, possiblePositions, move.getFrom(), previousMove);
+bool BoardRules::isValidMove(const Board& board, const Move& move, const Move& previousMove) {
+    int toSquare_ = toSquare(move.getTo());
+    if (toSquare_ == NO_SQUARE) {return false;}
+
+    MoveList legalMoves;
+    generateValidMoves(board, move.getFrom(), previousMove, legalMoves);
 
-    return possiblePositions.find(to) != possiblePositions.end();
+    return legalMoves.contains(toSquare(move.getFrom()), toSquare_);
 };
 
 
@@ -31,45 +34,40 @@ bool BoardRules::isValidCastling(const Board& board, const Move& kingMove) const
         throw std::logic_error("Invalid piece. King expected for castling.");
     }
 
-    // Check if the king or rook has moved, or if the king is in check
-    if (king->getHasMoved() || isInCheck(board, king->getColor())) {
-        return false;
-    }
+    const int homeRank = (king->getColor() == Color::WHITE) ? 0 : GRID_SIZE - 1;
+    if (toSquare(kingMove.getFrom()) != squareIndex(4, homeRank)) {return false;}
 
-    Position kingTo = kingMove.getTo();
-    Position rookFrom, rookTo;
-    bool isKingSide = false;
-
-    // Determine castling type and set rook positions
-    if (king->getColor() == Color::WHITE) {
-        isKingSide = (kingTo == Position('g', 1));
-        rookFrom = isKingSide ? Position('h', 1) : Position('a', 1);
-        rookTo = isKingSide ? Position('f', 1) : Position('d', 1);
-    } else { // Black
-        isKingSide = (kingTo == Position('g', 8));
-        rookFrom = isKingSide ? Position('h', 8) : Position('a', 8);
-        rookTo = isKingSide ? Position('f', 8) : Position('d', 8);
-    }
+    const int kingTo = toSquare(kingMove.getTo());
+    if (kingTo == squareIndex(6, homeRank)) {return _canCastle(board, king->getColor(), true);}
+    if (kingTo == squareIndex(2, homeRank)) {return _canCastle(board, king->getColor(), false);}
+    return false;
+}
+
+
+bool BoardRules::_canCastle(const Board& board, Color color, bool isKingSide) const {
+    const int homeRank = (color == Color::WHITE) ? 0 : GRID_SIZE - 1;
+    const int kingFrom = squareIndex(4, homeRank);
+    const int kingTo = squareIndex(isKingSide ? 6 : 2, homeRank);
+    const int rookFrom = squareIndex(isKingSide ? 7 : 0, homeRank);
 
-    Square* rookSquare = board.getSquare(rookFrom);
-    if (rookSquare == nullptr || rookSquare->getPiece() == nullptr ||
-        rookSquare->getPiece()->getType() != PieceType::ROOK ||
-        dynamic_cast<const Rook*>(rookSquare->getPiece())->getHasMoved()) {
+    uint8_t right = (color == Color::WHITE) ? (isKingSide ? WHITE_KING_SIDE_CASTLE : WHITE_QUEEN_SIDE_CASTLE)
+                                            : (isKingSide ? BLACK_KING_SIDE_CASTLE : BLACK_QUEEN_SIDE_CASTLE);
+    if (!(board.getCastlingRights() & right)) {return false;}
+
+    // Rights are dropped when the king or rook leaves its square, but a board set up by hand may still lack them
+    if (!(board.getPieces(color, PieceType::KING) & squareBit(kingFrom)) ||
+        !(board.getPieces(color, PieceType::ROOK) & squareBit(rookFrom))) {
         return false;
     }
 
     // Ensure no pieces are obstructing the path between the king and rook
-    if (board.isObstructedBetweenFile_(kingMove.getFrom(), rookSquare->getPosition())) {
-        return false;
-    }
+    if (betweenMask(kingFrom, rookFrom) & board.getOccupancy()) {return false;}
 
-    // Check if the squares the king passes through are under attack
-    for (int file = std::min(kingMove.getFrom().getFile(), kingTo.getFile());
-         file <= std::max(kingMove.getFrom().getFile(), kingTo.getFile()); ++file) {
-        Position positionToCheck(static_cast<char>(file), kingMove.getFrom().getRank());
-        if (board.isAttackedPosition(positionToCheck, king->getColor())) {
-            return false;
-        }
+    // The king may not castle out of, through or into check
+    const Color opponentColor = (color == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const int step = isKingSide ? 1 : -1;
+    for (int square = kingFrom; square != kingTo + step; square += step) {
+        if (board.isSquareAttacked(square, opponentColor)) {return false;}
     }
 
     return true;
@@ -105,9 +103,9 @@ bool BoardRules::isValidEnPassant(const Move& previousMove, const Move& move) co
         return false;
     }
 
-    // Ensure the previous move's pawn is adjacent to the current pawn's starting position
-    if (previousMove.getTo().getFile() != move.getFrom().getFile() ||
-        abs(previousMove.getTo().getRank() - move.getFrom().getRank()) != 1) {
+    // The capturing pawn must stand beside the pawn that just moved and land behind it
+    if (previousMove.getTo().getRank() != move.getFrom().getRank() ||
+        previousMove.getTo().getFile() != move.getTo().getFile()) {
         return false;
     }
 
@@ -115,203 +113,221 @@ bool BoardRules::isValidEnPassant(const Move& previousMove, const Move& move) co
 }
 
 bool BoardRules::isInCheck(const Board& board, const Color kingColor) const {
-    const Position* kingPosition = board.findKing(kingColor);
-    if (!kingPosition) {return false;}
+    int kingSquare = board.getKingSquare(kingColor);
+    if (kingSquare == NO_SQUARE) {return false;}
 
     Color opponentColor = (kingColor == Color::WHITE) ? Color::BLACK : Color::WHITE;
-    std::unordered_set<Position> attackedPositions = board.getAttackedPositions_(opponentColor);
 
-    return attackedPositions.find(*kingPosition) != attackedPositions.end();
+    return board.isSquareAttacked(kingSquare, opponentColor);
 };
 
 
-std::unordered_set<Position> BoardRules::generateValidPositions(const Board& board, const IPiece* piece, const Position& from, const Move& previousMove) {
-    auto it = board.squares.find(from);
-    if (it == board.squares.end()) {
+std::unordered_set<Position> BoardRules::generateValidPositions(const Board& board, const Position& from, const Move& previousMove) {
+    MoveList moves;
+    generateValidMoves(board, from, previousMove, moves);
+    return moves.toPositions();
+}
+
+
+void BoardRules::generateValidMoves(const Board& board, const Position& from, const Move& previousMove, MoveList& moves) {
+    ScopedTimer timer(moveGenerationDuration());
+    TraceSpan span("BoardRules::generateValidMoves");
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {
         throw std::logic_error("Invalid starting position");
     }
-    if (!it->second->isOccupied()) {
+    const IPiece* pieceOnSquare = board.getPiece(square);
+    if (!pieceOnSquare) {
         throw std::logic_error("Current square is not occupied");
     }
-    std::unordered_set<Position> pos = piece->getPossiblePositions(from);
-    _availablePositions(board, pos, from, previousMove);
-    return pos;
+    _generateLegalMoves(board, pieceOnSquare->getColor(), _enPassantSquare(board, previousMove), squareBit(square), moves);
 }
 
-void BoardRules::_addKingCastlingPositions(const Board& board, std::unordered_set<Position>& possiblePositions, const King* king, const Position& from) const {
-    // White King Position
-    if (from == Position('e', 1)) {
-        Position whiteLongCastlePosition = Position('c', 1);
-        Position whiteShortCastlePosition = Position('g', 1);
-        if (isValidCastling(board, Move(king, from, whiteLongCastlePosition))) {
-            possiblePositions.insert(whiteLongCastlePosition);
-        }
-        if (isValidCastling(board, Move(king, from, whiteShortCastlePosition))) {
-            possiblePositions.insert(whiteShortCastlePosition);
-        }
-    // Black King Position
-    } else if (from == Position('e', 8)) {
-        Position blackLongCastlePosition = Position('c', 8);
-        Position blackShortCastlePosition = Position('g', 8);
-        if (isValidCastling(board, Move(king, from, blackLongCastlePosition))) {
-            possiblePositions.insert(blackLongCastlePosition);
-        }
-        if (isValidCastling(board, Move(king, from, blackShortCastlePosition))) {
-            possiblePositions.insert(blackShortCastlePosition);
-        }
-    }
+
+void BoardRules::generateLegalMoves(const Board& board, Color side, MoveList& moves) const {
+    _generateLegalMoves(board, side, board.getEnPassantSquare(), ~EMPTY_BITBOARD, moves);
 }
 
-void BoardRules::_availablePositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& from, const Move& previousMove) {
-    // Have to add castling, en passant to possible available moves set
-    // TODO: Move to Board class
 
-    auto it = board.squares.find(from);
-    if (it == board.squares.end()) {
-        throw std::logic_error("Invalid starting position");
-    }
-    if (!it->second->isOccupied()) {
-        throw std::logic_error("Current square is not occupied");
-    }
-    
-    const IPiece* piece = it->second->getPiece();
-    const auto pieceType = piece->getType();
+int BoardRules::_enPassantSquare(const Board& board, const Move& previousMove) const {
+    if (board.getEnPassantSquare() != NO_SQUARE) {return board.getEnPassantSquare();}
 
-    if (pieceType == PieceType::PAWN) {
-        _addPawnCapturePositions(board, possiblePositions, from, previousMove);
-    } // Repeating in range and is occupied checks?}
+    // Boards that were set up by hand only know about the double push through the previous move
+    const IPiece* piece = previousMove.getPiece();
+    if (!piece || piece->getType() != PieceType::PAWN) {return NO_SQUARE;}
 
-    if (pieceType == PieceType::KING) {
-        _addKingCastlingPositions(board, possiblePositions, dynamic_cast<const King*>(piece), from);
+    int from = toSquare(previousMove.getFrom());
+    int to = toSquare(previousMove.getTo());
+    if (from == NO_SQUARE || to == NO_SQUARE || std::abs(to - from) != 16 || board.getPiece(to) != piece) {
+        return NO_SQUARE;
     }
+    return (from + to) / 2;
+}
 
-    std::vector<Position> toRemove;
-    std::unordered_set<Position> captures; // Note to send this to the frontend in a future update
-
-    for (const auto& pos : possiblePositions) {
-        std::cout << "Possible Positions: " << pos.getFile() << pos.getRank() << std::endl;
-        if (pieceType != PieceType::KNIGHT && board.getSquare(pos)->getPiece()) {
-            // Find direction from `from` to `pos`
-            int deltaX = pos.getFile() - from.getFile();
-            int deltaY = pos.getRank() - from.getRank();
-
-            int stepSizeX = (deltaX != 0) ? (deltaX / abs(deltaX)) : 0;
-            int stepSizeY = (deltaY != 0) ? (deltaY / abs(deltaY)) : 0;
-
-            int currFile = pos.getFile();
-            int currRank = pos.getRank();
-
-            // Check the first obstructed position for a capture possibility
-            auto obstructingSquareIt = board.squares.find(Position(currFile, currRank));
-            if (obstructingSquareIt != board.squares.end() &&
-                obstructingSquareIt->second->isOccupied() &&
-                obstructingSquareIt->second->getPiece()->getColor() != it->second->getPiece()->getColor()) {
-                captures.insert(pos); // This is a possible capture.
-            } else {
-                toRemove.push_back(pos); // Not a capture, so mark for removal.
-            }
 
-            // Move to the next position in the direction of the obstruction
-            currFile += stepSizeX;
-            currRank += stepSizeY;
+Bitboard BoardRules::_pinnedPieces(const Board& board, Color side, int kingSquare) const {
+    const Color opponentColor = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard occupied = board.getOccupancy();
+    const Bitboard queens = board.getPieces(opponentColor, PieceType::QUEEN);
 
-            // Collect all positions beyond the first obstruction as they are not reachable
-            while (board.isInsideBoard_(Position(currFile, currRank))) {
-                toRemove.push_back(Position(currFile, currRank));
-                currFile += stepSizeX;
-                currRank += stepSizeY;
-            }
-        } else if (pieceType == PieceType::KNIGHT) {
-            // Check if the knight's destination is capturable or empty
-            auto destIt = board.squares.find(pos);
-            if (destIt != board.squares.end() && destIt->second->isOccupied()) {
-                if (destIt->second->getPiece()->getColor() != it->second->getPiece()->getColor()) {
-                    captures.insert(pos); // This is a possible capture.
-                } else {
-                    toRemove.push_back(pos); // Square is occupied by a friendly piece, remove from moves.
-                }
-            }
-            // If the destination square is not found in the map, it means it's unoccupied and already a valid move, so do nothing.
-        }
-    }
+    // Enemy sliders that would hit the king on an empty board
+    Bitboard snipers = (rookAttacks(kingSquare, EMPTY_BITBOARD) & (board.getPieces(opponentColor, PieceType::ROOK) | queens)) |
+                       (bishopAttacks(kingSquare, EMPTY_BITBOARD) & (board.getPieces(opponentColor, PieceType::BISHOP) | queens));
 
-    // Now erase all collected positions.
-    for (const auto& pos : toRemove) {
-        possiblePositions.erase(pos);
+    Bitboard pinned = EMPTY_BITBOARD;
+    while (snipers) {
+        Bitboard blockers = betweenMask(kingSquare, popLsb(snipers)) & occupied;
+        if (popCount(blockers) == 1) {
+            pinned |= blockers & board.getOccupancy(side);
+        }
     }
-    
-    if (it->second->getPiece()->getType() == PieceType::KING) {
-        _removeKingInCheckPositions(board, possiblePositions, from);
-        _removeKingInCheckPositions(board, captures, from);
-    } // Repeating in range and is occupied checks?}
-
+    return pinned;
 }
 
 
-void BoardRules::_addPawnCapturePositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& from, const Move& lastMove) const {
-    auto it = board.squares.find(from);
-    if (it == board.squares.end()) { throw std::logic_error("Invalid starting position"); }
-    if (!it->second->isOccupied()) { throw std::logic_error("Current square is not occupied"); }
-    if (it->second->getPiece()->getType() != PieceType::PAWN) { throw std::logic_error("_addPawnCapturePositions is only valid for Pawns"); }
+bool BoardRules::hasLegalMove(const Board& board, Color side) const {
+    const Color opponentColor = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard own = board.getOccupancy(side);
+    const Bitboard occupied = board.getOccupancy();
+    const int kingSquare = board.getKingSquare(side);
 
-    Color pawnColor = it->second->getPiece()->getColor();
-    int forwardDirection = (pawnColor == Color::WHITE) ? 1 : -1;
+    Bitboard checkMask = ~EMPTY_BITBOARD;
+    Bitboard pinned = EMPTY_BITBOARD;
 
-    // Standard diagonal captures
-    for (int fileOffset : {-1, 1}) {
-        char newFile = from.getFile() + fileOffset;
-        int newRank = from.getRank() + forwardDirection;
+    if (kingSquare != NO_SQUARE) {
+        // Castling is never the only legal move: it needs the square the king passes to be safe as well
+        const Bitboard withoutKing = occupied & ~squareBit(kingSquare);
+        Bitboard targets = kingAttacks(kingSquare) & ~own;
+        while (targets) {
+            if (!board.getAttackers(popLsb(targets), opponentColor, withoutKing)) {return true;}
+        }
 
-        auto captureIt = board.squares.find(Position(newFile, newRank));
-        if (captureIt != board.squares.end() && captureIt->second->isOccupied() &&
-            captureIt->second->getPiece()->getColor() != pawnColor) {
-            std::cout << "Add Pawn Capture Positions" << std::endl;
-            possiblePositions.emplace(captureIt->second->getPosition());
+        const Bitboard checkers = board.getAttackers(kingSquare, opponentColor, occupied);
+        if (popCount(checkers) > 1) {return false;}
+        if (checkers) {
+            checkMask = checkers | betweenMask(kingSquare, lsb(checkers));
         }
+        pinned = _pinnedPieces(board, side, kingSquare);
     }
 
-    // En Passant capture
-    Position epCaptureRight(from.getFile() + 1, from.getRank() + forwardDirection);
-    Position epCaptureLeft(from.getFile() - 1, from.getRank() + forwardDirection);
-    
-    if (isValidEnPassant(lastMove, Move(it->second->getPiece(), from, epCaptureRight))) {
-        int rankOffset = (pawnColor == Color::WHITE) ? 1 : -1;
-        std::cout << "Valid EnPassant" << std::endl;
-        possiblePositions.emplace(Position(epCaptureRight.getFile(), from.getRank() + rankOffset));
+    Bitboard pieces = own & ~board.getPieces(PieceType::KING);
+    while (pieces) {
+        int from = popLsb(pieces);
+        const Bitboard pinMask = (pinned & squareBit(from)) ? lineMask(kingSquare, from) : ~EMPTY_BITBOARD;
+        const PieceType pieceType = board.getPieceType(from);
+
+        if (pieceType == PieceType::PAWN) {
+            MoveList pawnMoves;
+            _addPawnMoves(board, side, from, board.getEnPassantSquare(), checkMask & pinMask, pawnMoves);
+            if (!pawnMoves.empty()) {return true;}
+        } else if (pieceAttacks(pieceType, from, occupied) & ~own & checkMask & pinMask) {
+            return true;
+        }
     }
+    return false;
+}
+
 
-    if (isValidEnPassant(lastMove, Move(it->second->getPiece(), from, epCaptureLeft))) {
-        int rankOffset = (pawnColor == Color::WHITE) ? 1 : -1;
-        std::cout << "Valid EnPassant" << std::endl;
-        possiblePositions.emplace(Position(epCaptureLeft.getFile(), from.getRank() + rankOffset));
+void BoardRules::_generateLegalMoves(const Board& board, Color side, int enPassantSquare, Bitboard fromMask, MoveList& moves) const {
+    const Color opponentColor = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard own = board.getOccupancy(side);
+    const Bitboard enemy = board.getOccupancy(opponentColor);
+    const Bitboard occupied = own | enemy;
+    const int kingSquare = board.getKingSquare(side);
+
+    // Kings are never left en prise, so only boards set up without one (FEN positions in perft and tests)
+    // lack a king; there every pseudo-legal move is legal
+    Bitboard checkers = EMPTY_BITBOARD;
+    Bitboard checkMask = ~EMPTY_BITBOARD;
+    Bitboard pinned = EMPTY_BITBOARD;
+
+    if (kingSquare != NO_SQUARE) {
+        checkers = board.getAttackers(kingSquare, opponentColor, occupied);
+        if (popCount(checkers) > 1) {
+            checkMask = EMPTY_BITBOARD;
+        } else if (checkers) {
+            checkMask = checkers | betweenMask(kingSquare, lsb(checkers));
+        }
+        pinned = _pinnedPieces(board, side, kingSquare);
+
+        if (fromMask & squareBit(kingSquare)) {
+            // The king itself must not block the sliders it steps away from
+            const Bitboard withoutKing = occupied & ~squareBit(kingSquare);
+            Bitboard targets = kingAttacks(kingSquare) & ~own;
+            while (targets) {
+                int to = popLsb(targets);
+                if (!board.getAttackers(to, opponentColor, withoutKing)) {
+                    moves.push_back(CompactMove(kingSquare, to, (enemy & squareBit(to)) ? MoveFlag::CAPTURE : MoveFlag::QUIET));
+                }
+            }
+            if (!checkers) {
+                if (_canCastle(board, side, true)) {
+                    moves.push_back(CompactMove(kingSquare, kingSquare + 2, MoveFlag::KING_CASTLE));
+                }
+                if (_canCastle(board, side, false)) {
+                    moves.push_back(CompactMove(kingSquare, kingSquare - 2, MoveFlag::QUEEN_CASTLE));
+                }
+            }
+        }
     }
 
-    std::cout << "epCaptureRight File: " << epCaptureRight.getFile() << std::endl;
-    std::cout << "epCaptureLeft File: " << epCaptureLeft.getFile() << std::endl;
+    // In double check only the king may move
+    if (!checkMask) {return;}
 
-    std::cout << "epCaptureRight Rank: " << epCaptureRight.getRank() << std::endl;
-    std::cout << "epCaptureLeft Rank: " << epCaptureLeft.getRank() << std::endl;
+    Bitboard pieces = own & fromMask & ~board.getPieces(PieceType::KING);
+    while (pieces) {
+        int from = popLsb(pieces);
+        const Bitboard pinMask = (pinned & squareBit(from)) ? lineMask(kingSquare, from) : ~EMPTY_BITBOARD;
+        const PieceType pieceType = board.getPieceType(from);
+
+        if (pieceType == PieceType::PAWN) {
+            _addPawnMoves(board, side, from, enPassantSquare, checkMask & pinMask, moves);
+        } else {
+            moves.addMoves(from, pieceAttacks(pieceType, from, occupied) & ~own & checkMask & pinMask, enemy);
+        }
+    }
 }
 
 
-void BoardRules::_removeKingInCheckPositions(const Board& board, std::unordered_set<Position>& possiblePositions, const Position& from) {
-    auto it = board.squares.find(from);
-    if (it == board.squares.end()) {throw std::logic_error("Invalid starting position");}
-    if (!it->second->isOccupied()) {throw std::logic_error("Current square is not occupied");}
-    if (it->second->getPiece()->getType() != PieceType::KING) {throw std::logic_error("_addPawnCapturePositions is only valid for King");}
-    IPiece* pKing = const_cast<IPiece*> (it->second->getPiece());
-
-    if (it->second->getPiece()->getType() == PieceType::KING) {
-        auto it = possiblePositions.begin();
-        while (it != possiblePositions.end()) {
-            Position pos = *it;
-            Board tempBoard = board;
-            tempBoard.placePiece(pos, pKing);
-
-            if (isInCheck(tempBoard, pKing->getColor())) {
-                it = possiblePositions.erase(it);
-            } else {++it;}
-            tempBoard.removePiece(tempBoard.squares.at(pos).get());
+void BoardRules::_addPawnMoves(const Board& board, Color side, int from, int enPassantSquare, Bitboard legalMask, MoveList& moves) const {
+    const Color opponentColor = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+    const Bitboard occupied = board.getOccupancy();
+    const Bitboard enemy = board.getOccupancy(opponentColor);
+    const int forward = (side == Color::WHITE) ? GRID_SIZE : -GRID_SIZE;
+    const int startRank = (side == Color::WHITE) ? 1 : GRID_SIZE - 2;
+    const int promotionRank = (side == Color::WHITE) ? GRID_SIZE - 1 : 0;
+
+    // Pushes stop at the first occupied square
+    Bitboard targets = EMPTY_BITBOARD;
+    if (rankOf(from) != promotionRank && !(occupied & squareBit(from + forward))) {
+        targets |= squareBit(from + forward);
+        if (rankOf(from) == startRank && !(occupied & squareBit(from + 2 * forward))) {
+            targets |= squareBit(from + 2 * forward);
         }
-    } else {throw std::logic_error("removeKingInCheckMoves is only valid for King moves");}
-}
\ No newline at end of file
+    }
+    targets |= pawnAttacks(side, from) & enemy;
+    targets &= legalMask;
+
+    while (targets) {
+        int to = popLsb(targets);
+        bool isCapture = (enemy & squareBit(to)) != EMPTY_BITBOARD;
+        if (rankOf(to) == promotionRank) {
+            moves.addPromotions(from, to, isCapture);
+        } else if (std::abs(to - from) == 2 * GRID_SIZE) {
+            moves.push_back(CompactMove(from, to, MoveFlag::DOUBLE_PAWN_PUSH));
+        } else {
+            moves.push_back(CompactMove(from, to, isCapture ? MoveFlag::CAPTURE : MoveFlag::QUIET));
+        }
+    }
+
+    if (enPassantSquare == NO_SQUARE || !(pawnAttacks(side, from) & squareBit(enPassantSquare))) {return;}
+    if (!(board.getPieces(opponentColor, PieceType::PAWN) & squareBit(enPassantSquare - forward))) {return;}
+
+    // En passant empties two squares on one rank, which no mask captures, so look for attackers of the
+    // king with the occupancy the capture leaves; the captured pawn drops out along with its square
+    const int kingSquare = board.getKingSquare(side);
+    const Bitboard occupiedAfter = (occupied ^ squareBit(from) ^ squareBit(enPassantSquare - forward)) | squareBit(enPassantSquare);
+    if (kingSquare == NO_SQUARE || !board.getAttackers(kingSquare, opponentColor, occupiedAfter)) {
+        moves.push_back(CompactMove(from, enPassantSquare, MoveFlag::EN_PASSANT));
+    }
+}
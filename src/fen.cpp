@@ -0,0 +1,120 @@
+#include "fen.h"
+#include "pawn.h"
+#include "knight.h"
+#include "bishop.h"
+#include "rook.h"
+#include "queen.h"
+#include "king.h"
+#include "player.h"
+#include <cctype>
+#include <sstream>
+
+namespace {
+
+const char PIECE_CHARS[NUMBER_OF_PIECE_TYPES] = {'?', 'p', 'b', 'n', 'r', 'q', 'k'};
+
+const struct {char symbol; uint8_t right;} CASTLING_CHARS[] = {
+    {'K', WHITE_KING_SIDE_CASTLE}, {'Q', WHITE_QUEEN_SIDE_CASTLE},
+    {'k', BLACK_KING_SIDE_CASTLE}, {'q', BLACK_QUEEN_SIDE_CASTLE}
+};
+
+std::unique_ptr<IPiece> createPiece(char symbol, int id) {
+    Color color = std::isupper(static_cast<unsigned char>(symbol)) ? Color::WHITE : Color::BLACK;
+    switch (std::tolower(static_cast<unsigned char>(symbol))) {
+        case 'p': return std::make_unique<Pawn>(id, color);
+        case 'n': return std::make_unique<Knight>(id, color);
+        case 'b': return std::make_unique<Bishop>(id, color);
+        case 'r': return std::make_unique<Rook>(id, color);
+        case 'q': return std::make_unique<Queen>(id, color);
+        case 'k': return std::make_unique<King>(id, color);
+        default: throw std::logic_error(std::string("Invalid FEN piece: ") + symbol);
+    }
+}
+
+}
+
+
+Color loadFen(Board& board, const std::string& fen) {
+    std::istringstream fields(fen);
+    std::string placement, side, castling, enPassant;
+    if (!(fields >> placement >> side >> castling >> enPassant)) {
+        throw std::logic_error("Invalid FEN: " + fen);
+    }
+    if (board.getOccupancy()) {
+        throw std::logic_error("FEN can only be loaded onto an empty board");
+    }
+
+    int whiteID = MIN_WHITE_HORCRUXE_ID;
+    int blackID = MIN_BLACK_HORCRUXE_ID;
+    int rank = GRID_SIZE - 1;
+    int file = 0;
+    for (char symbol : placement) {
+        if (symbol == '/') {
+            rank--;
+            file = 0;
+        } else if (std::isdigit(static_cast<unsigned char>(symbol))) {
+            file += symbol - '0';
+        } else {
+            if (rank < 0 || file >= GRID_SIZE) {throw std::logic_error("Invalid FEN placement: " + placement);}
+            int id = std::isupper(static_cast<unsigned char>(symbol)) ? whiteID++ : blackID++;
+            board.adoptPiece(toPosition(squareIndex(file, rank)), createPiece(symbol, id));
+            file++;
+        }
+    }
+
+    uint8_t rights = 0;
+    for (char symbol : castling) {
+        for (const auto& castlingChar : CASTLING_CHARS) {
+            if (symbol == castlingChar.symbol) {rights |= castlingChar.right;}
+        }
+    }
+    board.setCastlingRights(rights);
+
+    if (enPassant == "-") {
+        board.setEnPassantSquare(NO_SQUARE);
+    } else if (enPassant.size() == 2 && toSquare(Position(enPassant[0], enPassant[1] - '0')) != NO_SQUARE) {
+        board.setEnPassantSquare(toSquare(Position(enPassant[0], enPassant[1] - '0')));
+    } else {
+        throw std::logic_error("Invalid FEN en passant square: " + enPassant);
+    }
+
+    if (side != "w" && side != "b") {throw std::logic_error("Invalid FEN side to move: " + side);}
+    board.setSideToMove(side == "w" ? Color::WHITE : Color::BLACK);
+    return board.getSideToMove();
+}
+
+
+std::string toFen(const Board& board, Color sideToMove, int halfmoveClock, int fullmoveNumber) {
+    std::string fen;
+    for (int rank = GRID_SIZE - 1; rank >= 0; --rank) {
+        int emptySquares = 0;
+        for (int file = 0; file < GRID_SIZE; ++file) {
+            int square = squareIndex(file, rank);
+            if (!board.getPiece(square)) {
+                emptySquares++;
+                continue;
+            }
+            if (emptySquares) {fen += std::to_string(emptySquares);}
+            emptySquares = 0;
+
+            char symbol = PIECE_CHARS[static_cast<int>(board.getPieceType(square))];
+            fen += board.getPiece(square)->getColor() == Color::WHITE ? static_cast<char>(std::toupper(symbol)) : symbol;
+        }
+        if (emptySquares) {fen += std::to_string(emptySquares);}
+        if (rank) {fen += '/';}
+    }
+
+    fen += sideToMove == Color::WHITE ? " w " : " b ";
+
+    std::string castling;
+    for (const auto& castlingChar : CASTLING_CHARS) {
+        if (board.getCastlingRights() & castlingChar.right) {castling += castlingChar.symbol;}
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    int enPassant = board.getEnPassantSquare();
+    fen += ' ';
+    fen += enPassant == NO_SQUARE ? "-" : std::string(1, static_cast<char>('a' + fileOf(enPassant))) + std::to_string(rankOf(enPassant) + 1);
+    fen += " " + std::to_string(halfmoveClock) + " " + std::to_string(fullmoveNumber);
+    return fen;
+}
@@ -7,7 +7,7 @@
 #include "queen.h"
 #include "pawn.h"
 #include "rook.h"
-#include <array>
+#include "tracing.h"
 #include <iostream>
 
 
@@ -78,10 +78,104 @@ void Game::_setupBoard() {
 void Game::startGame() {
     pCurrentPlayer_ = whitePlayer; // Current player white
     gameState_ = GameState::CHOOSING_HORCRUX;
+    fullmoveNumber_ = 1;
 
     _setupBoard();
+
+    history_.clear();
+    history_.push(board_->getZobristKey(), true);
 };
 
+GameSnapshot Game::takeSnapshot() const {
+    GameSnapshot snapshot{};
+    snapshot.pieceSquares.fill(CAPTURED_SQUARE);
+
+    Bitboard occupied = board_->getOccupancy();
+    while (occupied) {
+        int square = popLsb(occupied);
+        int id = board_->getPiece(square)->getID();
+        if (id < 1 || id > NUMBER_OF_PIECES) {
+            throw std::logic_error("Piece ID out of range for a snapshot");
+        }
+        snapshot.pieceSquares[id - 1] = static_cast<uint8_t>(square);
+    }
+
+    snapshot.castlingRights = board_->getCastlingRights();
+    snapshot.enPassantSquare = static_cast<int8_t>(board_->getEnPassantSquare());
+    snapshot.sideToMove = static_cast<uint8_t>(board_->getSideToMove());
+    snapshot.gameState = static_cast<uint8_t>(gameState_);
+    snapshot.gameEndType = (gameState_ == GameState::ENDED) ? static_cast<uint8_t>(gameEndType_) : 0;
+    snapshot.halfmoveClock = history_.getHalfmoveClock();
+    snapshot.fullmoveNumber = fullmoveNumber_;
+
+    for (const Player* pPlayer : {whitePlayer, blackPlayer}) {
+        snapshot.players[static_cast<int>(pPlayer->getColor())] = PlayerSnapshot{
+            static_cast<uint8_t>(pPlayer->getHorcruxID()),
+            static_cast<uint8_t>(pPlayer->getNumberOfHorcruxGuessesLeft()),
+            pPlayer->getHorcruxFound(),
+            pPlayer->hasHorcruxBeenCaptured(),
+            pPlayer->getHasKingBeenCaptured()
+        };
+    }
+    return snapshot;
+}
+
+
+void Game::restoreSnapshot(const GameSnapshot& snapshot) {
+    // Pieces never change kind, so a started game's own pieces are reused and only
+    // a game missing some of them goes through the usual setup
+    _clearBoard();
+    if (pieceMap.size() != NUMBER_OF_PIECES) {
+        _cleanupPieces();
+        _setupBoard();
+        _clearBoard();
+    }
+
+    for (int id = 1; id <= NUMBER_OF_PIECES; ++id) {
+        const uint8_t square = snapshot.pieceSquares[id - 1];
+        if (square != CAPTURED_SQUARE) {
+            board_->placePiece(toPosition(square), pieceMap.at(id));
+        }
+    }
+    board_->setCastlingRights(snapshot.castlingRights);
+    board_->setEnPassantSquare(snapshot.enPassantSquare);
+    board_->setSideToMove(static_cast<Color>(snapshot.sideToMove));
+
+    for (Player* pPlayer : {whitePlayer, blackPlayer}) {
+        const PlayerSnapshot& saved = snapshot.players[static_cast<int>(pPlayer->getColor())];
+        if (saved.horcruxID != INVALID_HORCRUXE_ID) {pPlayer->setHorcruxID(saved.horcruxID);}
+        pPlayer->setNumberOfHorcruxGuessesLeft(saved.horcruxGuessesLeft);
+        if (saved.horcruxFound) {pPlayer->setHorcruxFound();}
+        if (saved.horcruxCaptured) {pPlayer->setHasHorcruxBeenCaptured();}
+        if (saved.kingCaptured) {pPlayer->setHasKingBeenCaptured();}
+    }
+
+    gameState_ = static_cast<GameState>(snapshot.gameState);
+    gameEndType_ = static_cast<GameEndType>(snapshot.gameEndType);
+    fullmoveNumber_ = snapshot.fullmoveNumber;
+    pCurrentPlayer_ = (board_->getSideToMove() == Color::WHITE) ? whitePlayer : blackPlayer;
+
+    // The en passant rules look at the previous move, which is the double push that left the square behind
+    previousMove_ = Move();
+    if (snapshot.enPassantSquare != NO_SQUARE) {
+        const int forward = (board_->getSideToMove() == Color::WHITE) ? -GRID_SIZE : GRID_SIZE;
+        const int to = snapshot.enPassantSquare + forward;
+        const int from = snapshot.enPassantSquare - forward;
+        previousMove_ = Move(board_->getPiece(to), toPosition(from), toPosition(to));
+    }
+
+    history_.reset(board_->getZobristKey(), snapshot.halfmoveClock);
+}
+
+
+void Game::_clearBoard() {
+    Bitboard occupied = board_->getOccupancy();
+    while (occupied) {
+        board_->removePiece(board_->getSquare(toPosition(popLsb(occupied))));
+    }
+}
+
+
 bool Game::checkHorcruxSet() {
     if (whitePlayer->getHorcruxID() && blackPlayer->getHorcruxID()) {
         gameState_ = GameState::WHITE_MOVE;
@@ -106,14 +200,32 @@ bool Game::_validateMoveForPlayer(const Square* pSquareFrom, const Player* pPlay
 
 // Execute the move and handle the captured piece if present
 void Game::_executeMove(Square* pSquareFrom, Square* pSquareTo, const Move& move) {
-    if (pSquareTo->isOccupied()) {
+    const bool isCapture = pSquareTo->isOccupied();
+    if (isCapture) {
         pSquareTo->removePiece();
     }
     pSquareTo->placePiece(move.getPiece());
     pSquareFrom->removePiece();
 
-    // Check for castling (king's move of two squares to the right or left)
     const IPiece* movedPiece = move.getPiece();
+    const Position& from = move.getFrom();
+    const Position& to = move.getTo();
+    MoveFlag flag = MoveFlag::QUIET;
+
+    if (movedPiece->getType() == PieceType::PAWN) {
+        if (std::abs(to.getRank() - from.getRank()) == 2) {
+            flag = MoveFlag::DOUBLE_PAWN_PUSH;
+        } else if (!isCapture && to.getFile() != from.getFile()) {
+            // En passant: the captured pawn sits beside the starting square
+            Square* pCapturedSquare = board_->getSquare(Position(to.getFile(), from.getRank()));
+            if (pCapturedSquare && pCapturedSquare->isOccupied()) {
+                pCapturedSquare->removePiece();
+            }
+        }
+    }
+    board_->recordMove(CompactMove(toSquare(from), toSquare(to), flag));
+
+    // Check for castling (king's move of two squares to the right or left)
     if (movedPiece->getType() == PieceType::KING) {
         int moveDistance = pSquareTo->getPosition().getFile() - pSquareFrom->getPosition().getFile();
         if (std::abs(moveDistance) == 2) {
@@ -147,18 +259,29 @@ void Game::movePiece(const Move& move, Player* pPlayer) {
         throw std::logic_error("Invalid move. Not a valid square");
     }
 
-    if (!_validateMoveForPlayer(pSquareFrom, pPlayer) || 
-        !boardRules_->isValidMove(*board_, move, previousMove_)) {
-        throw std::logic_error("Invalid Move. Please try another move.");
+    {
+        TraceSpan span("BoardRules::isValidMove");
+        if (!_validateMoveForPlayer(pSquareFrom, pPlayer) || 
+            !boardRules_->isValidMove(*board_, move, previousMove_)) {
+            throw std::logic_error("Invalid Move. Please try another move.");
+        }
     }
 
+    const bool isIrreversible = pSquareTo->isOccupied() || move.getPiece()->getType() == PieceType::PAWN;
     _executeMove(pSquareFrom, pSquareTo, move);
+    history_.push(board_->getZobristKey(), isIrreversible);
+    if (pPlayer->getColor() == Color::BLACK) {fullmoveNumber_++;}
 
     if (isKingCaptured(pPlayer->getColor())) {
         pPlayer->setHasKingBeenCaptured();
     }
 
-    if (checkGameOver()) {
+    bool isGameOver;
+    {
+        TraceSpan span("Game::checkGameOver");
+        isGameOver = checkGameOver();
+    }
+    if (isGameOver) {
         _endGame();
     } else {
         previousMove_ = move;
@@ -167,9 +290,11 @@ void Game::movePiece(const Move& move, Player* pPlayer) {
 }
 
 
-std::unordered_set<Position> Game::getAvailablePositions(IPiece* piece, const Position& from) {
+std::unordered_set<Position> Game::getAvailablePositions(const IPiece* piece, const Position& from) {
     if (piece) {
-        return boardRules_->generateValidPositions(*board_, piece, from, previousMove_);
+        MoveList moves;
+        boardRules_->generateValidMoves(*board_, from, previousMove_, moves);
+        return moves.toPositions();
     } else {
         throw std::logic_error("Piece is nullptr. No available moves.");
     }
@@ -207,23 +332,37 @@ bool Game::checkGameOver() {
     }
 
     Player* opponentPlayer;
+    Player* currentPlayer;
 
     getCurrentPlayer()->getColor() == Color::WHITE ? opponentPlayer = blackPlayer 
                                                    : opponentPlayer = whitePlayer;
+    currentPlayer = (opponentPlayer == blackPlayer) ? whitePlayer : blackPlayer;
+
+    // The opponent's horcrux is the one the last move could have taken, but either loss ends the game
+    for (Player* pPlayer : {opponentPlayer, currentPlayer}) {
+        if (_isHorcruxCaptured(pPlayer->getHorcruxID())) {
+            pPlayer->getColor() == Color::WHITE ? gameEndType_ = GameEndType::BLACK_WIN
+                                                : gameEndType_ = GameEndType::WHITE_WIN;
+            pPlayer->setHasHorcruxBeenCaptured();
+            _endGame();
+            return true;
+        }
+    }
 
-    if (_isHorcruxCaptured(opponentPlayer->getHorcruxID())) {
-        opponentPlayer->getColor() == Color::WHITE ? gameEndType_ = GameEndType::BLACK_WIN
-                                          : gameEndType_ = GameEndType::WHITE_WIN;
-        opponentPlayer->setHasHorcruxBeenCaptured();
+    if (_isCheckmate()) {
+        board_->getSideToMove() == Color::WHITE ? gameEndType_ = GameEndType::BLACK_WIN
+                                                : gameEndType_ = GameEndType::WHITE_WIN;
+        _endGame();
         return true;
     }
-
     if (_isStalemate()) {
         gameEndType_ = GameEndType::STALEMATE;
+        _endGame();
         return true;
     }
-    if (_hasInsufficientMaterial()) {
+    if (_hasInsufficientMaterial() || _isThreefoldRepetition() || _isFiftyMoveRule()) {
         gameEndType_ = GameEndType::DRAW;
+        _endGame();
         return true;
     }
     return false;
@@ -264,44 +403,38 @@ bool Game::_isHorcruxGuessed(const int horcruxID, const Player* pPlayer) const {
 
 
 bool Game::_isHorcruxCaptured(const int horcruxID) const {
-    for (const auto& pair : board_->squares) {
-        const Square* currentSquare = pair.second.get();
-
-        if (currentSquare && currentSquare->getPiece() && currentSquare->getPiece()->getID() == horcruxID) {return false;}
+    Bitboard occupied = board_->getOccupancy();
+    while (occupied) {
+        if (board_->getPiece(popLsb(occupied))->getID() == horcruxID) {return false;}
     }
     return true;
 };
 
 
+bool Game::_isCheckmate() const {
+    // Kings are never left en prise, so a side in check with no move out of it has lost
+    const Color sideToMove = board_->getSideToMove();
+    return boardRules_->isInCheck(*board_, sideToMove) && !boardRules_->hasLegalMove(*board_, sideToMove);
+};
+
+
 bool Game::_isStalemate() const {
-    std::array<Color, 2> colors = { Color::WHITE, Color::BLACK };
-
-    for (const auto& playerColor : colors) {
-        if (boardRules_->isInCheck(*board_, playerColor)) {return false;}
-
-        for (const auto& it : pieceMap) {
-            if (it.second->getColor() == playerColor) {
-                Position* pPiecePosition = nullptr;
-                for (const auto& pair : board_->squares) {
-                    const IPiece* piece = pair.second->getPiece();  // Getting the piece
-                    if (piece != nullptr && piece->getID() == it.first) {  // Check if piece is not nullptr before accessing it
-                        pPiecePosition = const_cast<Position*>(&pair.first);
-                        break;
-                    }
-                }
-                if (pPiecePosition) {
-                    auto possiblePos = it.second->getPossiblePositions(*pPiecePosition);
-                    for (const Position& pos : possiblePos) {
-                        if (boardRules_->isValidMove(*board_, Move(it.second, *pPiecePosition, pos), previousMove_)) {return false;}
-                    }
-                }
-            }
-        }
-    }
-    return true;
+    // Only the player about to move can be stalemated
+    const Color sideToMove = board_->getSideToMove();
+    return !boardRules_->isInCheck(*board_, sideToMove) && !boardRules_->hasLegalMove(*board_, sideToMove);
 };
 
 
+bool Game::_isThreefoldRepetition() const {
+    return history_.repetitionCount() >= 3;
+}
+
+
+bool Game::_isFiftyMoveRule() const {
+    return history_.getHalfmoveClock() >= FIFTY_MOVE_RULE_PLIES;
+}
+
+
 bool Game::_hasInsufficientMaterial() const {
     int numBishopsLightSquare = 0;
     int numBishopsDarkSquare = 0;
@@ -310,35 +443,19 @@ bool Game::_hasInsufficientMaterial() const {
     int numRooks = 0;
     int numQueens = 0;
 
-    // Loop through all squares on the board to count the pieces.
-    for (const auto& pair : board_->squares) {
-        const Square* square = pair.second.get();
-        if (square && square->getPiece()) {
-            switch (square->getPiece()->getType()) {
-                case PieceType::BISHOP:
-                    if (Board::isLightSquare(square->getPosition())) {
-                        numBishopsLightSquare++;
-                    } else {
-                        numBishopsDarkSquare++;
-                    }
-                    break;
-                case PieceType::KNIGHT:
-                    numKnights++;
-                    break;
-                case PieceType::PAWN:
-                    numPawns++;
-                    break;
-                case PieceType::ROOK:
-                    numRooks++;
-                    break;
-                case PieceType::QUEEN:
-                    numQueens++;
-                    break;
-                default:
-                    break;
-            }
+    // Count the pieces straight from the bitboards.
+    Bitboard bishops = board_->getPieces(PieceType::BISHOP);
+    while (bishops) {
+        if (Board::isLightSquare(toPosition(popLsb(bishops)))) {
+            numBishopsLightSquare++;
+        } else {
+            numBishopsDarkSquare++;
         }
     }
+    numKnights = popCount(board_->getPieces(PieceType::KNIGHT));
+    numPawns = popCount(board_->getPieces(PieceType::PAWN));
+    numRooks = popCount(board_->getPieces(PieceType::ROOK));
+    numQueens = popCount(board_->getPieces(PieceType::QUEEN));
 
     // Check the known scenarios for insufficient material:
     if (numPawns == 0 && numRooks == 0 && numQueens == 0) {
@@ -0,0 +1,46 @@
+#include "game_channel.h"
+#include <algorithm>
+#include <stdexcept>
+
+
+void GameChannel::subscribe(const std::string& gameID, const void* subscriber, Send send) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (gameOf_.count(subscriber)) {
+        throw std::logic_error("Already subscribed to a game");
+    }
+    games_[gameID].push_back(Subscription{subscriber, std::move(send)});
+    gameOf_.emplace(subscriber, gameID);
+}
+
+
+void GameChannel::unsubscribe(const void* subscriber) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = gameOf_.find(subscriber);
+    if (it == gameOf_.end()) {return;}
+
+    auto game = games_.find(it->second);
+    std::vector<Subscription>& subscriptions = game->second;
+    subscriptions.erase(std::remove_if(subscriptions.begin(), subscriptions.end(),
+                                       [subscriber](const Subscription& s) {return s.subscriber == subscriber;}),
+                        subscriptions.end());
+    if (subscriptions.empty()) {games_.erase(game);}
+    gameOf_.erase(it);
+}
+
+
+size_t GameChannel::publish(const std::string& gameID, const std::string& message) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = games_.find(gameID);
+    if (it == games_.end()) {return 0;}
+
+    for (const Subscription& subscription : it->second) {
+        subscription.send(message);
+    }
+    return it->second.size();
+}
+
+
+size_t GameChannel::getSubscriberCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return gameOf_.size();
+}
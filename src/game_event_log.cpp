@@ -0,0 +1,102 @@
+#include "game_event_log.h"
+#include "snapshot_codec.h"
+#include "tracing.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+GameEventLog::GameEventLog(const std::string& path) : path_(path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open the game log at " + path);
+    }
+}
+
+
+GameEventLog::~GameEventLog() {
+    ::close(fd_);
+}
+
+
+void GameEventLog::appendCreated(const std::string& whitePlayerID) {
+    _append(GameEventType::CREATED, whitePlayerID);
+}
+
+
+void GameEventLog::appendJoined(const std::string& blackPlayerID) {
+    _append(GameEventType::JOINED, blackPlayerID);
+}
+
+
+void GameEventLog::appendHorcruxSet(Color color, int horcruxID) {
+    _append(GameEventType::HORCRUX_SET, {static_cast<char>(color), static_cast<char>(horcruxID)});
+    eventsSinceSnapshot_++;
+}
+
+
+void GameEventLog::appendMove(CompactMove move) {
+    const uint16_t raw = move.getRaw();
+    _append(GameEventType::MOVE, {static_cast<char>(raw & 0xFF), static_cast<char>(raw >> 8)});
+    eventsSinceSnapshot_++;
+}
+
+
+void GameEventLog::appendHorcruxGuess(Color guessingColor, int pieceID) {
+    _append(GameEventType::HORCRUX_GUESS, {static_cast<char>(guessingColor), static_cast<char>(pieceID)});
+    eventsSinceSnapshot_++;
+}
+
+
+void GameEventLog::appendSnapshot(const GameSnapshot& snapshot) {
+    const SnapshotBytes bytes = encodeSnapshot(snapshot);
+    _append(GameEventType::SNAPSHOT, std::string(bytes.begin(), bytes.end()));
+    eventsSinceSnapshot_ = 0;
+}
+
+
+void GameEventLog::sync() {
+    TraceSpan span("GameEventLog::sync");
+    // The file only ever grows, and fdatasync still flushes the size that makes new records readable
+    if (::fdatasync(fd_) != 0) {
+        throw std::runtime_error("Could not sync the game log at " + path_);
+    }
+}
+
+
+std::vector<GameEvent> GameEventLog::read(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Could not read the game log at " + path);
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::vector<GameEvent> events;
+    size_t offset = 0;
+    while (offset + 2 <= data.size()) {
+        const size_t length = static_cast<uint8_t>(data[offset + 1]);
+        if (offset + 2 + length > data.size()) {break;}
+        events.push_back(GameEvent{static_cast<GameEventType>(data[offset]), data.substr(offset + 2, length)});
+        offset += 2 + length;
+    }
+    return events;
+}
+
+
+void GameEventLog::_append(GameEventType type, const std::string& payload) {
+    TraceSpan span("GameEventLog::append");
+    if (payload.size() > 0xFF) {
+        throw std::logic_error("Game log record too long");
+    }
+    std::string record;
+    record += static_cast<char>(type);
+    record += static_cast<char>(payload.size());
+    record += payload;
+
+    // One write per record, so O_APPEND keeps records whole even if two ever raced
+    if (::write(fd_, record.data(), record.size()) != static_cast<ssize_t>(record.size())) {
+        throw std::runtime_error("Could not append to the game log at " + path_);
+    }
+}
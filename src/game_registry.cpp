@@ -0,0 +1,308 @@
+#include "game_registry.h"
+#include "logger.h"
+#include "snapshot_codec.h"
+#include "tracing.h"
+#include <filesystem>
+#include <unistd.h>
+
+
+GameSession::GameSession(const std::string& gameID, const std::string& whitePlayerID,
+                         std::unique_ptr<GameEventLog> log, size_t snapshotInterval)
+    : gameID_(gameID), whitePlayerID_(whitePlayerID),
+      whitePlayer_(Color::WHITE), blackPlayer_(Color::BLACK),
+      game_(&whitePlayer_, &blackPlayer_, &board_, &boardRules_),
+      log_(std::move(log)), snapshotInterval_(snapshotInterval)
+{
+}
+
+
+void GameSession::join(const std::string& blackPlayerID) {
+    if (isJoined()) {
+        throw std::logic_error("Game already has two players");
+    }
+    if (blackPlayerID.empty() || blackPlayerID == whitePlayerID_) {
+        throw std::logic_error("Invalid player ID");
+    }
+    blackPlayerID_ = blackPlayerID;
+    game_.startGame();
+    if (log_) {
+        log_->appendJoined(blackPlayerID);
+        log_->sync();
+    }
+    // The whole board was just set up, so nobody can catch up on it square by square
+    _changed(GameEventType::JOINED, 0);
+    diffs_.reset(version_);
+}
+
+
+Player* GameSession::findPlayer(const std::string& playerID) {
+    if (playerID.empty()) {return nullptr;}
+    if (playerID == whitePlayerID_) {return &whitePlayer_;}
+    if (playerID == blackPlayerID_) {return &blackPlayer_;}
+    return nullptr;
+}
+
+
+Player* GameSession::getOpponent(const Player* pPlayer) {
+    return (pPlayer->getColor() == Color::WHITE) ? &blackPlayer_ : &whitePlayer_;
+}
+
+
+GameState GameSession::getGameState() const {
+    return isJoined() ? game_.getGameState() : GameState::WAITING_FOR_OPPONENT;
+}
+
+
+bool GameSession::selectHorcrux(Player* pPlayer, int horcruxID) {
+    // checkHorcruxSet hands the move to white, so a second choice mid-game would rewind the turn
+    if (getGameState() != GameState::CHOOSING_HORCRUX || pPlayer->getHorcruxID() != INVALID_HORCRUXE_ID) {
+        throw std::logic_error("Horcrux can only be chosen once, before the first move");
+    }
+    pPlayer->setHorcruxID(horcruxID);
+    if (pPlayer->getHorcruxID() != horcruxID) {
+        throw std::logic_error("Invalid horcrux ID");
+    }
+    const bool isSet = game_.checkHorcruxSet();
+    if (log_) {
+        log_->appendHorcruxSet(pPlayer->getColor(), horcruxID);
+        _commitLog();
+    }
+    _changed(GameEventType::HORCRUX_SET, 0);
+    return isSet;
+}
+
+
+void GameSession::movePiece(Player* pPlayer, const Position& from, const Position& to) {
+    TraceSpan span("GameSession::movePiece");
+    // Game::movePiece only checks the piece belongs to the player, not that it is their turn
+    const GameState playerToMove = (pPlayer->getColor() == Color::WHITE) ? GameState::WHITE_MOVE : GameState::BLACK_MOVE;
+    if (getGameState() != playerToMove) {
+        throw std::logic_error("Invalid move. It is not this player's turn");
+    }
+    if (!isOnBoard(from) || !isOnBoard(to)) {
+        throw std::logic_error("Invalid move. Not a valid square");
+    }
+    const Bitboard whiteBefore = board_.getOccupancy(Color::WHITE);
+    const Bitboard blackBefore = board_.getOccupancy(Color::BLACK);
+    game_.movePiece(Move(game_.getPieceFromPosition(from), from, to), pPlayer);
+    if (log_) {
+        // From and to replay the move; Game never promotes, so there is no promotion piece to add
+        log_->appendMove(CompactMove(toSquare(from), toSquare(to)));
+        _commitLog();
+    }
+    CHESS_LOG_DEBUG("Move", {{"gameID", gameID_}, {"move", CompactMove(toSquare(from), toSquare(to)).toUci()},
+                             {"version", version_ + 1}});
+    // A piece never gives way to another of its own color, so every changed square changes an occupancy
+    _changed(GameEventType::MOVE, (whiteBefore ^ board_.getOccupancy(Color::WHITE)) |
+                                  (blackBefore ^ board_.getOccupancy(Color::BLACK)));
+}
+
+
+bool GameSession::guessHorcrux(Player* pPlayer, int pieceID) {
+    if (getGameState() != GameState::WHITE_MOVE && getGameState() != GameState::BLACK_MOVE) {
+        throw std::logic_error("Horcruxes can only be guessed while the game is in progress");
+    }
+    const bool isCorrect = game_.horcruxGuess(pieceID, pPlayer, getOpponent(pPlayer));
+    if (log_) {
+        log_->appendHorcruxGuess(pPlayer->getColor(), pieceID);
+        _commitLog();
+    }
+    _changed(GameEventType::HORCRUX_GUESS, 0);
+    return isCorrect;
+}
+
+
+uint64_t GameSession::watch(std::function<void()> onChange) {
+    const uint64_t watchID = nextWatchID_++;
+    watchers_.emplace(watchID, std::move(onChange));
+    return watchID;
+}
+
+
+void GameSession::unwatch(uint64_t watchID) {
+    watchers_.erase(watchID);
+}
+
+
+void GameSession::restore(const GameSnapshot& snapshot) {
+    game_.restoreSnapshot(snapshot);
+    _changed(GameEventType::SNAPSHOT, 0);
+    diffs_.reset(version_);
+}
+
+
+void GameSession::_changed(GameEventType type, Bitboard squares) {
+    TraceSpan span("GameSession::_changed");
+    version_++;
+    diffs_.push(squares, type);
+    std::unordered_map<uint64_t, std::function<void()>> watchers;
+    watchers.swap(watchers_);
+    for (auto& [watchID, onChange] : watchers) {
+        onChange();
+    }
+}
+
+
+void GameSession::_commitLog() {
+    if (log_->getEventsSinceSnapshot() >= snapshotInterval_) {
+        log_->appendSnapshot(game_.takeSnapshot());
+    }
+    log_->sync();
+}
+
+
+std::shared_ptr<GameSession> GameRegistry::create(const std::string& gameID, const std::string& whitePlayerID) {
+    Shard& shard = _shardFor(gameID);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (shard.games.count(gameID)) {
+        throw std::logic_error("Game ID already in use");
+    }
+
+    std::unique_ptr<GameEventLog> log;
+    if (!logDirectory_.empty()) {
+        // Whatever is left under this ID belongs to a game that is no longer live
+        std::filesystem::remove(_logPath(gameID));
+        log = std::make_unique<GameEventLog>(_logPath(gameID));
+        log->appendCreated(whitePlayerID);
+        log->sync();
+    }
+
+    auto pSession = std::make_shared<GameSession>(gameID, whitePlayerID, std::move(log), snapshotInterval_);
+    shard.games.emplace(gameID, pSession);
+    return pSession;
+}
+
+
+std::shared_ptr<GameSession> GameRegistry::find(const std::string& gameID) const {
+    const Shard& shard = _shardFor(gameID);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.games.find(gameID);
+    return (it == shard.games.end()) ? nullptr : it->second;
+}
+
+
+bool GameRegistry::remove(const std::string& gameID) {
+    Shard& shard = _shardFor(gameID);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    if (shard.games.erase(gameID) == 0) {return false;}
+    if (!logDirectory_.empty()) {
+        std::filesystem::remove(_logPath(gameID));
+    }
+    return true;
+}
+
+
+size_t GameRegistry::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        total += shard.games.size();
+    }
+    return total;
+}
+
+
+size_t GameRegistry::recover() {
+    if (logDirectory_.empty()) {return 0;}
+    std::filesystem::create_directories(logDirectory_);
+
+    size_t recovered = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(logDirectory_)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".log") {continue;}
+        const std::string gameID = entry.path().stem().string();
+
+        try {
+            auto pSession = _replay(gameID, entry.path().string());
+            Shard& shard = _shardFor(gameID);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            if (shard.games.emplace(gameID, pSession).second) {recovered++;}
+        } catch (const std::exception& e) {
+            CHESS_LOG_ERROR("Could not recover game", {{"gameID", gameID}, {"error", e.what()}});
+        }
+    }
+    return recovered;
+}
+
+
+std::shared_ptr<GameSession> GameRegistry::_replay(const std::string& gameID, const std::string& path) const {
+    const std::vector<GameEvent> events = GameEventLog::read(path);
+    if (events.empty() || events.front().type != GameEventType::CREATED) {
+        throw std::runtime_error("Log does not start with the game's creation");
+    }
+
+    // Everything before the last snapshot is covered by it, apart from who joined
+    size_t replayFrom = 1;
+    for (size_t i = events.size(); i-- > 1;) {
+        if (events[i].type == GameEventType::SNAPSHOT) {
+            replayFrom = i;
+            break;
+        }
+    }
+
+    auto pSession = std::make_shared<GameSession>(gameID, events.front().payload, nullptr, snapshotInterval_);
+    size_t validLength = 2 + events.front().payload.size();
+    size_t eventsSinceSnapshot = 0;
+    for (size_t i = 1; i < events.size(); ++i) {
+        const GameEvent& event = events[i];
+        const std::string& payload = event.payload;
+        validLength += 2 + payload.size();
+
+        if (event.type == GameEventType::JOINED) {
+            pSession->join(payload);
+            continue;
+        }
+        if (i < replayFrom) {continue;}
+
+        switch (event.type) {
+            case GameEventType::SNAPSHOT:
+                pSession->restore(decodeSnapshot(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()));
+                break;
+            case GameEventType::HORCRUX_SET:
+                pSession->selectHorcrux(pSession->getPlayer(static_cast<Color>(payload.at(0))), payload.at(1));
+                eventsSinceSnapshot++;
+                break;
+            case GameEventType::MOVE: {
+                const CompactMove move = CompactMove::fromRaw(static_cast<uint16_t>(
+                    static_cast<uint8_t>(payload.at(0)) | (static_cast<uint8_t>(payload.at(1)) << 8)));
+                const Position from = toPosition(move.getFrom());
+                const IPiece* pPiece = pSession->getGame().getPieceFromPosition(from);
+                if (!pPiece) {
+                    throw std::runtime_error("Logged move starts on an empty square");
+                }
+                pSession->movePiece(pSession->getPlayer(pPiece->getColor()), from, toPosition(move.getTo()));
+                eventsSinceSnapshot++;
+                break;
+            }
+            case GameEventType::HORCRUX_GUESS:
+                pSession->guessHorcrux(pSession->getPlayer(static_cast<Color>(payload.at(0))), payload.at(1));
+                eventsSinceSnapshot++;
+                break;
+            default:
+                throw std::runtime_error("Unknown record in game log");
+        }
+    }
+
+    // A record cut short by a crash is dropped so new records do not land behind it
+    if (::truncate(path.c_str(), static_cast<off_t>(validLength)) != 0) {
+        throw std::runtime_error("Could not truncate the game log");
+    }
+    auto log = std::make_unique<GameEventLog>(path);
+    log->setEventsSinceSnapshot(eventsSinceSnapshot);
+    pSession->attachLog(std::move(log));
+    return pSession;
+}
+
+
+std::string GameRegistry::_logPath(const std::string& gameID) const {
+    return logDirectory_ + "/" + gameID + ".log";
+}
+
+
+GameRegistry::Shard& GameRegistry::_shardFor(const std::string& gameID) {
+    return shards_[std::hash<std::string>()(gameID) % REGISTRY_SHARDS];
+}
+
+
+const GameRegistry::Shard& GameRegistry::_shardFor(const std::string& gameID) const {
+    return shards_[std::hash<std::string>()(gameID) % REGISTRY_SHARDS];
+}
@@ -1,27 +1,24 @@
 #include "king.h"
+#include "move_list.h"
+#include "attacks.h"
 
 std::unordered_set<Position> King::getPossiblePositions(const Position& from) const {
-    std::unordered_set<Position> possiblePositions;
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return {};}
 
-    std::vector<std::pair<int, int>> directions = {
-        {0, 1}, {0, -1}, {1, 0}, {-1, 0}, // Vertical and horizontal
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1} // Diagonal
-    };
+    return toPositions(kingAttacks(square));
+}
 
-    // Check each direction, and add the position if it's within the bounds of the board
-    for (const auto& dir : directions) {
-        int newFile = charToFile(from.getFile()) + dir.first;
-        int newRank = from.getRank() + dir.second;
-        if (newFile >= charToFile('a') && newFile <= charToFile('h') && newRank >= 1 && newRank <= GRID_SIZE) {
-            possiblePositions.emplace(fileToChar(newFile), newRank);
-        }
-    }
+void King::getPossibleMoves(const Position& from, MoveList& moves) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return;}
 
-    return possiblePositions;
-};
+    moves.addMoves(square, kingAttacks(square), EMPTY_BITBOARD);
+}
 
 bool King::isValidMove(const Move& move) const {
-    std::unordered_set possiblePositions = getPossiblePositions(move.getFrom());
+    int from = toSquare(move.getFrom());
+    if (from == NO_SQUARE) {return false;}
 
-    return possiblePositions.find(move.getTo()) != possiblePositions.end();
+    return containsPosition(kingAttacks(from), move.getTo());
 };
\ No newline at end of file
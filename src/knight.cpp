@@ -1,28 +1,24 @@
 #include "knight.h"
+#include "move_list.h"
+#include "attacks.h"
 
 std::unordered_set<Position> Knight::getPossiblePositions(const Position& from) const {
-    std::unordered_set<Position> positions;
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return {};}
 
-    // Define the possible moves for the knight
-    std::vector<std::pair<int, int>> moves = {
-        {2, 1}, {2, -1}, {-2, 1}, {-2, -1},
-        {1, 2}, {1, -2}, {-1, 2}, {-1, -2}
-    };
+    return toPositions(knightAttacks(square));
+}
 
-    // Check each move, and add the position if it's within the bounds of the board
-    for (const auto& move : moves) {
-        int newFile = charToFile(from.getFile()) + move.first;
-        int newRank = from.getRank() + move.second;
-        if (newFile >= charToFile('a') && newFile <= charToFile('h') && newRank >= 1 && newRank <= GRID_SIZE) {
-            positions.emplace(fileToChar(newFile), newRank);
-        }
-    }
+void Knight::getPossibleMoves(const Position& from, MoveList& moves) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return;}
 
-    return positions;
+    moves.addMoves(square, knightAttacks(square), EMPTY_BITBOARD);
 }
 
 bool Knight::isValidMove(const Move& move) const {
-    std::unordered_set possiblePositions = getPossiblePositions(move.getFrom());
+    int from = toSquare(move.getFrom());
+    if (from == NO_SQUARE) {return false;}
 
-    return possiblePositions.find(move.getTo()) != possiblePositions.end();
+    return containsPosition(knightAttacks(from), move.getTo());
 };
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+// The writer sleeps this long whenever it finds the ring empty
+constexpr std::chrono::milliseconds IDLE_SLEEP(2);
+
+// Appends as much of `text` as fits, leaving room for the newline
+void append(char* line, size_t& length, const char* text, size_t size) {
+    const size_t room = LOG_RECORD_BYTES - 1 - length;
+    const size_t count = size < room ? size : room;
+    std::memcpy(line + length, text, count);
+    length += count;
+}
+
+void appendValue(char* line, size_t& length, const std::string& value) {
+    // Values with spaces are quoted so the line still splits on spaces
+    if (value.find(' ') == std::string::npos && !value.empty()) {
+        append(line, length, value.data(), value.size());
+    } else {
+        append(line, length, "\"", 1);
+        append(line, length, value.data(), value.size());
+        append(line, length, "\"", 1);
+    }
+}
+
+LogLevel levelFromEnv() {
+    const char* name = std::getenv("LOG_LEVEL");
+    if (!name) {return LogLevel::INFO;}
+    for (LogLevel level : {LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARNING, LogLevel::ERROR}) {
+        if (std::strcmp(name, Logger::levelName(level)) == 0) {return level;}
+    }
+    return LogLevel::INFO;
+}
+
+} // namespace
+
+
+Logger::Logger(Sink sink, size_t capacity)
+    : sink_(std::move(sink)), mask_(capacity - 1), slots_(new Slot[capacity])
+{
+    if (capacity == 0 || (capacity & mask_) != 0) {
+        throw std::logic_error("Logger capacity must be a power of two");
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    writer_ = std::thread(&Logger::_run, this);
+}
+
+
+Logger::~Logger() {
+    isStopping_.store(true);
+    writer_.join();
+}
+
+
+void Logger::log(LogLevel level, const std::string& message, std::initializer_list<LogField> fields) {
+    if (level < getLevel()) {return;}
+
+    // Claim a slot: its sequence equals the position once the writer has freed it
+    size_t position = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[position & mask_];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (lag == 0) {
+            if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {break;}
+        } else if (lag < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    const auto now = std::chrono::system_clock::now();
+    const std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    const int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count() % 1000);
+    std::tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char* line = slot->text;
+    size_t length = std::strftime(line, LOG_RECORD_BYTES, "%Y-%m-%dT%H:%M:%S", &utc);
+    length += static_cast<size_t>(std::snprintf(line + length, LOG_RECORD_BYTES - length, ".%03dZ %s ",
+                                                millis, levelName(level)));
+    append(line, length, message.data(), message.size());
+    for (const LogField& field : fields) {
+        append(line, length, " ", 1);
+        append(line, length, field.key, std::strlen(field.key));
+        append(line, length, "=", 1);
+        appendValue(line, length, field.value);
+    }
+    line[length++] = '\n';
+    slot->length = static_cast<uint16_t>(length);
+
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+
+void Logger::flush() {
+    const size_t target = head_.load(std::memory_order_acquire);
+    while (consumed_.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+}
+
+
+Logger& Logger::global() {
+    static Logger logger([](const char* data, size_t size) {
+        // Lines that do not make it to stderr have nowhere else to go
+        [[maybe_unused]] ssize_t written = ::write(STDERR_FILENO, data, size);
+    });
+    // Configured once, by whichever thread gets here first
+    static const bool isConfigured = [] {
+        logger.setLevel(levelFromEnv());
+        return true;
+    }();
+    (void)isConfigured;
+    return logger;
+}
+
+
+const char* Logger::levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+
+void Logger::_run() {
+    std::string batch;
+    while (true) {
+        // Checked before draining so nothing logged ahead of shutdown is left behind
+        const bool isStopping = isStopping_.load();
+        const size_t count = _drain(batch);
+        if (count) {
+            sink_(batch.data(), batch.size());
+            batch.clear();
+            consumed_.fetch_add(count, std::memory_order_release);
+        } else if (isStopping) {
+            return;
+        } else {
+            std::this_thread::sleep_for(IDLE_SLEEP);
+        }
+    }
+}
+
+
+size_t Logger::_drain(std::string& batch) {
+    size_t count = 0;
+    while (true) {
+        Slot& slot = slots_[tail_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail_ + 1) {break;}
+        batch.append(slot.text, slot.length);
+        // Frees the slot for the producer that laps the ring back to it
+        slot.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+        tail_++;
+        count++;
+    }
+    return count;
+}
@@ -1,5 +1,12 @@
 #include "game.h"
+#include "game_registry.h"
 #include "helper.hpp"
+#include "memory_sink.h"
+#include "crow_log_handler.hpp"
+#include "metrics_middleware.hpp"
+#include "tracing_middleware.hpp"
+#include "mysql_pool.hpp"
+#include "mysql_sink.hpp"
 #include "crow.h"
 #include "crow/middlewares/cors.h"
 #include "crow/middlewares/cookie_parser.h"
@@ -18,28 +25,56 @@
 using json = nlohmann::json;
 
 int main(int argc, char* argv[]) {
+    // Crow logs every request; its lines go through the same background writer as ours
+    CrowLogHandler crowLogHandler;
+    crow::logger::setHandler(&crowLogHandler);
+
+    // STORAGE=memory keeps the rows in process, so the server runs with no database, e.g. under loadgen
+    std::unique_ptr<MySqlPool> pool;
+    std::unique_ptr<PersistenceSink> sink;
+    if (envOr("STORAGE", "mysql") == "memory") {
+        sink = std::make_unique<MemorySink>();
+        CHESS_LOG_INFO("Storing games in memory");
+    } else {
+        const MySqlConfig dbConfig = mysqlConfigFromEnv();
+        pool = createMySqlPool(dbConfig);
 
-    sql::mysql::MySQL_Driver* driver;
-    std::unique_ptr<sql::Connection> con;
-
-    try {
-        driver = sql::mysql::get_mysql_driver_instance();
-        con.reset(driver->connect("tcp://127.0.0.1:3306", "root", "my_secret_pw"));
-        con->setSchema("mystery_mate_database");
-    } catch (sql::SQLException& e) {
-        std::cerr << "Error connecting to MySQL: " << e.what() << std::endl;
-        return EXIT_FAILURE;
+        try {
+            // Open the first connection up front so a bad configuration fails at startup
+            pool->acquire();
+        } catch (sql::SQLException& e) {
+            CHESS_LOG_ERROR("Error connecting to MySQL", {{"host", dbConfig.host}, {"error", e.what()}});
+            Logger::global().flush();
+            return EXIT_FAILURE;
+        }
+        sink = std::make_unique<MySqlSink>(*pool);
     }
 
+    // Handlers enqueue state changes; one writer thread batches them into storage
+    WriteBehindQueue persistence(*sink, writeBehindConfigFromEnv());
+
+    // Live games are served from memory and logged move by move, so a restart picks them back up
+    GameRegistry registry(envOr("GAME_LOG_DIR", "games"));
+    CHESS_LOG_INFO("Recovered games", {{"count", registry.recover()}, {"directory", envOr("GAME_LOG_DIR", "games")}});
+
+    // Both players of a game hear about every change over /game/ws instead of polling
+    GameChannel channel;
+    // Versions only mean something within one run of the server, so ETags and board diffs carry the run's ID
+    const std::string runID = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+    const std::string etagPrefix = runID + "-";
+
+    // Requests at least this slow keep their spans for /debug/traces
+    Tracer::global().setSlowThreshold(std::chrono::milliseconds(std::stoi(envOr("TRACE_SLOW_MS", std::to_string(TRACE_SLOW_MILLISECONDS)))));
+
     // Enable CORS
-    crow::App<crow::CORSHandler, crow::CookieParser> app;
+    crow::App<RequestTracing, crow::CORSHandler, crow::CookieParser, RouteMetrics> app;
 
     // Customize CORS
     auto& cors = app.get_middleware<crow::CORSHandler>();
 
     cors.global() // Setting CORS policies for all routes
         .methods("GET"_method, "POST"_method, "PUT"_method, "DELETE"_method, "OPTIONS"_method)
-        .headers("Content-Type","Upgrade-Insecure-Requests")
+        .headers("Content-Type","Upgrade-Insecure-Requests","If-None-Match")
         .origin("http://localhost:3000")
         .allow_credentials();
 
@@ -55,18 +90,18 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/startNew")
     .methods("GET"_method)
-    ([&app, &con] (const crow::request& req) {
+    ([&app, &persistence, &registry] (const crow::request& req) {
         crow::response res;
         json status;
 
         try {
             std::string playerToken = generatePlayerToken();
-            std::cout << "Player ID Generated: " << playerToken << std::endl;
-            createPlayer(con.get(), playerToken, Color::WHITE);
+            createPlayer(persistence, playerToken, Color::WHITE);
 
             std::string gameID = generateGameID();
-            std::cout << "Game ID Generated: " << gameID << std::endl;
-            createGame(con.get(), gameID);
+            createGame(persistence, gameID);
+            registry.create(gameID, playerToken);
+            CHESS_LOG_INFO("Game created", {{"route", "/game/startNew"}, {"gameID", gameID}, {"playerID", playerToken}});
 
             status["status"] = GameStateToInt(GameState::WAITING_FOR_OPPONENT);
 
@@ -96,29 +131,24 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/join")
     .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &persistence, &registry, &channel](const crow::request& req) {
         json status;
         try {
             auto jsonBody = json::parse(req.body);
-            if (!validateJsonFields(jsonBody, {"gameID"})) {
-                throw std::runtime_error("Missing required fields");
-            }
+            validateJsonFields(jsonBody, {"gameID"});
 
             auto gameID = jsonBody["gameID"].get<std::string>();
-            if (!validateGame(con.get(), gameID)) {
-                throw std::runtime_error("Invalid or non-existent game ID");
-            }
+            auto pSession = findGame(registry, gameID);
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
 
             const auto playerToken = generatePlayerToken();
-            auto pBlackPlayer = createPlayer(con.get(), playerToken, Color::BLACK);
-
-            // Load white player and other game state data from the database
-            auto pWhitePlayer = loadPlayerForGame(con.get(), gameID);  // This method needs to be defined
-            auto pGame = initializeGame(pWhitePlayer, pBlackPlayer);
+            pSession->join(playerToken);
+            createPlayer(persistence, playerToken, Color::BLACK);
+            updateGameState(persistence, gameID, pSession->getGameState());
+            publishGameEvent(channel, *pSession, "joined");
+            CHESS_LOG_INFO("Game joined", {{"route", "/game/join"}, {"gameID", gameID}, {"playerID", playerToken}});
 
-            updateGameState(con.get(), gameID, pGame->getGameState());
-
-            status["status"] = GameStateToInt(pGame->getGameState());
+            status["status"] = GameStateToInt(pSession->getGameState());
 
             crow::response response(200, status.dump());
             auto& ctx = app.get_context<crow::CookieParser>(req);
@@ -142,7 +172,7 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/select/horcrux")
     .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &persistence, &registry, &channel](const crow::request& req) {
         json status;
 
         try {
@@ -151,26 +181,29 @@ int main(int argc, char* argv[]) {
             auto gameID = ctx.get_cookie("gameID");
             auto playerID = ctx.get_cookie("playerID");
 
-            std::cout << "Received request body: " << req.body << std::endl;
-            
-            Player* pPlayer = findPlayer(con.get(), playerID);
-            std::cout << "Player Color: " << int(pPlayer->getColor()) << std::endl;
+            auto pSession = findGame(registry, gameID);
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            Player* pPlayer = findPlayer(*pSession, playerID);
+            Game& game = pSession->getGame();
 
-            Game* pGame = findGame(con.get(), gameID);
-            
             auto [file, rank] = parseFileAndRank(req.body);
-            const IPiece* horcrux = pGame->getPieceFromPosition(Position(file, rank));
+            const IPiece* horcrux = game.getPieceFromPosition(Position(file, rank));
             if (horcrux) {
                 int horcruxID = horcrux->getID();
                 status["horcruxID"] = horcruxID;
-                pPlayer->setHorcruxID(horcruxID);
-                pGame->checkHorcruxSet();
+                const bool isSet = pSession->selectHorcrux(pPlayer, horcruxID);
+                updatePlayerHorcrux(persistence, playerID, horcruxID);
+                if (isSet) {
+                    updateGameState(persistence, gameID, game.getGameState());
+                }
+                // The opponent only learns that a horcrux was chosen, never which
+                publishGameEvent(channel, *pSession, "horcrux", {{"color", static_cast<int>(pPlayer->getColor())}});
             } else {
                 throw std::runtime_error("Could not find piece on the selected square");
             }
 
-            status["status"] = GameStateToInt(pGame->getGameState());
-            
+            status["status"] = GameStateToInt(game.getGameState());
+
             crow::response response(200, status.dump());
             response.set_header("Content-type", "application/json");
             return response;
@@ -178,6 +211,10 @@ int main(int argc, char* argv[]) {
             crow::response response(400, "Parse error: " + std::string(e.what()));
             response.set_header("Content-type", "application/json");
             return response;
+        } catch(const std::invalid_argument& e) {
+            crow::response response(400, "Invalid square: " + std::string(e.what()));
+            response.set_header("Content-type", "application/json");
+            return response;
         } catch(const std::exception& e) {
             return createErrorResponse(e);
         }
@@ -185,7 +222,7 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/guess/horcrux")
     .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry, &channel](const crow::request& req) {
         json status;
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
@@ -193,27 +230,30 @@ int main(int argc, char* argv[]) {
             auto gameID = ctx.get_cookie("gameID");
             auto playerID = ctx.get_cookie("playerID");
 
-            // Split the body into 'from' and 'to' parts using semicolon as the delimiter
-            std::string requestBody = req.body;
-
-            // Use the parseFileAndRank function to extract 'from' and 'to' positions
-            auto [squareFile, squareRank] = parseFileAndRank(requestBody);
-
-            // Convert to Position objects
+            // Use the parseFileAndRank function to extract the guessed square
+            auto [squareFile, squareRank] = parseFileAndRank(req.body);
             Position from(squareFile, squareRank);
 
-            Game* pGame = findGame(con.get(), gameID); // Using the helper function to find a game
-            Player* pPlayer = findPlayer(con.get(), playerID); // Use a function to find a player
+            auto pSession = findGame(registry, gameID);
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            Player* pPlayer = findPlayer(*pSession, playerID);
+            Game& game = pSession->getGame();
 
-            const IPiece* pPiece = pGame->getBoard()->getSquare(from)->getPiece();
+            const IPiece* pPiece = game.getPieceFromPosition(from);
+            if (!pPiece) {
+                throw std::runtime_error("Could not find piece on the selected square");
+            }
 
             // Perform the guess and update the status
-            Player* pPlayerToCheck;
-            pPlayer->getColor() == Color::WHITE ? pPlayerToCheck = pGame->blackPlayer : pPlayerToCheck = pGame->whitePlayer;
-            bool guessCorrect = pGame->horcruxGuess(pPiece->getID(), pPlayer, pPlayerToCheck);
+            bool guessCorrect = pSession->guessHorcrux(pPlayer, pPiece->getID());
+            publishGameEvent(channel, *pSession, "guess", {
+                {"color", static_cast<int>(pPlayer->getColor())},
+                {"correct", guessCorrect},
+                {"guessesLeft", pPlayer->getNumberOfHorcruxGuessesLeft()}
+            });
 
             status["guess"] = guessCorrect;
-            status["status"] = GameStateToInt(pGame->getGameState());
+            status["status"] = GameStateToInt(game.getGameState());
 
             crow::response response(200, status.dump());
             response.set_header("Content-type", "application/json");
@@ -222,42 +262,8 @@ int main(int argc, char* argv[]) {
             crow::response response(400, "Invalid JSON format.");
             response.set_header("Content-type", "application/json");
             return response;
-        } catch(const std::exception& e) {
-            return createErrorResponse(e);
-        }
-    });
-
-    CROW_ROUTE(app, "/game/select/horcrux")
-    .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
-        json status;
-
-        try {
-            auto& ctx = app.get_context<crow::CookieParser>(req);
-            auto gameID = ctx.get_cookie("gameID");
-            auto playerID = ctx.get_cookie("playerID");
-
-            auto pPlayer = findPlayer(con.get(), playerID);
-            auto pGame = findGame(con.get(), gameID);
-
-            auto [file, rank] = parseFileAndRank(req.body);
-            const IPiece* horcrux = pGame->getPieceFromPosition(Position(file, rank));
-            if (horcrux) {
-                int horcruxID = horcrux->getID();
-                status["horcruxID"] = horcruxID;
-                updatePlayerHorcrux(con.get(), playerID, horcruxID);
-                pGame->checkHorcruxSet(); 
-            } else {
-                throw std::runtime_error("Could not find piece on the selected square");
-            }
-
-            status["status"] = GameStateToInt(pGame->getGameState());
-
-            crow::response response(200, status.dump());
-            response.set_header("Content-type", "application/json");
-            return response;
-        } catch(const nlohmann::json::exception& e) {
-            crow::response response(400, "Parse error: " + std::string(e.what()));
+        } catch(const std::invalid_argument& e) {
+            crow::response response(400, "Invalid square: " + std::string(e.what()));
             response.set_header("Content-type", "application/json");
             return response;
         } catch(const std::exception& e) {
@@ -267,7 +273,7 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/move")
     .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &persistence, &registry, &channel](const crow::request& req) {
         json status; 
 
         try {
@@ -290,12 +296,19 @@ int main(int argc, char* argv[]) {
             Position from(fromFile, fromRank);
             Position to(toFile, toRank);
 
-            auto pGame = findGame(con.get(), gameID);
-            auto pPlayer = findPlayer(con.get(), playerID);
+            auto pSession = findGame(registry, gameID);
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            Player* pPlayer = findPlayer(*pSession, playerID);
+            Game& game = pSession->getGame();
+
+            pSession->movePiece(pPlayer, from, to);
+            updateGameState(persistence, gameID, game.getGameState());
+            publishGameEvent(channel, *pSession, "move", {
+                {"from", {{"file", std::string(1, from.getFile())}, {"rank", from.getRank()}}},
+                {"to", {{"file", std::string(1, to.getFile())}, {"rank", to.getRank()}}}
+            });
 
-            pGame->movePiece(Move(from, to, pPlayer->getId())); // Move method needs player ID and positions
-            
-            status["status"] = GameStateToInt(pGame->getGameState());
+            status["status"] = GameStateToInt(game.getGameState());
 
             crow::response response(200, status.dump());
             response.set_header("Content-type", "application/json");
@@ -304,6 +317,10 @@ int main(int argc, char* argv[]) {
             crow::response response(400, "Invalid JSON format.");
             response.set_header("Content-type", "application/json");
             return response;
+        } catch(const std::invalid_argument& e) {
+            crow::response response(400, "Invalid square: " + std::string(e.what()));
+            response.set_header("Content-type", "application/json");
+            return response;
         } catch(const std::exception& e) {
             return createErrorResponse(e);
         }
@@ -311,28 +328,36 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/state")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
-        json status;
-
+    ([&app, &registry, &etagPrefix](const crow::request& req, crow::response& res) {
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
 
-            auto pGame = findGame(con.get(), gameID);
+            auto pSession = registry.find(gameID);
 
-            if (!pGame) {
+            if (!pSession) {
                 // If the game is not found, we assume it's waiting for an opponent to join
+                json status;
                 status["status"] = GameStateToInt(GameState::WAITING_FOR_OPPONENT);
-            } else {
-                // If the game is found, report its current state
-                status["status"] = GameStateToInt(pGame->getGameState());
+                res = crow::response(200, status.dump());
+                res.set_header("Content-type", "application/json");
+                res.end();
+                return;
             }
 
-            crow::response response(200, status.dump());
-            response.set_header("Content-type", "application/json");
-            return response;
+            // If the game is found, report its current state
+            respondVersioned(req, res, pSession, etagPrefix, [](GameSession& session) {
+                json status;
+                status["status"] = GameStateToInt(session.getGameState());
+                status["version"] = session.getVersion();
+
+                crow::response response(200, status.dump());
+                response.set_header("Content-type", "application/json");
+                return response;
+            });
         } catch(const std::exception& e) {
-            return createErrorResponse(e);
+            res = createErrorResponse(e);
+            res.end();
         }
     });
 
@@ -354,74 +379,102 @@ int main(int argc, char* argv[]) {
         }
     });
 
+    // With ?since=<version>&run=<run ID> only the squares changed since then are sent
     CROW_ROUTE(app, "/game/board")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry, &runID, &etagPrefix](const crow::request& req, crow::response& res) {
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
-            auto playerID = ctx.get_cookie("playerID");
 
-            auto pGame = findGame(con.get(), gameID);
-            auto pPlayer = findPlayer(con.get(), playerID);
-
-            json status;
-            json squaresJson;
+            const bool isDiff = req.url_params.get("since") != nullptr;
+            uint64_t since = 0;
+            if (isDiff && !parseVersion(req.url_params.get("since"), since)) {
+                res = crow::response(400, "Invalid since version.");
+                res.end();
+                return;
+            }
 
-            bool isBlack = (pPlayer && pPlayer->getColor() == Color::BLACK);
+            auto pSession = findGame(registry, gameID);
+            const std::string run = req.url_params.get("run") ? req.url_params.get("run") : "";
+            const std::string viewPrefix = isDiff ? etagPrefix + "since" + std::to_string(since) + "-" : etagPrefix;
+            respondVersioned(req, res, pSession, viewPrefix, [&runID, isDiff, since, run](GameSession& session) {
+                json status;
+                if (isDiff) {
+                    status = boardDiffJson(session, runID, since, run);
+                } else {
+                    status["squares"] = boardJson(session.getGame());
+                    status["version"] = session.getVersion();
+                    status["run"] = runID;
+                }
 
-            for (const auto& [pos, square] : pGame->getBoard()->squares) {
-                char file = pos.getFile();
-                int rank = pos.getRank();
+                crow::response response(200, status.dump());
+                response.set_header("Content-type", "application/json");
+                return response;
+            });
+        } catch(const std::exception& e) {
+            res = createErrorResponse(e);
+            res.end();
+        }
+    });
 
-                json squareJson;
-                squareJson["position"] = { {"file", std::string(1, file)}, {"rank", rank} };
+    CROW_ROUTE(app, "/game/snapshot")
+    .methods("GET"_method)
+    ([&app, &registry, &etagPrefix](const crow::request& req, crow::response& res) {
+        try {
+            auto& ctx = app.get_context<crow::CookieParser>(req);
+            auto gameID = ctx.get_cookie("gameID");
+            auto playerID = ctx.get_cookie("playerID");
 
-                if (square->getPiece()) {
-                    squareJson["piece"]["id"] = square->getPiece()->getID();
-                    squareJson["piece"]["type"] = square->getPiece()->getType();
-                    squareJson["piece"]["color"] = square->getPiece()->getColor();
-                }
-                squaresJson.push_back(squareJson);
+            auto pSession = findGame(registry, gameID);
+            Color color;
+            {
+                std::lock_guard<std::mutex> lock(pSession->getMutex());
+                color = findPlayer(*pSession, playerID)->getColor();
             }
 
-            status["squares"] = squaresJson;
-
-            crow::response response(200, status.dump());
-            response.set_header("Content-type", "application/json");
-            return response;
+            // Each player sees a different view of the same version, so their ETags differ
+            const std::string viewPrefix = etagPrefix + (color == Color::WHITE ? "w-" : "b-");
+            respondVersioned(req, res, pSession, viewPrefix, [color](GameSession& session) {
+                crow::response response(200, gameSnapshotJson(session, *session.getPlayer(color)).dump());
+                response.set_header("Content-type", "application/json");
+                return response;
+            });
         } catch(const std::exception& e) {
-            return createErrorResponse(e);
+            res = createErrorResponse(e);
+            res.end();
         }
     });
 
     CROW_ROUTE(app, "/game/positions")
     .methods("POST"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry](const crow::request& req) {
         json status;
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
             auto playerID = ctx.get_cookie("playerID");
 
-            auto pPlayer = findPlayer(con.get(), playerID);
+            auto pSession = registry.find(gameID);
+            if (!pSession)
+                return crow::response(400, "Game not found.");
+
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            Player* pPlayer = pSession->findPlayer(playerID);
             if (!pPlayer) 
                 return crow::response(400, "Player not found.");
 
-            auto pGame = findGame(con.get(), gameID);
-            if (!pGame)
-                return crow::response(400, "Game not found.");
-
+            Game& game = pSession->getGame();
             auto [file, rank] = parseFileAndRank(req.body);
             Position from(file, rank);
-            const IPiece* piece = pGame->getPieceFromPosition(from);
+            const IPiece* piece = game.getPieceFromPosition(from);
 
             if (!piece || piece->getColor() != pPlayer->getColor()) {
                 return crow::response(400, "Invalid piece or player color does not match piece color.");
             }
 
             json jsonObjs;
-            for (const auto& pos : pGame->getAvailablePositions(piece, from)) {
+            for (const auto& pos : game.getAvailablePositions(piece, from)) {
                 json jsonObj;
                 jsonObj["rank"] = pos.getRank();
                 jsonObj["file"] = std::string(1, pos.getFile());
@@ -437,6 +490,10 @@ int main(int argc, char* argv[]) {
             crow::response response(400, "Invalid JSON format: " + std::string(e.what()));
             response.set_header("Content-type", "application/json");
             return response;
+        } catch(const std::invalid_argument& e) {
+            crow::response response(400, "Invalid square: " + std::string(e.what()));
+            response.set_header("Content-type", "application/json");
+            return response;
         } catch(const std::exception& e) {
             return createErrorResponse(e);
         }
@@ -444,18 +501,19 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/result")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry](const crow::request& req) {
         json status;
 
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
 
-            auto pGame = findGame(con.get(), gameID);
-            if (!pGame) 
+            auto pSession = registry.find(gameID);
+            if (!pSession) 
                 return crow::response(404, "Game not found");
 
-            status["status"] = GameEndToInt(pGame->getGameResult());
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            status["status"] = GameEndToInt(pSession->getGame().getGameResult());
 
             crow::response response(200, status.dump());
             response.set_header("Content-type", "application/json");
@@ -467,14 +525,13 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/isGameInProgress")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry](const crow::request& req) {
         json status;
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
 
-            auto pGame = findGame(con.get(), gameID);
-            status["isInProgress"] = !pGame ? false : true;
+            status["isInProgress"] = registry.find(gameID) != nullptr;
 
             return crow::response(200, status.dump());
 
@@ -486,13 +543,19 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/numberOfHorcruxGuessesLeft")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &registry](const crow::request& req) {
         json status;
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
+            auto gameID = ctx.get_cookie("gameID");
             auto playerID = ctx.get_cookie("playerID");
 
-            auto pPlayer = findPlayer(con.get(), playerID);
+            auto pSession = registry.find(gameID);
+            if (!pSession)
+                return crow::response(404, "Game not found");
+
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            Player* pPlayer = pSession->findPlayer(playerID);
             if (!pPlayer)
                 return crow::response(404, "Player not found");
 
@@ -506,14 +569,17 @@ int main(int argc, char* argv[]) {
 
     CROW_ROUTE(app, "/game/end")
     .methods("GET"_method)
-    ([&app, &con](const crow::request& req) {
+    ([&app, &persistence, &registry, &channel](const crow::request& req) {
         try {
             auto& ctx = app.get_context<crow::CookieParser>(req);
             auto gameID = ctx.get_cookie("gameID");
             auto playerID = ctx.get_cookie("playerID");
 
-            removePlayer(con.get(), playerID);
-            killGame(con.get(), gameID);
+            if (registry.remove(gameID)) {
+                channel.publish(gameID, json{{"event", "closed"}}.dump());
+            }
+            removePlayer(persistence, playerID);
+            killGame(persistence, gameID);
 
             return crow::response(200);
         } catch(const std::exception& e) {
@@ -521,6 +587,76 @@ int main(int argc, char* argv[]) {
         }
     });
     
+    // Push channel for one player. The cookies pick the game; the first message is its current state.
+    CROW_WEBSOCKET_ROUTE(app, "/game/ws")
+    .onaccept([&registry](const crow::request& req, void** userdata) {
+        const std::string cookies = req.get_header_value("Cookie");
+        auto pSession = registry.find(cookieValue(cookies, "gameID"));
+        if (!pSession) {return false;}
+
+        std::lock_guard<std::mutex> lock(pSession->getMutex());
+        if (!pSession->findPlayer(cookieValue(cookies, "playerID"))) {return false;}
+        *userdata = new std::string(pSession->getGameID());
+        return true;
+    })
+    .onopen([&registry, &channel](crow::websocket::connection& conn) {
+        const std::string& gameID = *static_cast<std::string*>(conn.userdata());
+        channel.subscribe(gameID, &conn, [&conn](const std::string& message) {conn.send_text(message);});
+
+        if (auto pSession = registry.find(gameID)) {
+            std::lock_guard<std::mutex> lock(pSession->getMutex());
+            conn.send_text(json{{"event", "state"}, {"status", static_cast<int>(pSession->getGameState())}}.dump());
+        }
+    })
+    .onclose([&channel](crow::websocket::connection& conn, const std::string&) {
+        channel.unsubscribe(&conn);
+        delete static_cast<std::string*>(conn.userdata());
+    });
+
+    CROW_ROUTE(app, "/metrics")
+    .methods("GET"_method)
+    ([&pool, &persistence, &registry, &channel]() {
+        std::ostringstream out;
+        if (pool) {writePoolMetrics(out, "mysql_pool", pool->getStats());}
+        writeQueueMetrics(out, "persistence_queue", persistence.getStats());
+        writeGauge(out, "live_games", registry.size());
+        writeGauge(out, "websocket_clients", channel.getSubscriberCount());
+        out << "# TYPE log_dropped_lines_total counter\nlog_dropped_lines_total " << Logger::global().getDropped() << "\n";
+        MetricsRegistry::global().write(out);
+
+        crow::response response(200, out.str());
+        response.set_header("Content-type", "text/plain; version=0.0.4");
+        return response;
+    });
+
+    // The slowest recent requests with their spans, as text or, with ?format=chrome, as Chrome trace-event JSON
+    CROW_ROUTE(app, "/debug/traces")
+    .methods("GET"_method)
+    ([](const crow::request& req) {
+        const std::vector<CompletedTrace> traces = Tracer::global().getSlowTraces();
+        std::ostringstream out;
+        const char* format = req.url_params.get("format");
+        crow::response response;
+        if (format && std::string(format) == "chrome") {
+            writeChromeTrace(out, traces);
+            response.set_header("Content-type", "application/json");
+        } else {
+            writeTraceText(out, traces);
+            response.set_header("Content-type", "text/plain");
+        }
+        response.code = 200;
+        response.body = out.str();
+        return response;
+    });
+
+    // Every HTTP route gets its own latency series; the WebSocket upgrade is not timed
+    auto& routeMetrics = app.get_middleware<RouteMetrics>();
+    for (const char* route : {"/", "/cors", "/game/startNew", "/game/join", "/game/select/horcrux", "/game/guess/horcrux",
+                              "/game/move", "/game/state", "/game/gameID", "/game/board", "/game/snapshot", "/game/positions",
+                              "/game/result", "/game/isGameInProgress", "/game/numberOfHorcruxGuessesLeft", "/game/end", "/metrics", "/debug/traces"}) {
+        routeMetrics.track(route);
+    }
+
     const char* port_str = std::getenv("PORT");
     int port = port_str ? std::stoi(port_str) : 8080;
     
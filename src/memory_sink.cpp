@@ -0,0 +1,63 @@
+#include "memory_sink.h"
+
+
+void MemorySink::writeBatch(const std::vector<PersistEvent>& events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const PersistEvent& event : events) {
+        switch (event.type) {
+            case PersistEventType::CREATE_GAME:
+                games_[event.gameID] = event.value;
+                break;
+            case PersistEventType::GAME_STATE: {
+                // Like an UPDATE, this leaves a deleted game deleted
+                auto it = games_.find(event.gameID);
+                if (it != games_.end()) {it->second = event.value;}
+                break;
+            }
+            case PersistEventType::CREATE_PLAYER:
+                players_[event.playerID].color = event.value;
+                break;
+            case PersistEventType::PLAYER_HORCRUX: {
+                auto it = players_.find(event.playerID);
+                if (it != players_.end()) {it->second.horcruxID = event.value;}
+                break;
+            }
+            case PersistEventType::REMOVE_PLAYER:
+                players_.erase(event.playerID);
+                break;
+            case PersistEventType::KILL_GAME:
+                games_.erase(event.gameID);
+                break;
+        }
+    }
+}
+
+
+bool MemorySink::findGameState(const std::string& gameID, int& state) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = games_.find(gameID);
+    if (it == games_.end()) {return false;}
+    state = it->second;
+    return true;
+}
+
+
+bool MemorySink::findPlayer(const std::string& playerID, StoredPlayer& player) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = players_.find(playerID);
+    if (it == players_.end()) {return false;}
+    player = it->second;
+    return true;
+}
+
+
+size_t MemorySink::getGameCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return games_.size();
+}
+
+
+size_t MemorySink::getPlayerCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return players_.size();
+}
@@ -0,0 +1,147 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// Bucket index where values of at least (4 + subBucket) << (octave - 2) ns start
+size_t bucketStart(int octave, int subBucket) {
+    return static_cast<size_t>(octave - 1) * HISTOGRAM_SUB_BUCKETS + static_cast<size_t>(subBucket);
+}
+
+void writeLabels(std::ostream& out, const std::string& labels, const std::string& extra = "") {
+    if (labels.empty() && extra.empty()) {return;}
+    out << "{" << labels << (labels.empty() || extra.empty() ? "" : ",") << extra << "}";
+}
+
+std::string formatSeconds(uint64_t nanos) {
+    std::ostringstream text;
+    text << nanos / 1e9;
+    return text.str();
+}
+
+void writeHistogram(std::ostream& out, const std::string& name, const std::string& labels, const HistogramSnapshot& snapshot) {
+    for (int octave = HISTOGRAM_EXPORT_MIN_OCTAVE; octave < HISTOGRAM_EXPORT_MAX_OCTAVE; ++octave) {
+        for (int subBucket = 0; subBucket < HISTOGRAM_SUB_BUCKETS; ++subBucket) {
+            const uint64_t boundNanos = static_cast<uint64_t>(HISTOGRAM_SUB_BUCKETS + subBucket) << (octave - 2);
+            out << name << "_bucket";
+            writeLabels(out, labels, "le=\"" + formatSeconds(boundNanos) + "\"");
+            out << " " << snapshot.countBelow(octave, subBucket) << "\n";
+        }
+    }
+    out << name << "_bucket";
+    writeLabels(out, labels, "le=\"+Inf\"");
+    out << " " << snapshot.count << "\n";
+
+    out << name << "_sum";
+    writeLabels(out, labels);
+    out << " " << snapshot.sumNanos / 1e9 << "\n";
+    out << name << "_count";
+    writeLabels(out, labels);
+    out << " " << snapshot.count << "\n";
+}
+
+} // namespace
+
+
+size_t metrics_detail::shardIndex() {
+    static std::atomic<size_t> nextShard{0};
+    thread_local const size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRICS_SHARDS;
+    return shard;
+}
+
+
+uint64_t Counter::getValue() const {
+    uint64_t value = 0;
+    for (const Shard& shard : shards_) {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+
+uint64_t HistogramSnapshot::countBelow(int octave, int subBucket) const {
+    const size_t end = bucketStart(octave, subBucket);
+    uint64_t below = 0;
+    for (size_t i = 0; i < end && i < buckets.size(); ++i) {
+        below += buckets[i];
+    }
+    return below;
+}
+
+
+uint64_t HistogramSnapshot::quantileNanos(double quantile) const {
+    if (count == 0) {return 0;}
+    // Rank of the value wanted, counting from 1
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {return LatencyHistogram::bucketEnd(i);}
+    }
+    return LatencyHistogram::bucketEnd(buckets.size() - 1);
+}
+
+
+HistogramSnapshot LatencyHistogram::getSnapshot() const {
+    HistogramSnapshot snapshot;
+    for (const Shard& shard : shards_) {
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.sumNanos += shard.sumNanos.load(std::memory_order_relaxed);
+    }
+    for (uint64_t bucket : snapshot.buckets) {
+        snapshot.count += bucket;
+    }
+    return snapshot;
+}
+
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_ptr<Counter>& pCounter = counters_[{name, labels}];
+    if (!pCounter) {pCounter = std::make_unique<Counter>();}
+    return *pCounter;
+}
+
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_ptr<LatencyHistogram>& pHistogram = histograms_[{name, labels}];
+    if (!pHistogram) {pHistogram = std::make_unique<LatencyHistogram>();}
+    return *pHistogram;
+}
+
+
+void MetricsRegistry::write(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // The maps are ordered by name, so each family's series follow its TYPE line
+    const std::string* pFamily = nullptr;
+    for (const auto& [key, pCounter] : counters_) {
+        if (!pFamily || *pFamily != key.first) {
+            out << "# TYPE " << key.first << " counter\n";
+            pFamily = &key.first;
+        }
+        out << key.first;
+        writeLabels(out, key.second);
+        out << " " << pCounter->getValue() << "\n";
+    }
+
+    pFamily = nullptr;
+    for (const auto& [key, pHistogram] : histograms_) {
+        if (!pFamily || *pFamily != key.first) {
+            out << "# TYPE " << key.first << " histogram\n";
+            pFamily = &key.first;
+        }
+        writeHistogram(out, key.first, key.second, pHistogram->getSnapshot());
+    }
+}
+
+
+MetricsRegistry& MetricsRegistry::global() {
+    static MetricsRegistry registry;
+    return registry;
+}
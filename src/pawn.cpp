@@ -1,24 +1,37 @@
 #include "pawn.h"
-#include <iostream>
-
-std::unordered_set<Position> Pawn::getPossiblePositions(const Position& from) const {
-    std::unordered_set<Position> possiblePositions;
+#include "move_list.h"
 
+Bitboard Pawn::pushTargets_(int from) const {
     int forwardDirection = (color_ == Color::WHITE) ? 1 : -1;
-    Position forwardPosition(from.getFile(), from.getRank() + forwardDirection);
-    Position doubleForwardPosition(from.getFile(), from.getRank() + 2 * forwardDirection);
+    int startRank = (color_ == Color::WHITE) ? 1 : GRID_SIZE - 2;
 
-    possiblePositions.emplace(forwardPosition);
+    int forwardRank = rankOf(from) + forwardDirection;
+    if (forwardRank < 0 || forwardRank >= GRID_SIZE) {return EMPTY_BITBOARD;}
 
-    if ((color_ == Color::WHITE && from.getRank() == 2) || (color_ == Color::BLACK && from.getRank() == GRID_SIZE - 1)) {
-        possiblePositions.emplace(doubleForwardPosition);
+    Bitboard targets = squareBit(squareIndex(fileOf(from), forwardRank));
+    if (rankOf(from) == startRank) {
+        targets |= squareBit(squareIndex(fileOf(from), forwardRank + forwardDirection));
     }
+    return targets;
+}
+
+std::unordered_set<Position> Pawn::getPossiblePositions(const Position& from) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return {};}
 
-    return possiblePositions;
+    return toPositions(pushTargets_(square));
 };
 
+void Pawn::getPossibleMoves(const Position& from, MoveList& moves) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return;}
+
+    moves.addMoves(square, pushTargets_(square), EMPTY_BITBOARD);
+}
+
 bool Pawn::isValidMove(const Move& move) const {
-    std::unordered_set possiblePositions = getPossiblePositions(move.getFrom());
+    int from = toSquare(move.getFrom());
+    if (from == NO_SQUARE) {return false;}
 
-    return possiblePositions.find(move.getTo()) != possiblePositions.end();
+    return containsPosition(pushTargets_(from), move.getTo());
 };
\ No newline at end of file
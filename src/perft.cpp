@@ -0,0 +1,95 @@
+#include "perft.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+
+Color opposite(Color color) {
+    return color == Color::WHITE ? Color::BLACK : Color::WHITE;
+}
+
+}
+
+
+const std::vector<PerftPosition>& referencePerftPositions() {
+    static const std::vector<PerftPosition> positions = {
+        {"start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+         {20, 400, 8902, 197281, 4865609}},
+        {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+         {48, 2039, 97862, 4085603}},
+        {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+         {14, 191, 2812, 43238, 674624}},
+        {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+         {6, 264, 9467, 422333}},
+        {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+         {44, 1486, 62379, 2103487}},
+        {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+         {46, 2079, 89890, 3894594}},
+    };
+    return positions;
+}
+
+
+uint64_t perft(Board& board, const BoardRules& rules, Color sideToMove, int depth) {
+    if (depth <= 0) {return 1;}
+
+    MoveList moves;
+    rules.generateLegalMoves(board, sideToMove, moves);
+    // Bulk counting: the last ply only needs the number of legal moves
+    if (depth == 1) {return moves.size();}
+
+    uint64_t nodes = 0;
+    for (const CompactMove& move : moves) {
+        const UndoRecord undo = board.makeMove(move);
+        nodes += perft(board, rules, opposite(sideToMove), depth - 1);
+        board.unmakeMove(move, undo);
+    }
+    return nodes;
+}
+
+
+std::vector<std::pair<CompactMove, uint64_t>> perftDivide(Board& board, const BoardRules& rules, Color sideToMove, int depth) {
+    std::vector<std::pair<CompactMove, uint64_t>> divide;
+    if (depth <= 0) {return divide;}
+
+    MoveList moves;
+    rules.generateLegalMoves(board, sideToMove, moves);
+    for (const CompactMove& move : moves) {
+        const UndoRecord undo = board.makeMove(move);
+        divide.emplace_back(move, perft(board, rules, opposite(sideToMove), depth - 1));
+        board.unmakeMove(move, undo);
+    }
+    return divide;
+}
+
+
+uint64_t perftParallel(const Board& board, const BoardRules& rules, Color sideToMove, int depth, unsigned threads) {
+    if (depth <= 1 || threads <= 1) {
+        Board copy = board;
+        return perft(copy, rules, sideToMove, depth);
+    }
+
+    MoveList moves;
+    rules.generateLegalMoves(board, sideToMove, moves);
+
+    // Workers pull root moves off a shared counter so an expensive subtree does not hold up the rest
+    std::atomic<size_t> nextMove(0);
+    std::atomic<uint64_t> nodes(0);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            Board copy = board;
+            uint64_t workerNodes = 0;
+            for (size_t index = nextMove++; index < moves.size(); index = nextMove++) {
+                const UndoRecord undo = copy.makeMove(moves[index]);
+                workerNodes += perft(copy, rules, opposite(sideToMove), depth - 1);
+                copy.unmakeMove(moves[index], undo);
+            }
+            nodes += workerNodes;
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    return nodes;
+}
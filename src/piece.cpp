@@ -0,0 +1,14 @@
+#include "piece.h"
+#include "move_list.h"
+
+void IPiece::getPossibleMoves(const Position& from, MoveList& moves) const {
+    int square = toSquare(from);
+    if (square == NO_SQUARE) {return;}
+
+    for (const Position& to : getPossiblePositions(from)) {
+        int target = toSquare(to);
+        if (target != NO_SQUARE) {
+            moves.push_back(CompactMove(square, target));
+        }
+    }
+}
\ No newline at end of file
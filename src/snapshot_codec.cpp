@@ -0,0 +1,143 @@
+#include "snapshot_codec.h"
+#include "fen.h"
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t PIECES_OFFSET = 1;
+constexpr size_t FLAGS_OFFSET = PIECES_OFFSET + NUMBER_OF_PIECES;
+constexpr size_t PLAYERS_OFFSET = FLAGS_OFFSET + 8;
+constexpr size_t CHECKSUM_OFFSET = SNAPSHOT_BYTES - 1;
+
+constexpr uint8_t NO_EN_PASSANT = 0xFF;
+constexpr uint8_t SIDE_TO_MOVE_BIT = 0x10;
+constexpr uint8_t HORCRUX_FOUND_BIT = 0x1;
+constexpr uint8_t HORCRUX_CAPTURED_BIT = 0x2;
+constexpr uint8_t KING_CAPTURED_BIT = 0x4;
+
+uint8_t checksum(const uint8_t* data) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < CHECKSUM_OFFSET; ++i) {
+        sum ^= data[i];
+    }
+    return sum;
+}
+
+std::string squareName(int square) {
+    return {static_cast<char>('a' + fileOf(square)), static_cast<char>('1' + rankOf(square))};
+}
+
+} // namespace
+
+
+SnapshotBytes encodeSnapshot(const GameSnapshot& snapshot) {
+    SnapshotBytes bytes{};
+    bytes[0] = SNAPSHOT_VERSION;
+    for (int i = 0; i < NUMBER_OF_PIECES; ++i) {
+        bytes[PIECES_OFFSET + i] = snapshot.pieceSquares[i];
+    }
+
+    uint8_t* flags = &bytes[FLAGS_OFFSET];
+    flags[0] = static_cast<uint8_t>((snapshot.castlingRights & 0xF) | (snapshot.sideToMove ? SIDE_TO_MOVE_BIT : 0));
+    flags[1] = (snapshot.enPassantSquare == NO_SQUARE) ? NO_EN_PASSANT : static_cast<uint8_t>(snapshot.enPassantSquare);
+    flags[2] = snapshot.gameState;
+    flags[3] = snapshot.gameEndType;
+    flags[4] = static_cast<uint8_t>(snapshot.halfmoveClock);
+    flags[5] = static_cast<uint8_t>(snapshot.halfmoveClock >> 8);
+    flags[6] = static_cast<uint8_t>(snapshot.fullmoveNumber);
+    flags[7] = static_cast<uint8_t>(snapshot.fullmoveNumber >> 8);
+
+    uint8_t* player = &bytes[PLAYERS_OFFSET];
+    for (const PlayerSnapshot& saved : snapshot.players) {
+        player[0] = saved.horcruxID;
+        player[1] = saved.horcruxGuessesLeft;
+        player[2] = static_cast<uint8_t>((saved.horcruxFound ? HORCRUX_FOUND_BIT : 0) |
+                                         (saved.horcruxCaptured ? HORCRUX_CAPTURED_BIT : 0) |
+                                         (saved.kingCaptured ? KING_CAPTURED_BIT : 0));
+        player += 3;
+    }
+
+    bytes[CHECKSUM_OFFSET] = checksum(bytes.data());
+    return bytes;
+}
+
+
+GameSnapshot decodeSnapshot(const uint8_t* data, size_t size) {
+    if (size != SNAPSHOT_BYTES) {
+        throw std::runtime_error("Snapshot has the wrong size");
+    }
+    if (data[0] != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(data[0]));
+    }
+    if (data[CHECKSUM_OFFSET] != checksum(data)) {
+        throw std::runtime_error("Snapshot checksum mismatch");
+    }
+
+    // A one-byte XOR misses two bytes changed together, so every field that indexes something is checked too
+    GameSnapshot snapshot{};
+    Bitboard occupied = EMPTY_BITBOARD;
+    for (int i = 0; i < NUMBER_OF_PIECES; ++i) {
+        const uint8_t square = data[PIECES_OFFSET + i];
+        if (square != CAPTURED_SQUARE) {
+            if (square >= NUMBER_OF_SQUARES) {
+                throw std::runtime_error("Snapshot puts a piece off the board");
+            }
+            if (occupied & squareBit(square)) {
+                throw std::runtime_error("Snapshot puts two pieces on one square");
+            }
+            occupied |= squareBit(square);
+        }
+        snapshot.pieceSquares[i] = square;
+    }
+
+    const uint8_t* flags = &data[FLAGS_OFFSET];
+    // A double push only ever leaves its square behind on the third or sixth rank
+    if (flags[1] != NO_EN_PASSANT && (flags[1] >= NUMBER_OF_SQUARES || (rankOf(flags[1]) != 2 && rankOf(flags[1]) != 5))) {
+        throw std::runtime_error("Snapshot has an impossible en passant square");
+    }
+    if (flags[2] > static_cast<uint8_t>(GameState::ENDED) || flags[3] > static_cast<uint8_t>(GameEndType::STALEMATE)) {
+        throw std::runtime_error("Snapshot has an unknown game state or result");
+    }
+    snapshot.castlingRights = flags[0] & 0xF;
+    snapshot.sideToMove = (flags[0] & SIDE_TO_MOVE_BIT) ? 1 : 0;
+    snapshot.enPassantSquare = (flags[1] == NO_EN_PASSANT) ? NO_SQUARE : static_cast<int8_t>(flags[1]);
+    snapshot.gameState = flags[2];
+    snapshot.gameEndType = flags[3];
+    snapshot.halfmoveClock = static_cast<uint16_t>(flags[4] | (flags[5] << 8));
+    snapshot.fullmoveNumber = static_cast<uint16_t>(flags[6] | (flags[7] << 8));
+
+    const uint8_t* player = &data[PLAYERS_OFFSET];
+    for (PlayerSnapshot& saved : snapshot.players) {
+        if (player[0] > NUMBER_OF_PIECES) {
+            throw std::runtime_error("Snapshot has an unknown horcrux ID");
+        }
+        saved.horcruxID = player[0];
+        saved.horcruxGuessesLeft = player[1];
+        saved.horcruxFound = player[2] & HORCRUX_FOUND_BIT;
+        saved.horcruxCaptured = player[2] & HORCRUX_CAPTURED_BIT;
+        saved.kingCaptured = player[2] & KING_CAPTURED_BIT;
+        player += 3;
+    }
+    return snapshot;
+}
+
+
+std::string toSnapshotText(const Game& game) {
+    const GameSnapshot snapshot = game.takeSnapshot();
+    std::string text = toFen(*game.getBoard(), static_cast<Color>(snapshot.sideToMove),
+                             snapshot.halfmoveClock, snapshot.fullmoveNumber);
+
+    for (const PlayerSnapshot& saved : snapshot.players) {
+        text += ' ';
+        if (saved.horcruxID == INVALID_HORCRUXE_ID) {
+            text += '-';
+        } else if (snapshot.pieceSquares[saved.horcruxID - 1] == CAPTURED_SQUARE) {
+            text += 'x';
+        } else {
+            text += squareName(snapshot.pieceSquares[saved.horcruxID - 1]);
+        }
+        if (saved.horcruxFound) {text += '!';}
+        text += ':' + std::to_string(saved.horcruxGuessesLeft);
+    }
+    return text;
+}
@@ -1,4 +1,5 @@
 #include "square.h"
+#include "board.h"
 
 bool Square::isOccupied() const {
     return pPiece_ != nullptr;
@@ -9,7 +10,11 @@ void Square::placePiece(const IPiece* pPiece) {
     if (isOccupied()) {
         throw std::logic_error("Square already occupied");
     }
-    pPiece_ = pPiece;
+    if (pBoard_) {
+        pBoard_->setPiece_(toSquare(position_), pPiece);
+    } else {
+        pPiece_ = pPiece;
+    }
 }
 
 
@@ -20,7 +25,11 @@ const Position& Square::getPosition() const {return position_;}
 
 
 void Square::removePiece() {
-    pPiece_ = nullptr;
+    if (pBoard_) {
+        pBoard_->clearPiece_(toSquare(position_));
+    } else {
+        pPiece_ = nullptr;
+    }
 }
 
 
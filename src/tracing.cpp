@@ -0,0 +1,168 @@
+#include "tracing.h"
+#include <cstdio>
+
+namespace {
+
+struct ThreadTrace {
+    ActiveTrace trace;
+    bool isOpen = false;
+    uint32_t threadID;
+};
+
+std::atomic<uint32_t> nextThreadID{1};
+thread_local ThreadTrace threadTrace{ActiveTrace(), false, nextThreadID.fetch_add(1, std::memory_order_relaxed)};
+
+uint64_t nanosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+uint64_t sinceClockEpochMicros(std::chrono::steady_clock::time_point time) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count());
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void writeChromeEvent(std::ostream& out, const std::string& name, double startMicros, double durationMicros,
+                      uint32_t threadID, uint64_t traceID) {
+    out << "{\"name\":";
+    writeJsonString(out, name);
+    // Fixed notation keeps microsecond timestamps since boot exact
+    char times[64];
+    std::snprintf(times, sizeof(times), ",\"ts\":%.3f,\"dur\":%.3f", startMicros, durationMicros);
+    out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadID << times << ",\"args\":{\"traceID\":" << traceID << "}}";
+}
+
+} // namespace
+
+
+void ActiveTrace::begin(uint64_t traceID, const std::string& route) {
+    traceID_ = traceID;
+    route_ = route;
+    start_ = Clock::now();
+    spans_.clear();
+    depth_ = 0;
+    droppedSpans_ = 0;
+}
+
+
+int ActiveTrace::open(const char* name) {
+    if (spans_.size() >= TRACE_MAX_SPANS) {
+        droppedSpans_++;
+        return -1;
+    }
+    spans_.push_back(SpanRecord{name, nanosBetween(start_, Clock::now()), 0, depth_++});
+    return static_cast<int>(spans_.size() - 1);
+}
+
+
+void ActiveTrace::close(int index) {
+    if (index < 0) {return;}
+    SpanRecord& span = spans_[static_cast<size_t>(index)];
+    span.durationNanos = nanosBetween(start_, Clock::now()) - span.startNanos;
+    depth_--;
+}
+
+
+CompletedTrace ActiveTrace::finish(uint32_t threadID) const {
+    return CompletedTrace{traceID_, route_, sinceClockEpochMicros(start_), nanosBetween(start_, Clock::now()),
+                          threadID, droppedSpans_, spans_};
+}
+
+
+uint64_t Tracer::begin(const std::string& route) {
+    const uint64_t traceID = nextTraceID_.fetch_add(1, std::memory_order_relaxed);
+    threadTrace.trace.begin(traceID, route);
+    threadTrace.isOpen = true;
+    return traceID;
+}
+
+
+void Tracer::end(uint64_t traceID, const std::string& route, std::chrono::steady_clock::time_point start) {
+    const uint64_t durationNanos = nanosBetween(start, std::chrono::steady_clock::now());
+    const bool isOpenHere = threadTrace.isOpen && threadTrace.trace.getTraceID() == traceID;
+    if (isOpenHere) {threadTrace.isOpen = false;}
+    if (static_cast<int64_t>(durationNanos) < slowNanos_.load(std::memory_order_relaxed)) {return;}
+
+    if (isOpenHere) {
+        _keep(threadTrace.trace.finish(threadTrace.threadID));
+    } else {
+        _keep(CompletedTrace{traceID, route, sinceClockEpochMicros(start), durationNanos, threadTrace.threadID, 0, {}});
+    }
+}
+
+
+void Tracer::setSlowThreshold(std::chrono::nanoseconds threshold) {
+    slowNanos_.store(threshold.count(), std::memory_order_relaxed);
+}
+
+
+std::vector<CompletedTrace> Tracer::getSlowTraces() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<CompletedTrace>(slowTraces_.begin(), slowTraces_.end());
+}
+
+
+ActiveTrace* Tracer::active() {
+    return threadTrace.isOpen ? &threadTrace.trace : nullptr;
+}
+
+
+Tracer& Tracer::global() {
+    static Tracer tracer;
+    return tracer;
+}
+
+
+void Tracer::_keep(CompletedTrace trace) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slowTraces_.size() >= TRACE_RING_CAPACITY) {
+        slowTraces_.pop_front();
+    }
+    slowTraces_.push_back(std::move(trace));
+}
+
+
+void writeTraceText(std::ostream& out, const std::vector<CompletedTrace>& traces) {
+    for (const CompletedTrace& trace : traces) {
+        out << "trace " << trace.traceID << " " << trace.route << " " << trace.durationNanos / 1e6 << " ms"
+            << " thread=" << trace.threadID;
+        if (trace.droppedSpans > 0) {out << " dropped=" << trace.droppedSpans;}
+        out << "\n";
+        for (const SpanRecord& span : trace.spans) {
+            out << std::string(2 + 2 * span.depth, ' ') << span.name << " +" << span.startNanos / 1e6 << " ms "
+                << span.durationNanos / 1e6 << " ms\n";
+        }
+    }
+}
+
+
+void writeChromeTrace(std::ostream& out, const std::vector<CompletedTrace>& traces) {
+    out << "{\"traceEvents\":[";
+    bool isFirst = true;
+    for (const CompletedTrace& trace : traces) {
+        out << (isFirst ? "" : ",");
+        isFirst = false;
+        writeChromeEvent(out, trace.route, static_cast<double>(trace.startMicros), trace.durationNanos / 1e3,
+                         trace.threadID, trace.traceID);
+        for (const SpanRecord& span : trace.spans) {
+            out << ",";
+            writeChromeEvent(out, span.name, trace.startMicros + span.startNanos / 1e3, span.durationNanos / 1e3,
+                             trace.threadID, trace.traceID);
+        }
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}";
+}
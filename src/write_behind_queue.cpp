@@ -0,0 +1,340 @@
+#include "write_behind_queue.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// The WAL keeps the batch being written here until the sink has committed it
+std::string flushingPath(const std::string& walPath) {return walPath + ".flushing";}
+// Batches the sink kept refusing, in WAL format, for someone to look at and replay by hand
+std::string deadLetterPath(const std::string& walPath) {return walPath + ".dead";}
+
+std::string encodeEvent(const PersistEvent& event) {
+    std::ostringstream line;
+    line << static_cast<int>(event.type) << '\t' << event.gameID << '\t' << event.playerID << '\t' << event.value << '\n';
+    return line.str();
+}
+
+void readWal(const std::string& path, std::deque<PersistEvent>& events) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        // A line without its newline was cut short by a crash mid-append, possibly mid-value
+        if (in.eof()) {break;}
+        std::istringstream fields(line);
+        std::string type, gameID, playerID, value;
+        if (!std::getline(fields, type, '\t') || !std::getline(fields, gameID, '\t') ||
+            !std::getline(fields, playerID, '\t') || !std::getline(fields, value)) {
+            continue;
+        }
+        events.push_back(PersistEvent{static_cast<PersistEventType>(std::stoi(type)), gameID, playerID, std::stoi(value)});
+    }
+}
+
+void writeFully(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+        if (written < 0) {throw std::runtime_error("Could not write the persistence WAL");}
+        offset += static_cast<size_t>(written);
+    }
+}
+
+} // namespace
+
+
+WriteBehindQueue::WriteBehindQueue(PersistenceSink& sink, const WriteBehindConfig& config)
+    : sink_(sink), config_(config)
+{
+    if (config_.capacity == 0 || config_.flushSize == 0) {
+        throw std::logic_error("Write-behind queue needs a non-zero capacity and flush size");
+    }
+    if (!config_.walPath.empty()) {
+        _recoverWal();
+    }
+    writer_ = std::thread(&WriteBehindQueue::_run, this);
+}
+
+
+WriteBehindQueue::~WriteBehindQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    hasWork_.notify_all();
+    hasRoom_.notify_all();
+    writer_.join();
+    if (walFd_ >= 0) {::close(walFd_);}
+}
+
+
+void WriteBehindQueue::enqueue(PersistEvent event) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_.size() >= config_.capacity && !isStopping_) {
+        hasRoom_.wait_for(lock, config_.flushInterval);
+    }
+    if (isStopping_) {
+        throw std::logic_error("Write-behind queue is shutting down");
+    }
+
+    // The record goes into the WAL in queue order, so a rotation always splits the two at the same event
+    uint64_t walSequence = 0;
+    if (walFd_ >= 0) {
+        _appendWal(event);
+        walSequence = ++walWritten_;
+    }
+    if (pending_.empty()) {
+        oldestPending_ = std::chrono::steady_clock::now();
+    }
+    pending_.push_back(std::move(event));
+    stats_.enqueued++;
+    hasWork_.notify_one();
+
+    if (walSequence) {
+        lock.unlock();
+        _syncWal(walSequence);
+    }
+}
+
+
+void WriteBehindQueue::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    isFlushRequested_ = true;
+    hasWork_.notify_one();
+    while (!pending_.empty() || isWriting_) {
+        isDrained_.wait_for(lock, config_.flushInterval);
+    }
+}
+
+
+WriteBehindStats WriteBehindQueue::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteBehindStats stats = stats_;
+    stats.depth = pending_.size();
+    return stats;
+}
+
+
+std::vector<PersistEvent> WriteBehindQueue::coalesce(const std::vector<PersistEvent>& events) {
+    std::unordered_set<std::string> updatedGames;
+    std::unordered_set<std::string> updatedPlayers;
+    std::vector<PersistEvent> kept;
+    kept.reserve(events.size());
+
+    // Walking backwards, the first update seen for a key is the one that wins
+    for (auto it = events.rbegin(); it != events.rend(); ++it) {
+        if (it->type == PersistEventType::GAME_STATE && !updatedGames.insert(it->gameID).second) {continue;}
+        if (it->type == PersistEventType::PLAYER_HORCRUX && !updatedPlayers.insert(it->playerID).second) {continue;}
+        kept.push_back(*it);
+    }
+    std::reverse(kept.begin(), kept.end());
+    return kept;
+}
+
+
+void WriteBehindQueue::_run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        while (!isStopping_ && !isFlushRequested_ && pending_.size() < config_.flushSize) {
+            if (pending_.empty()) {
+                // An idle writer still wakes once per interval; nothing is pending, so it just waits again
+                hasWork_.wait_for(lock, config_.flushInterval);
+            } else if (hasWork_.wait_until(lock, oldestPending_ + config_.flushInterval) == std::cv_status::timeout) {
+                break;
+            }
+        }
+
+        if (pending_.empty()) {
+            isFlushRequested_ = false;
+            isDrained_.notify_all();
+            if (isStopping_) {break;}
+            continue;
+        }
+
+        std::vector<PersistEvent> batch(std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.end()));
+        pending_.clear();
+        isWriting_ = true;
+        if (walFd_ >= 0) {
+            _rotateWal();
+        }
+        hasRoom_.notify_all();
+
+        lock.unlock();
+        const bool isSettled = _writeBatch(batch);
+        lock.lock();
+
+        isWriting_ = false;
+        if (!isSettled && walFd_ >= 0) {
+            // Rotating again would overwrite the unwritten batch's file; both files are replayed on restart
+            CHESS_LOG_ERROR("Leaving unwritten events in the WAL on shutdown", {{"events", batch.size() + pending_.size()}});
+            isDrained_.notify_all();
+            break;
+        }
+        if (!isSettled) {
+            CHESS_LOG_ERROR("Dropping unwritten events on shutdown", {{"events", batch.size()}});
+        }
+        if (pending_.empty()) {
+            isDrained_.notify_all();
+        }
+    }
+}
+
+
+bool WriteBehindQueue::_writeBatch(const std::vector<PersistEvent>& batch) {
+    const std::vector<PersistEvent> events = coalesce(batch);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.coalesced += batch.size() - events.size();
+    }
+
+    // Deadlocks and server restarts pass within a few tries. While the batch is out producers fill the
+    // queue up to its capacity, so one the sink keeps refusing is set aside rather than retried forever.
+    std::chrono::milliseconds backoff = config_.retryBackoff;
+    bool isWritten = false;
+    for (size_t attempt = 1; !isWritten; ++attempt) {
+        try {
+            sink_.writeBatch(events);
+            isWritten = true;
+        } catch (const std::exception& e) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.failures++;
+                if (isStopping_) {return false;}
+            }
+            if (attempt >= config_.maxAttempts) {
+                CHESS_LOG_ERROR("Persistence batch failed, dead-lettering it",
+                                {{"events", events.size()}, {"attempts", attempt}, {"error", e.what()}});
+                _deadLetter(events);
+                break;
+            }
+            CHESS_LOG_WARNING("Persistence batch failed, retrying",
+                              {{"events", events.size()}, {"attempt", attempt}, {"error", e.what()}});
+            std::unique_lock<std::mutex> lock(mutex_);
+            hasWork_.wait_for(lock, backoff, [this]() {return isStopping_;});
+            backoff *= 2;
+        }
+    }
+
+    if (walFd_ >= 0) {
+        std::remove(flushingPath(config_.walPath).c_str());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (isWritten) {
+        stats_.written += events.size();
+        stats_.batches++;
+    } else {
+        stats_.deadLettered += events.size();
+    }
+    return true;
+}
+
+
+void WriteBehindQueue::_deadLetter(const std::vector<PersistEvent>& events) {
+    std::string lines;
+    for (const PersistEvent& event : events) {
+        lines += encodeEvent(event);
+    }
+
+    if (walFd_ >= 0) {
+        const std::string path = deadLetterPath(config_.walPath);
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd >= 0) {
+            bool isSaved = true;
+            try {
+                writeFully(fd, lines);
+            } catch (const std::exception&) {
+                isSaved = false;
+            }
+            isSaved = ::fsync(fd) == 0 && isSaved;
+            ::close(fd);
+            if (isSaved) {return;}
+        }
+        CHESS_LOG_ERROR("Could not write the dead-letter file, logging the events instead", {{"path", path}});
+    }
+    // Without a file to keep them in, the log is the only record of what never reached the sink
+    CHESS_LOG_ERROR("Dead-lettered persistence events", {{"events", lines}});
+}
+
+
+void WriteBehindQueue::_openWal(bool truncate) {
+    const int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+    walFd_ = ::open(config_.walPath.c_str(), flags, 0644);
+    if (walFd_ < 0) {
+        throw std::runtime_error("Could not open the persistence WAL at " + config_.walPath);
+    }
+}
+
+
+void WriteBehindQueue::_appendWal(const PersistEvent& event) {
+    writeFully(walFd_, encodeEvent(event));
+}
+
+
+void WriteBehindQueue::_syncWal(uint64_t walSequence) {
+    // Group commit: one thread fsyncs for everyone whose record is written by then, while the rest
+    // wait here for it instead of each paying for their own, and the queue lock stays free throughout
+    std::lock_guard<std::mutex> syncLock(walSyncMutex_);
+    uint64_t target;
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (walSynced_ >= walSequence) {return;}
+        target = walWritten_;
+        // Records in earlier files were synced by the rotation; the copy stays open if the writer rotates now
+        fd = ::dup(walFd_);
+    }
+    const bool isSynced = fd >= 0 && ::fsync(fd) == 0;
+    if (fd >= 0) {::close(fd);}
+    if (!isSynced) {
+        throw std::runtime_error("Could not fsync the persistence WAL");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    walSynced_ = std::max(walSynced_, target);
+}
+
+
+void WriteBehindQueue::_rotateWal() {
+    // Producers only ever sync the current file, so whatever is written to this one is synced before it goes
+    if (::fsync(walFd_) != 0) {
+        throw std::runtime_error("Could not fsync the persistence WAL");
+    }
+    walSynced_ = walWritten_;
+    ::close(walFd_);
+    std::rename(config_.walPath.c_str(), flushingPath(config_.walPath).c_str());
+    _openWal(true);
+}
+
+
+void WriteBehindQueue::_recoverWal() {
+    // A batch that never committed comes before everything enqueued after it
+    readWal(flushingPath(config_.walPath), pending_);
+    readWal(config_.walPath, pending_);
+    stats_.enqueued = pending_.size();
+    oldestPending_ = std::chrono::steady_clock::now();
+
+    // Fold both files into one log before the writer can rotate it
+    const std::string tmpPath = config_.walPath + ".tmp";
+    const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open the persistence WAL at " + tmpPath);
+    }
+    std::string recovered;
+    for (const PersistEvent& event : pending_) {
+        recovered += encodeEvent(event);
+    }
+    writeFully(fd, recovered);
+    ::fsync(fd);
+    ::close(fd);
+    std::rename(tmpPath.c_str(), config_.walPath.c_str());
+    std::remove(flushingPath(config_.walPath).c_str());
+
+    _openWal(false);
+}
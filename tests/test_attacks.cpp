@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+#include "attacks.h"
+
+namespace {
+
+// Reference ray walk used to check the lookup tables
+Bitboard slowSlidingAttacks(int square, Bitboard occupied, const std::array<Offset, 4>& directions) {
+    Bitboard attacks = EMPTY_BITBOARD;
+    for (const Offset& direction : directions) {
+        int file = fileOf(square) + direction.file;
+        int rank = rankOf(square) + direction.rank;
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            attacks |= squareBit(squareIndex(file, rank));
+            if (occupied & squareBit(squareIndex(file, rank))) {break;}
+            file += direction.file;
+            rank += direction.rank;
+        }
+    }
+    return attacks;
+}
+
+const std::array<Offset, 4> ROOK_RAYS = {{{0, 1}, {0, -1}, {1, 0}, {-1, 0}}};
+const std::array<Offset, 4> BISHOP_RAYS = {{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+
+}
+
+TEST(Attacks, KnightTable) {
+    EXPECT_EQ(popCount(knightAttacks(toSquare(Position('a', 1)))), 2);
+    EXPECT_EQ(popCount(knightAttacks(toSquare(Position('d', 4)))), 8);
+    EXPECT_TRUE(knightAttacks(toSquare(Position('g', 1))) & squareBit(toSquare(Position('f', 3))));
+}
+
+TEST(Attacks, KingTable) {
+    EXPECT_EQ(popCount(kingAttacks(toSquare(Position('h', 8)))), 3);
+    EXPECT_EQ(popCount(kingAttacks(toSquare(Position('e', 2)))), 8);
+}
+
+TEST(Attacks, PawnTable) {
+    int e4 = toSquare(Position('e', 4));
+    EXPECT_EQ(pawnAttacks(Color::WHITE, e4), squareBit(toSquare(Position('d', 5))) | squareBit(toSquare(Position('f', 5))));
+    EXPECT_EQ(pawnAttacks(Color::BLACK, e4), squareBit(toSquare(Position('d', 3))) | squareBit(toSquare(Position('f', 3))));
+    EXPECT_EQ(pawnAttacks(Color::WHITE, toSquare(Position('a', 2))), squareBit(toSquare(Position('b', 3))));
+}
+
+TEST(Attacks, SlidersMatchRayWalk) {
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int i = 0; i < 2000; ++i) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        Bitboard occupied = seed & (seed >> 3);
+        int square = i % NUMBER_OF_SQUARES;
+        EXPECT_EQ(rookAttacks(square, occupied), slowSlidingAttacks(square, occupied, ROOK_RAYS));
+        EXPECT_EQ(bishopAttacks(square, occupied), slowSlidingAttacks(square, occupied, BISHOP_RAYS));
+    }
+}
+
+TEST(Attacks, BetweenAndLine) {
+    int a1 = toSquare(Position('a', 1));
+    int d4 = toSquare(Position('d', 4));
+    int b3 = toSquare(Position('b', 3));
+
+    EXPECT_EQ(betweenMask(a1, d4), squareBit(toSquare(Position('b', 2))) | squareBit(toSquare(Position('c', 3))));
+    EXPECT_EQ(betweenMask(a1, b3), EMPTY_BITBOARD);
+    EXPECT_EQ(popCount(lineMask(a1, d4)), 8);
+    EXPECT_EQ(lineMask(a1, b3), EMPTY_BITBOARD);
+}
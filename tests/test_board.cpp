@@ -1,6 +1,10 @@
 #include "gtest/gtest.h"
 #include "board.h"
 #include "mock_piece.h"
+#include "king.h"
+#include "queen.h"
+#include "rook.h"
+#include "pawn.h"
 
 // Test constructing an empty board
 TEST(Board, ConstructEmptyBoard) {
@@ -36,3 +40,170 @@ TEST(Board, GetEmptySquare) {
     EXPECT_EQ(board.getSquare(pos)->getPiece(), nullptr);
 }
 
+
+// Test that placing and removing pieces keeps the bitboards in sync
+TEST(Board, BitboardsTrackPieces) {
+    Board board;
+    Queen queen(1, Color::WHITE);
+    Position pos{'d', 1};
+
+    board.placePiece(pos, &queen);
+    EXPECT_EQ(board.getPiece(toSquare(pos)), &queen);
+    EXPECT_EQ(board.getOccupancy(Color::WHITE), squareBit(toSquare(pos)));
+    EXPECT_EQ(board.getPieces(Color::WHITE, PieceType::QUEEN), squareBit(toSquare(pos)));
+    EXPECT_EQ(board.getOccupancy(Color::BLACK), EMPTY_BITBOARD);
+
+    board.removePiece(board.getSquare(pos));
+    EXPECT_EQ(board.getPiece(toSquare(pos)), nullptr);
+    EXPECT_EQ(board.getOccupancy(), EMPTY_BITBOARD);
+}
+
+// Test that writes through the square view reach the bitboards
+TEST(Board, SquareViewWritesThrough) {
+    Board board;
+    King king(1, Color::BLACK);
+    Position pos{'e', 8};
+
+    board.getSquare(pos)->placePiece(&king);
+    EXPECT_EQ(board.getKingSquare(Color::BLACK), toSquare(pos));
+    EXPECT_EQ(*board.findKing(Color::BLACK), pos);
+
+    board.getSquare(pos)->removePiece();
+    EXPECT_EQ(board.findKing(Color::BLACK), nullptr);
+}
+
+// Test that copies do not share pieces or squares with the original
+TEST(Board, CopyIsIndependent) {
+    Board board;
+    Queen queen(1, Color::WHITE);
+    board.placePiece(Position('d', 1), &queen);
+
+    Board copy = board;
+    copy.removePiece(copy.getSquare(Position('d', 1)));
+
+    EXPECT_EQ(board.getSquare(Position('d', 1))->getPiece(), &queen);
+    EXPECT_EQ(copy.getOccupancy(), EMPTY_BITBOARD);
+}
+
+
+// Test that unmakeMove restores a capture exactly
+TEST(Board, MakeUnmakeCapture) {
+    Board board;
+    Queen queen(1, Color::WHITE);
+    Rook rook(17, Color::BLACK);
+    board.placePiece(Position('d', 1), &queen);
+    board.placePiece(Position('d', 8), &rook);
+
+    const CompactMove capture(toSquare(Position('d', 1)), toSquare(Position('d', 8)), MoveFlag::CAPTURE);
+    const UndoRecord undo = board.makeMove(capture);
+    EXPECT_EQ(board.getPiece(toSquare(Position('d', 8))), &queen);
+    EXPECT_EQ(board.getOccupancy(Color::BLACK), EMPTY_BITBOARD);
+    EXPECT_EQ(board.getSquare(Position('d', 1))->getPiece(), nullptr);
+
+    board.unmakeMove(capture, undo);
+    EXPECT_EQ(board.getPiece(toSquare(Position('d', 1))), &queen);
+    EXPECT_EQ(board.getPiece(toSquare(Position('d', 8))), &rook);
+    EXPECT_EQ(board.getPieces(Color::BLACK, PieceType::ROOK), squareBit(toSquare(Position('d', 8))));
+    EXPECT_EQ(board.getSquare(Position('d', 8))->getPiece(), &rook);
+}
+
+// Test that findSquare follows a piece through captures and moves
+TEST(Board, FindSquareTracksPieces) {
+    Board board;
+    Queen queen(1, Color::WHITE);
+    Rook rook(17, Color::BLACK);
+    board.placePiece(Position('d', 1), &queen);
+    board.placePiece(Position('d', 8), &rook);
+    EXPECT_EQ(board.findSquare(17)->getPosition(), Position('d', 8));
+
+    const CompactMove capture(toSquare(Position('d', 1)), toSquare(Position('d', 8)), MoveFlag::CAPTURE);
+    const UndoRecord undo = board.makeMove(capture);
+    EXPECT_EQ(board.findSquare(1)->getPosition(), Position('d', 8));
+    EXPECT_THROW(board.findSquare(17), std::logic_error);
+
+    board.unmakeMove(capture, undo);
+    EXPECT_EQ(board.findSquare(1)->getPosition(), Position('d', 1));
+    EXPECT_EQ(board.findSquare(17)->getPosition(), Position('d', 8));
+}
+
+// Test that castling moves the rook and drops the castling rights until unmade
+TEST(Board, MakeUnmakeCastling) {
+    Board board;
+    King king(16, Color::WHITE);
+    Rook rook(9, Color::WHITE);
+    board.placePiece(Position('e', 1), &king);
+    board.placePiece(Position('h', 1), &rook);
+
+    const CompactMove castle(toSquare(Position('e', 1)), toSquare(Position('g', 1)), MoveFlag::KING_CASTLE);
+    const UndoRecord undo = board.makeMove(castle);
+    EXPECT_EQ(board.getPiece(toSquare(Position('f', 1))), &rook);
+    EXPECT_EQ(board.getKingSquare(Color::WHITE), toSquare(Position('g', 1)));
+    EXPECT_EQ(board.getCastlingRights(), BLACK_KING_SIDE_CASTLE | BLACK_QUEEN_SIDE_CASTLE);
+
+    board.unmakeMove(castle, undo);
+    EXPECT_EQ(board.getPiece(toSquare(Position('h', 1))), &rook);
+    EXPECT_EQ(board.getKingSquare(Color::WHITE), toSquare(Position('e', 1)));
+    EXPECT_EQ(board.getCastlingRights(), ALL_CASTLING_RIGHTS);
+}
+
+// Test that en passant removes the pawn behind the target square
+TEST(Board, MakeUnmakeEnPassant) {
+    Board board;
+    Pawn whitePawn(5, Color::WHITE);
+    Pawn blackPawn(20, Color::BLACK);
+    board.placePiece(Position('e', 5), &whitePawn);
+    board.placePiece(Position('d', 7), &blackPawn);
+
+    const CompactMove push(toSquare(Position('d', 7)), toSquare(Position('d', 5)), MoveFlag::DOUBLE_PAWN_PUSH);
+    const UndoRecord pushUndo = board.makeMove(push);
+    EXPECT_EQ(board.getEnPassantSquare(), toSquare(Position('d', 6)));
+
+    const CompactMove enPassant(toSquare(Position('e', 5)), toSquare(Position('d', 6)), MoveFlag::EN_PASSANT);
+    const UndoRecord undo = board.makeMove(enPassant);
+    EXPECT_EQ(board.getOccupancy(Color::BLACK), EMPTY_BITBOARD);
+    EXPECT_EQ(board.getEnPassantSquare(), NO_SQUARE);
+
+    board.unmakeMove(enPassant, undo);
+    EXPECT_EQ(board.getPiece(toSquare(Position('d', 5))), &blackPawn);
+    EXPECT_EQ(board.getEnPassantSquare(), toSquare(Position('d', 6)));
+
+    board.unmakeMove(push, pushUndo);
+    EXPECT_EQ(board.getPiece(toSquare(Position('d', 7))), &blackPawn);
+    EXPECT_EQ(board.getEnPassantSquare(), NO_SQUARE);
+}
+
+// Test that a promoted pawn is seen as its new type until unmade
+TEST(Board, MakeUnmakePromotion) {
+    Board board;
+    Pawn pawn(1, Color::WHITE);
+    board.placePiece(Position('a', 7), &pawn);
+
+    const CompactMove promotion(toSquare(Position('a', 7)), toSquare(Position('a', 8)), MoveFlag::QUEEN_PROMOTION);
+    const UndoRecord undo = board.makeMove(promotion);
+    EXPECT_EQ(board.getPieceType(toSquare(Position('a', 8))), PieceType::QUEEN);
+    EXPECT_EQ(board.getPieces(PieceType::PAWN), EMPTY_BITBOARD);
+
+    board.unmakeMove(promotion, undo);
+    EXPECT_EQ(board.getPieceType(toSquare(Position('a', 7))), PieceType::PAWN);
+    EXPECT_EQ(board.getPieces(PieceType::QUEEN), EMPTY_BITBOARD);
+}
+
+// Test that attacks are found along every piece's lines and blocked sliders are not
+TEST(Board, IsSquareAttacked) {
+    Board board;
+    Rook rook(17, Color::BLACK);
+    Pawn pawn(18, Color::BLACK);
+    Queen blocker(1, Color::WHITE);
+    board.placePiece(Position('a', 8), &rook);
+    board.placePiece(Position('e', 5), &pawn);
+
+    EXPECT_TRUE(board.isSquareAttacked(toSquare(Position('a', 1)), Color::BLACK));
+    EXPECT_TRUE(board.isSquareAttacked(toSquare(Position('d', 4)), Color::BLACK));
+    EXPECT_FALSE(board.isSquareAttacked(toSquare(Position('e', 4)), Color::BLACK));
+    EXPECT_FALSE(board.isSquareAttacked(toSquare(Position('a', 1)), Color::WHITE));
+
+    board.placePiece(Position('a', 4), &blocker);
+    EXPECT_FALSE(board.isSquareAttacked(toSquare(Position('a', 1)), Color::BLACK));
+    EXPECT_TRUE(board.isSquareAttacked(toSquare(Position('a', 4)), Color::BLACK));
+    EXPECT_TRUE(board.isAttackedPosition(Position('a', 4), Color::WHITE));
+}
@@ -0,0 +1,43 @@
+#include "gtest/gtest.h"
+#include "board_diff_ring.h"
+
+// Test that the changes since a version are merged into one set of squares
+TEST(BoardDiffRing, CollectsSinceVersion) {
+    BoardDiffRing ring;
+    ring.reset(1);
+    ring.push(squareBit(12) | squareBit(28), GameEventType::MOVE);
+    ring.push(0, GameEventType::HORCRUX_GUESS);
+    ring.push(squareBit(51) | squareBit(35), GameEventType::MOVE);
+    EXPECT_EQ(ring.getVersion(), 4U);
+
+    Bitboard squares = 0;
+    std::vector<BoardDiff> diffs;
+    ASSERT_TRUE(ring.collect(2, squares, diffs));
+    EXPECT_EQ(squares, squareBit(51) | squareBit(35));
+    ASSERT_EQ(diffs.size(), 2U);
+    EXPECT_EQ(diffs[0].version, 3U);
+    EXPECT_EQ(diffs[0].type, GameEventType::HORCRUX_GUESS);
+
+    squares = 0;
+    diffs.clear();
+    ASSERT_TRUE(ring.collect(4, squares, diffs));
+    EXPECT_EQ(squares, 0U);
+    EXPECT_TRUE(diffs.empty());
+}
+
+// Test that versions from before a reset, beyond the ring, or from the future need the full board
+TEST(BoardDiffRing, TooFarBehindNeedsFullBoard) {
+    BoardDiffRing ring;
+    ring.reset(5);
+    Bitboard squares = 0;
+    std::vector<BoardDiff> diffs;
+    EXPECT_FALSE(ring.collect(4, squares, diffs));
+    EXPECT_FALSE(ring.collect(6, squares, diffs));
+
+    for (int i = 0; i < BOARD_DIFF_CAPACITY + 10; ++i) {
+        ring.push(squareBit(i % 64), GameEventType::MOVE);
+    }
+    EXPECT_FALSE(ring.collect(5 + 9, squares, diffs));
+    EXPECT_TRUE(ring.collect(5 + 10, squares, diffs));
+    EXPECT_EQ(diffs.size(), static_cast<size_t>(BOARD_DIFF_CAPACITY));
+}
@@ -6,6 +6,8 @@
 #include "queen.h"
 #include "rook.h"
 #include "pawn.h"
+#include "fen.h"
+#include "perft.h"
 
 // Test if a move is valid
 TEST(BoardRules, IsValidMove_Valid) {
@@ -93,7 +95,7 @@ TEST(BoardRules, IsValidEnPassant) {
     Pawn blackPawn(0, Color::BLACK);
 
     Move previousMove(&whitePawn, Position('d', 2), Position('d', 4));
-    Move move(&blackPawn, Position('c', 3), Position('d', 2));
+    Move move(&blackPawn, Position('c', 4), Position('d', 3));
 
     EXPECT_TRUE(rules.isValidEnPassant(previousMove, move));
 }
@@ -114,3 +116,134 @@ TEST(BoardRules, IsValidPromotion) {
 
     EXPECT_TRUE(rules.isValidPromotion(move));
 }
+
+// Test that pawns cannot capture straight ahead
+TEST(BoardRules, PawnBlockedByPieceInFront) {
+    Board board;
+    BoardRules rules;
+
+    Pawn whitePawn(1, Color::WHITE);
+    Pawn blackPawn(17, Color::BLACK);
+    board.placePiece(Position('e', 2), &whitePawn);
+    board.placePiece(Position('e', 3), &blackPawn);
+
+    auto positions = rules.generateValidPositions(board, Position('e', 2), Move());
+    EXPECT_TRUE(positions.empty());
+}
+
+// Test that sliders stop at the first blocker and may capture it
+TEST(BoardRules, RookStopsAtFirstBlocker) {
+    Board board;
+    BoardRules rules;
+
+    Rook rook(1, Color::WHITE);
+    Pawn blackPawn(17, Color::BLACK);
+    board.placePiece(Position('a', 1), &rook);
+    board.placePiece(Position('a', 4), &blackPawn);
+
+    auto positions = rules.generateValidPositions(board, Position('a', 1), Move());
+    EXPECT_EQ(positions.size(), 10); // a2-a4 and b1-h1
+    EXPECT_TRUE(positions.count(Position('a', 4)));
+    EXPECT_FALSE(positions.count(Position('a', 5)));
+}
+
+// Test that a pinned piece may only move along the pin
+TEST(BoardRules, PinnedPieceStaysOnPinRay) {
+    Board board;
+    BoardRules rules;
+
+    King king(16, Color::WHITE);
+    Rook rook(9, Color::WHITE);
+    Queen queen(31, Color::BLACK);
+    board.placePiece(Position('e', 1), &king);
+    board.placePiece(Position('e', 3), &rook);
+    board.placePiece(Position('e', 8), &queen);
+
+    auto positions = rules.generateValidPositions(board, Position('e', 3), Move());
+    EXPECT_EQ(positions.size(), 6); // e2 and e4-e8
+    EXPECT_TRUE(positions.count(Position('e', 8)));
+    EXPECT_FALSE(positions.count(Position('a', 3)));
+}
+
+// Test that only moves resolving a check are legal
+TEST(BoardRules, CheckMustBeResolved) {
+    Board board;
+    BoardRules rules;
+
+    King king(16, Color::WHITE);
+    Rook rook(9, Color::WHITE);
+    Queen queen(31, Color::BLACK);
+    board.placePiece(Position('e', 1), &king);
+    board.placePiece(Position('a', 3), &rook);
+    board.placePiece(Position('e', 8), &queen);
+
+    MoveList moves;
+    rules.generateLegalMoves(board, Color::WHITE, moves);
+    EXPECT_TRUE(moves.contains(toSquare(Position('a', 3)), toSquare(Position('e', 3))));
+    EXPECT_FALSE(moves.contains(toSquare(Position('a', 3)), toSquare(Position('a', 4))));
+    EXPECT_FALSE(moves.contains(toSquare(Position('e', 1)), toSquare(Position('e', 2))));
+    EXPECT_TRUE(moves.contains(toSquare(Position('e', 1)), toSquare(Position('d', 1))));
+}
+
+// Test that en passant is refused when it would expose the king along the rank
+TEST(BoardRules, EnPassantCannotExposeKing) {
+    Board board;
+    BoardRules rules;
+
+    King king(16, Color::WHITE);
+    Pawn whitePawn(5, Color::WHITE);
+    Pawn blackPawn(20, Color::BLACK);
+    Rook rook(25, Color::BLACK);
+    board.placePiece(Position('a', 5), &king);
+    board.placePiece(Position('e', 5), &whitePawn);
+    board.placePiece(Position('d', 7), &blackPawn);
+    board.placePiece(Position('h', 5), &rook);
+
+    board.makeMove(CompactMove(toSquare(Position('d', 7)), toSquare(Position('d', 5)), MoveFlag::DOUBLE_PAWN_PUSH));
+    EXPECT_FALSE(rules.isValidMove(board, Move(&whitePawn, Position('e', 5), Position('d', 6)), Move()));
+
+    board.removePiece(board.getSquare(Position('h', 5)));
+    EXPECT_TRUE(rules.isValidMove(board, Move(&whitePawn, Position('e', 5), Position('d', 6)), Move()));
+}
+
+// Test that a stalemated side has no legal move while its opponent does
+TEST(BoardRules, HasLegalMove_Stalemate) {
+    Board board;
+    BoardRules rules;
+    loadFen(board, "k7/2Q5/8/8/8/8/8/4K3 b - - 0 1");
+
+    EXPECT_FALSE(rules.isInCheck(board, Color::BLACK));
+    EXPECT_FALSE(rules.hasLegalMove(board, Color::BLACK));
+    EXPECT_TRUE(rules.hasLegalMove(board, Color::WHITE));
+}
+
+// Test that a checkmated side has no legal move
+TEST(BoardRules, HasLegalMove_Checkmate) {
+    Board board;
+    BoardRules rules;
+    loadFen(board, "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+
+    EXPECT_TRUE(rules.isInCheck(board, Color::WHITE));
+    EXPECT_FALSE(rules.hasLegalMove(board, Color::WHITE));
+}
+
+// Test that hasLegalMove agrees with the full generator, down to checkmates one ply deep
+TEST(BoardRules, HasLegalMove_MatchesGenerator) {
+    BoardRules rules;
+    for (const PerftPosition& position : referencePerftPositions()) {
+        Board board;
+        const Color side = loadFen(board, position.fen);
+        const Color opponent = (side == Color::WHITE) ? Color::BLACK : Color::WHITE;
+
+        MoveList moves;
+        rules.generateLegalMoves(board, side, moves);
+        EXPECT_EQ(rules.hasLegalMove(board, side), !moves.empty()) << position.name;
+        for (const CompactMove& move : moves) {
+            const UndoRecord undo = board.makeMove(move);
+            MoveList replies;
+            rules.generateLegalMoves(board, opponent, replies);
+            EXPECT_EQ(rules.hasLegalMove(board, opponent), !replies.empty()) << position.name << " " << move.toUci();
+            board.unmakeMove(move, undo);
+        }
+    }
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "connection_pool.h"
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct FakeConnection {
+    int serial;
+    bool healthy = true;
+};
+
+struct FakeServer {
+    std::atomic<int> connects{0};
+
+    ConnectionPool<FakeConnection>::Factory factory() {
+        return [this]() {return std::make_unique<FakeConnection>(FakeConnection{++connects});};
+    }
+};
+
+bool isHealthy(FakeConnection& connection) {return connection.healthy;}
+
+} // namespace
+
+// Test that a returned connection is reused instead of reopened
+TEST(ConnectionPool, ReusesConnections) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(2, server.factory(), isHealthy);
+
+    int firstSerial;
+    {
+        auto lease = pool.acquire();
+        firstSerial = lease->serial;
+        EXPECT_EQ(pool.getStats().inUse, 1U);
+    }
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease->serial, firstSerial);
+    EXPECT_EQ(server.connects, 1);
+    EXPECT_EQ(pool.getStats().acquisitions, 2U);
+}
+
+// Test that acquire gives up once every connection is leased and the timeout expires
+TEST(ConnectionPool, TimesOutWhenExhausted) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(1, server.factory(), isHealthy, std::chrono::milliseconds(10));
+
+    auto lease = pool.acquire();
+    EXPECT_THROW(pool.acquire(), std::runtime_error);
+    EXPECT_EQ(pool.getStats().timeouts, 1U);
+    EXPECT_EQ(pool.getStats().open, 1U);
+}
+
+// Test that an idle connection failing its health check is replaced
+TEST(ConnectionPool, ReconnectsUnhealthyConnection) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(1, server.factory(), isHealthy,
+                                        std::chrono::milliseconds(100), std::chrono::milliseconds(0));
+
+    pool.acquire()->healthy = false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    auto lease = pool.acquire();
+    EXPECT_TRUE(lease->healthy);
+    EXPECT_EQ(server.connects, 2);
+    EXPECT_EQ(pool.getStats().reconnects, 1U);
+}
+
+// Test that an invalidated lease frees its slot for a new connection
+TEST(ConnectionPool, InvalidateFreesSlot) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(1, server.factory(), isHealthy, std::chrono::milliseconds(10));
+
+    pool.acquire().invalidate();
+    EXPECT_EQ(pool.getStats().open, 0U);
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(lease->serial, 2);
+}
+
+// Test that a failed connect does not leak its slot
+TEST(ConnectionPool, FailedConnectReleasesSlot) {
+    bool isDown = true;
+    ConnectionPool<FakeConnection> pool(1, [&isDown]() {
+        if (isDown) {throw std::runtime_error("connection refused");}
+        return std::make_unique<FakeConnection>(FakeConnection{1});
+    }, isHealthy, std::chrono::milliseconds(10));
+
+    EXPECT_THROW(pool.acquire(), std::runtime_error);
+    isDown = false;
+    EXPECT_NO_THROW(pool.acquire());
+}
+
+// Test that concurrent users never hold more connections than the capacity
+TEST(ConnectionPool, BoundedUnderContention) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(2, server.factory(), isHealthy, std::chrono::milliseconds(5000));
+    std::atomic<int> holders{0};
+    std::atomic<int> maxHolders{0};
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 6; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < 20; ++i) {
+                auto lease = pool.acquire();
+                int current = ++holders;
+                int seen = maxHolders;
+                while (current > seen && !maxHolders.compare_exchange_weak(seen, current)) {}
+                std::this_thread::yield();
+                --holders;
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_LE(maxHolders, 2);
+    EXPECT_LE(server.connects, 2);
+    EXPECT_EQ(pool.getStats().acquisitions, 120U);
+    EXPECT_EQ(pool.getStats().inUse, 0U);
+}
+
+// Test the Prometheus rendering of the pool stats
+TEST(ConnectionPool, WritesMetrics) {
+    FakeServer server;
+    ConnectionPool<FakeConnection> pool(3, server.factory(), isHealthy);
+    auto lease = pool.acquire();
+
+    std::ostringstream out;
+    writePoolMetrics(out, "db_pool", pool.getStats());
+    EXPECT_NE(out.str().find("db_pool_capacity 3\n"), std::string::npos);
+    EXPECT_NE(out.str().find("db_pool_in_use 1\n"), std::string::npos);
+    EXPECT_NE(out.str().find("# TYPE db_pool_acquisitions_total counter\n"), std::string::npos);
+}
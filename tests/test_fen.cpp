@@ -0,0 +1,31 @@
+#include "gtest/gtest.h"
+#include "fen.h"
+#include "player.h"
+
+// Test loading the start position
+TEST(Fen, LoadStartPosition) {
+    Board board;
+    Color side = loadFen(board, START_FEN);
+
+    EXPECT_EQ(side, Color::WHITE);
+    EXPECT_EQ(popCount(board.getOccupancy()), 32);
+    EXPECT_EQ(board.getKingSquare(Color::BLACK), toSquare(Position('e', 8)));
+    EXPECT_EQ(board.getCastlingRights(), ALL_CASTLING_RIGHTS);
+    EXPECT_EQ(board.getEnPassantSquare(), NO_SQUARE);
+    EXPECT_EQ(board.getPiece(toSquare(Position('a', 2)))->getID(), static_cast<int>(MIN_WHITE_HORCRUXE_ID));
+}
+
+// Test that a loaded position is written back unchanged
+TEST(Fen, RoundTrip) {
+    const std::string fen = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b Kq e3 0 1";
+    Board board;
+    Color side = loadFen(board, fen);
+    EXPECT_EQ(toFen(board, side), fen);
+}
+
+// Test that malformed input is rejected
+TEST(Fen, RejectsInvalidInput) {
+    Board board;
+    EXPECT_THROW(loadFen(board, "not a fen"), std::logic_error);
+    EXPECT_THROW(loadFen(board, "8/8/8/8/8/8/8/7X w - - 0 1"), std::logic_error);
+}
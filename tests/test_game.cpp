@@ -163,6 +163,8 @@ TEST_F(GameTest, CheckGameOver_ReturnsFalse_WhenGameIsNotOver) {
 
     EXPECT_CALL(*mockRules, isValidMove(_, _, _))
         .WillRepeatedly(Return(true));
+    EXPECT_CALL(*mockRules, hasLegalMove(_, _))
+        .WillRepeatedly(Return(true));
 
     // Now, you create your game object.
     Game game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
@@ -178,40 +180,40 @@ TEST_F(GameTest, CheckGameOver_ReturnsFalse_WhenGameIsNotOver) {
 
 // Test case for checkmate scenario
 TEST_F(GameTest, CheckGameOver_ReturnsTrue_WhenCheckmate) {
-    // Setup mock behavior. In a checkmate scenario, the king is in check, and there are no valid moves.
-    Position kingPosition('e', 1);
-    EXPECT_CALL(*mockBoard, findKing(_)).WillRepeatedly(Return(&kingPosition));  // King is assumed to be found.
+    // Kings are never left in check, so a checkmated side keeps its horcrux but has no legal move
+    ON_CALL(*mockPlayer1, getHorcruxID())
+        .WillByDefault(Return(VALID_HORCRUXE_ID));
+    ON_CALL(*mockPlayer2, getHorcruxID())
+        .WillByDefault(Return(VALID_HORCRUXE_ID));
 
     EXPECT_CALL(*mockRules, isInCheck(_, Color::WHITE)).WillRepeatedly(Return(true));  // King is in check.
+    EXPECT_CALL(*mockRules, hasLegalMove(_, Color::WHITE)).WillRepeatedly(Return(false));  // Nothing gets it out.
 
-    // No valid moves for any piece, signifying checkmate.
-    EXPECT_CALL(*mockRules, isValidMove(_, _, _)).WillRepeatedly(Return(false));
-
-    // Construct game object with the mock dependencies. This assumes the Game class has a constructor that accepts these dependencies.
     Game game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
     game.startGame();
 
-    // Call the function to test. We expect checkGameOver to return true, indicating a checkmate has occurred.
+    mockPlayer1->setHorcruxID(3);
+    mockPlayer2->setHorcruxID(19);
+
+    // White is to move and checkmated, so black wins
     bool isGameOver = game.checkGameOver();
     EXPECT_TRUE(isGameOver);
-
-    // Further checks could be made here depending on the functionality of checkGameOver.
-    // For example, if the game state changes or specific players are notified, etc.
+    EXPECT_EQ(game.getGameState(), GameState::ENDED);
+    EXPECT_EQ(game.getGameResult(), GameEndType::BLACK_WIN);
 }
-/*
-// Test case for checkmate scenario (we already discussed this one)
+
+// Test case for checkmate scenario, with the check itself mocked
 TEST_F(GameTest, CheckGameOver_WhenCheckmate) {
     MockGame game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
     game.startGame();
 
-    EXPECT_CALL(game, _isCheckmate(_))
+    EXPECT_CALL(game, _isCheckmate())
         .WillOnce(Return(true));
 
     bool isGameOver = game.checkGameOver();
     EXPECT_TRUE(isGameOver);
-    EXPECT_EQ(game.getGameResult(), GameEndType::BLACK_WIN); // Assuming it's white's turn and it got checkmated.
+    EXPECT_EQ(game.getGameResult(), GameEndType::BLACK_WIN); // White's turn and it got checkmated.
 }
-*/
 
 // Test case for horcrux capture scenario
 TEST_F(GameTest, CheckGameOver_WhenHorcruxCaptured) {
@@ -270,7 +272,7 @@ TEST_F(GameTest, HorcruxGuess_ReturnsTrue_WhenGuessIsCorrect) {
 
     Game game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
     game.startGame();
-    EXPECT_TRUE(game.horcruxGuess(correctHorcruxID, mockPlayer1));
+    EXPECT_TRUE(game.horcruxGuess(correctHorcruxID, mockPlayer2, mockPlayer1));
 }
 
 TEST_F(GameTest, HorcruxGuess_ReturnsFalse_WhenGuessIsIncorrect) {
@@ -280,7 +282,7 @@ TEST_F(GameTest, HorcruxGuess_ReturnsFalse_WhenGuessIsIncorrect) {
 
     Game game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
     game.startGame();
-    EXPECT_FALSE(game.horcruxGuess(incorrectHorcruxID, mockPlayer1));
+    EXPECT_FALSE(game.horcruxGuess(incorrectHorcruxID, mockPlayer2, mockPlayer1));
 }
 
 // Test to check if the game state is retrieved correctly
@@ -316,7 +318,7 @@ TEST_F(GameTest, HorcruxGuess_SuccessfulWhenCorrect) {
     Game game(mockPlayer1, mockPlayer2, mockBoard, mockRules);
     game.startGame();
 
-    EXPECT_TRUE(game.horcruxGuess(correctHorcruxID, mockPlayer1));
+    EXPECT_TRUE(game.horcruxGuess(correctHorcruxID, mockPlayer2, mockPlayer1));
 }
 
 // Test for retrieving available positions for a piece
@@ -325,20 +327,93 @@ TEST_F(GameTest, GetAvailablePositions_ReturnsValidPositions) {
     game.startGame();
 
     Position pos('e', 2);
-    Move previousPos(mockPiece, Position('f', 2), Position('f', 3));
+    Move previousPos; // No move has been played yet
     
     // Define the expected positions
     std::unordered_set<Position> expectedPositions = {
         Position('e', 4), Position('e', 5) // Just examples, use actual board positions
     };
 
-    // Set expectation that `generateValidPositions` will be called with our piece and should return the `expectedPositions`
-    EXPECT_CALL(*mockRules, generateValidPositions(_, mockPiece, pos, previousPos))
-        .WillOnce(Return(expectedPositions));
+    // Set expectation that `generateValidMoves` will be called for our square and fill in the `expectedPositions`
+    EXPECT_CALL(*mockRules, generateValidMoves(_, pos, previousPos, _))
+        .WillOnce(Invoke([&](const Board&, const Position& from, const Move&, MoveList& moves) {
+            for (const Position& to : expectedPositions) {
+                moves.push_back(CompactMove(toSquare(from), toSquare(to)));
+            }
+        }));
 
     // Call the function to test
     auto actualPositions = game.getAvailablePositions(mockPiece, pos);
 
     // Validate the positions received are as expected
     EXPECT_EQ(actualPositions, expectedPositions);
-}
\ No newline at end of file
+}
+// Test that shuffling knights back and forth ends the game by threefold repetition
+TEST(Game, ThreefoldRepetitionEndsInDraw) {
+    Player white(Color::WHITE);
+    Player black(Color::BLACK);
+    Board board;
+    BoardRules rules;
+    Game game(&white, &black, &board, &rules);
+    game.startGame();
+    white.setHorcruxID(MIN_WHITE_HORCRUXE_ID);
+    black.setHorcruxID(MIN_BLACK_HORCRUXE_ID);
+    game.checkHorcruxSet();
+
+    const std::pair<Position, Position> shuffle[] = {
+        {Position('g', 1), Position('f', 3)}, {Position('g', 8), Position('f', 6)},
+        {Position('f', 3), Position('g', 1)}, {Position('f', 6), Position('g', 8)},
+    };
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_NE(game.getGameState(), GameState::ENDED);
+            Player* mover = (i % 2 == 0) ? &white : &black;
+            const IPiece* knight = game.getPieceFromPosition(shuffle[i].first);
+            game.movePiece(Move(knight, shuffle[i].first, shuffle[i].second), mover);
+        }
+    }
+
+    EXPECT_EQ(game.getGameState(), GameState::ENDED);
+    EXPECT_EQ(game.getGameResult(), GameEndType::DRAW);
+}
+
+// Test that restoring a snapshot into a fresh game reproduces the position, rights and players
+TEST(Game, SnapshotRoundTrip) {
+    Player white(Color::WHITE);
+    Player black(Color::BLACK);
+    Board board;
+    BoardRules rules;
+    Game game(&white, &black, &board, &rules);
+    game.startGame();
+    white.setHorcruxID(MIN_WHITE_HORCRUXE_ID);
+    black.setHorcruxID(MIN_BLACK_HORCRUXE_ID);
+    game.checkHorcruxSet();
+
+    const std::pair<Position, Position> moves[] = {
+        {Position('e', 2), Position('e', 4)}, {Position('d', 7), Position('d', 5)},
+        {Position('e', 4), Position('d', 5)}, {Position('e', 7), Position('e', 5)},
+    };
+    for (int i = 0; i < 4; ++i) {
+        Player* mover = (i % 2 == 0) ? &white : &black;
+        game.movePiece(Move(game.getPieceFromPosition(moves[i].first), moves[i].first, moves[i].second), mover);
+    }
+    game.horcruxGuess(MIN_WHITE_HORCRUXE_ID + 1, &black, &white);
+    const GameSnapshot snapshot = game.takeSnapshot();
+
+    Player restoredWhite(Color::WHITE);
+    Player restoredBlack(Color::BLACK);
+    Board restoredBoard;
+    Game restored(&restoredWhite, &restoredBlack, &restoredBoard, &rules);
+    restored.startGame();
+    restored.restoreSnapshot(snapshot);
+
+    EXPECT_EQ(restored.takeSnapshot(), snapshot);
+    EXPECT_EQ(restoredBoard.getZobristKey(), board.getZobristKey());
+    EXPECT_EQ(restored.getGameState(), GameState::WHITE_MOVE);
+    EXPECT_EQ(restoredBlack.getNumberOfHorcruxGuessesLeft(), black.getNumberOfHorcruxGuessesLeft());
+
+    // The d5 pawn can still take en passant after the restore
+    const IPiece* pawn = restored.getPieceFromPosition(Position('d', 5));
+    restored.movePiece(Move(pawn, Position('d', 5), Position('e', 6)), &restoredWhite);
+    EXPECT_EQ(restored.getPieceFromPosition(Position('e', 5)), nullptr);
+}
@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include "game_channel.h"
+#include <memory>
+#include <thread>
+
+// Test that a message reaches every subscriber of its game and nobody else
+TEST(GameChannel, PublishReachesOnlyThatGame) {
+    GameChannel channel;
+    std::vector<std::string> white, black, other;
+    int whiteKey, blackKey, otherKey;
+    channel.subscribe("game-1", &whiteKey, [&white](const std::string& m) {white.push_back(m);});
+    channel.subscribe("game-1", &blackKey, [&black](const std::string& m) {black.push_back(m);});
+    channel.subscribe("game-2", &otherKey, [&other](const std::string& m) {other.push_back(m);});
+
+    EXPECT_EQ(channel.publish("game-1", "moved"), 2U);
+    EXPECT_EQ(channel.publish("game-3", "nobody"), 0U);
+
+    EXPECT_EQ(white, std::vector<std::string>{"moved"});
+    EXPECT_EQ(black, std::vector<std::string>{"moved"});
+    EXPECT_TRUE(other.empty());
+    EXPECT_EQ(channel.getSubscriberCount(), 3U);
+}
+
+// Test that an unsubscribed connection hears nothing more and can be unsubscribed twice
+TEST(GameChannel, UnsubscribeStopsDelivery) {
+    GameChannel channel;
+    int received = 0;
+    int key;
+    channel.subscribe("game-1", &key, [&received](const std::string&) {received++;});
+    EXPECT_THROW(channel.subscribe("game-2", &key, [](const std::string&) {}), std::logic_error);
+
+    channel.publish("game-1", "first");
+    channel.unsubscribe(&key);
+    channel.unsubscribe(&key);
+    channel.publish("game-1", "second");
+
+    EXPECT_EQ(received, 1);
+    EXPECT_EQ(channel.getSubscriberCount(), 0U);
+}
+
+// Test that publishing and unsubscribing from different threads never send to a departed subscriber
+TEST(GameChannel, ConcurrentPublishAndUnsubscribe) {
+    GameChannel channel;
+    const int subscribers = 64;
+    std::vector<int> keys(subscribers);
+    std::vector<std::unique_ptr<int>> counters;
+    for (int i = 0; i < subscribers; ++i) {
+        counters.push_back(std::make_unique<int>(0));
+        int* counter = counters.back().get();
+        channel.subscribe("game-1", &keys[i], [counter](const std::string&) {(*counter)++;});
+    }
+
+    std::thread publisher([&channel]() {
+        for (int i = 0; i < 1000; ++i) {channel.publish("game-1", "tick");}
+    });
+    for (int i = 0; i < subscribers; ++i) {
+        channel.unsubscribe(&keys[i]);
+        counters[i].reset();
+    }
+    publisher.join();
+
+    EXPECT_EQ(channel.getSubscriberCount(), 0U);
+}
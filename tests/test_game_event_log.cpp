@@ -0,0 +1,55 @@
+#include "gtest/gtest.h"
+#include "game_event_log.h"
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+std::string tempLogPath(const std::string& name) {
+    const std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+} // namespace
+
+// Test that appended records read back in order with their payloads
+TEST(GameEventLog, AppendAndRead) {
+    const std::string path = tempLogPath("append_and_read.log");
+    {
+        GameEventLog log(path);
+        log.appendCreated("white-1");
+        log.appendJoined("black-1");
+        log.appendHorcruxSet(Color::BLACK, 20);
+        log.appendMove(CompactMove(12, 28));
+        EXPECT_EQ(log.getEventsSinceSnapshot(), 2U);
+    }
+
+    const std::vector<GameEvent> events = GameEventLog::read(path);
+    ASSERT_EQ(events.size(), 4U);
+    EXPECT_EQ(events[0].type, GameEventType::CREATED);
+    EXPECT_EQ(events[0].payload, "white-1");
+    EXPECT_EQ(events[1].payload, "black-1");
+    EXPECT_EQ(events[2].type, GameEventType::HORCRUX_SET);
+    EXPECT_EQ(events[2].payload, std::string({static_cast<char>(Color::BLACK), 20}));
+    EXPECT_EQ(events[3].type, GameEventType::MOVE);
+    EXPECT_EQ(events[3].payload.size(), 2U);
+}
+
+// Test that a record cut off mid-write is dropped and the ones before it survive
+TEST(GameEventLog, TruncatedTailIsIgnored) {
+    const std::string path = tempLogPath("truncated_tail.log");
+    {
+        GameEventLog log(path);
+        log.appendCreated("white-1");
+        log.appendMove(CompactMove(12, 28));
+    }
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << static_cast<char>(GameEventType::MOVE) << static_cast<char>(2) << static_cast<char>(1);
+    }
+
+    const std::vector<GameEvent> events = GameEventLog::read(path);
+    ASSERT_EQ(events.size(), 2U);
+    EXPECT_EQ(events[1].type, GameEventType::MOVE);
+}
@@ -0,0 +1,308 @@
+#include "gtest/gtest.h"
+#include "game_registry.h"
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+// Test that a created game can be found until it is removed
+TEST(GameRegistry, CreateFindRemove) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+
+    EXPECT_EQ(registry.find("game-1"), pSession);
+    EXPECT_EQ(registry.find("game-2"), nullptr);
+    EXPECT_EQ(registry.size(), 1U);
+
+    EXPECT_TRUE(registry.remove("game-1"));
+    EXPECT_FALSE(registry.remove("game-1"));
+    EXPECT_EQ(registry.find("game-1"), nullptr);
+}
+
+// Test that a game ID cannot be reused while the game is live
+TEST(GameRegistry, DuplicateIDThrows) {
+    GameRegistry registry;
+    registry.create("game-1", "white-1");
+    EXPECT_THROW(registry.create("game-1", "white-2"), std::logic_error);
+}
+
+// Test that the game waits for its second player and keeps its board between lookups
+TEST(GameRegistry, SessionKeepsLiveGame) {
+    GameRegistry registry;
+    registry.create("game-1", "white-1");
+
+    auto pSession = registry.find("game-1");
+    EXPECT_EQ(pSession->getGameState(), GameState::WAITING_FOR_OPPONENT);
+    EXPECT_EQ(pSession->findPlayer("black-1"), nullptr);
+
+    pSession->join("black-1");
+    EXPECT_THROW(pSession->join("black-2"), std::logic_error);
+    EXPECT_EQ(pSession->getGameState(), GameState::CHOOSING_HORCRUX);
+
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+    ASSERT_NE(pWhite, nullptr);
+    ASSERT_NE(pBlack, nullptr);
+    EXPECT_EQ(pWhite->getColor(), Color::WHITE);
+    EXPECT_EQ(pSession->getOpponent(pWhite), pBlack);
+
+    pWhite->setHorcruxID(MIN_WHITE_HORCRUXE_ID);
+    pBlack->setHorcruxID(MIN_BLACK_HORCRUXE_ID);
+    pSession->getGame().checkHorcruxSet();
+
+    Game& game = pSession->getGame();
+    const IPiece* pawn = game.getPieceFromPosition(Position('e', 2));
+    game.movePiece(Move(pawn, Position('e', 2), Position('e', 4)), pWhite);
+
+    Game& sameGame = registry.find("game-1")->getGame();
+    EXPECT_EQ(sameGame.getPieceFromPosition(Position('e', 4)), pawn);
+    EXPECT_EQ(sameGame.getGameState(), GameState::BLACK_MOVE);
+}
+
+// Test that games created from several threads all land in the registry
+TEST(GameRegistry, ConcurrentCreate) {
+    GameRegistry registry;
+    const int threads = 4;
+    const int gamesPerThread = 50;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&registry, t]() {
+            for (int i = 0; i < gamesPerThread; ++i) {
+                const std::string id = std::to_string(t) + "-" + std::to_string(i);
+                registry.create(id, "white-" + id);
+                EXPECT_NE(registry.find(id), nullptr);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(registry.size(), static_cast<size_t>(threads * gamesPerThread));
+}
+
+// Test that a restarted registry replays logged games to the same state, with or without snapshots
+TEST(GameRegistry, RecoverFromLogs) {
+    const std::string directory = ::testing::TempDir() + "registry_recover";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    GameSnapshot expected;
+    {
+        GameRegistry registry(directory, 3);
+        registry.create("waiting", "white-0");
+        auto pSession = registry.create("game-1", "white-1");
+        pSession->join("black-1");
+        Player* pWhite = pSession->findPlayer("white-1");
+        Player* pBlack = pSession->findPlayer("black-1");
+        pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+        EXPECT_TRUE(pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID));
+
+        pSession->movePiece(pWhite, Position('e', 2), Position('e', 4));
+        pSession->movePiece(pBlack, Position('d', 7), Position('d', 5));
+        pSession->movePiece(pWhite, Position('e', 4), Position('d', 5));
+        EXPECT_FALSE(pSession->guessHorcrux(pBlack, MIN_WHITE_HORCRUXE_ID + 1));
+        expected = pSession->getGame().takeSnapshot();
+
+        registry.create("removed", "white-2");
+        registry.remove("removed");
+    }
+
+    GameRegistry registry(directory, 3);
+    EXPECT_EQ(registry.recover(), 2U);
+    EXPECT_EQ(registry.find("removed"), nullptr);
+    EXPECT_EQ(registry.find("waiting")->getGameState(), GameState::WAITING_FOR_OPPONENT);
+
+    auto pSession = registry.find("game-1");
+    ASSERT_NE(pSession, nullptr);
+    EXPECT_EQ(pSession->getGame().takeSnapshot(), expected);
+
+    // The recovered game keeps logging where the old one left off
+    Player* pBlack = pSession->findPlayer("black-1");
+    pSession->movePiece(pBlack, Position('g', 8), Position('f', 6));
+    expected = pSession->getGame().takeSnapshot();
+
+    GameRegistry restarted(directory, 3);
+    EXPECT_EQ(restarted.recover(), 2U);
+    EXPECT_EQ(restarted.find("game-1")->getGame().takeSnapshot(), expected);
+}
+
+// Test that every change bumps the version and wakes each watcher exactly once
+TEST(GameRegistry, VersionAndWatchers) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    EXPECT_EQ(pSession->getVersion(), 0U);
+
+    int woken = 0;
+    int cancelled = 0;
+    pSession->watch([&woken]() {woken++;});
+    const uint64_t watchID = pSession->watch([&cancelled]() {cancelled++;});
+    pSession->unwatch(watchID);
+
+    pSession->join("black-1");
+    EXPECT_EQ(pSession->getVersion(), 1U);
+    pSession->selectHorcrux(pSession->findPlayer("white-1"), MIN_WHITE_HORCRUXE_ID);
+    EXPECT_EQ(pSession->getVersion(), 2U);
+
+    EXPECT_EQ(woken, 1);
+    EXPECT_EQ(cancelled, 0);
+
+    // A rejected move changes nothing
+    EXPECT_THROW(pSession->movePiece(pSession->findPlayer("white-1"), Position('e', 2), Position('e', 5)), std::logic_error);
+    EXPECT_EQ(pSession->getVersion(), 2U);
+}
+
+// Test that moves record exactly the squares they changed, en passant captures included
+TEST(GameRegistry, MovesRecordChangedSquares) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+    const uint64_t joined = pSession->getVersion();
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID);
+
+    Bitboard squares = 0;
+    std::vector<BoardDiff> diffs;
+    EXPECT_FALSE(pSession->getDiffs().collect(joined - 1, squares, diffs));
+
+    pSession->movePiece(pWhite, Position('e', 2), Position('e', 4));
+    pSession->movePiece(pBlack, Position('a', 7), Position('a', 6));
+    pSession->movePiece(pWhite, Position('e', 4), Position('e', 5));
+    const uint64_t beforePush = pSession->getVersion();
+    pSession->movePiece(pBlack, Position('d', 7), Position('d', 5));
+    pSession->movePiece(pWhite, Position('e', 5), Position('d', 6));
+
+    ASSERT_TRUE(pSession->getDiffs().collect(beforePush, squares, diffs));
+    const Bitboard expected = squareBit(toSquare(Position('d', 7))) | squareBit(toSquare(Position('d', 5))) |
+                              squareBit(toSquare(Position('e', 5))) | squareBit(toSquare(Position('d', 6)));
+    EXPECT_EQ(squares, expected);
+    ASSERT_EQ(diffs.size(), 2U);
+    EXPECT_EQ(diffs[1].type, GameEventType::MOVE);
+}
+
+// Test that checkmate ends the game with the mating side winning
+TEST(GameRegistry, CheckmateEndsGame) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID);
+
+    // Fool's mate
+    pSession->movePiece(pWhite, Position('f', 2), Position('f', 3));
+    pSession->movePiece(pBlack, Position('e', 7), Position('e', 5));
+    pSession->movePiece(pWhite, Position('g', 2), Position('g', 4));
+    pSession->movePiece(pBlack, Position('d', 8), Position('h', 4));
+
+    EXPECT_EQ(pSession->getGameState(), GameState::ENDED);
+    EXPECT_EQ(pSession->getGame().getGameResult(), GameEndType::BLACK_WIN);
+}
+
+// Test that moves are refused before both horcruxes are chosen and out of turn, leaving the game as it was
+TEST(GameRegistry, MoveRejectedOutOfTurn) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+
+    EXPECT_THROW(pSession->movePiece(pWhite, Position('e', 2), Position('e', 4)), std::logic_error);
+    EXPECT_EQ(pSession->getGameState(), GameState::CHOOSING_HORCRUX);
+
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID);
+    EXPECT_THROW(pSession->movePiece(pBlack, Position('e', 7), Position('e', 5)), std::logic_error);
+
+    const uint64_t version = pSession->getVersion();
+    pSession->movePiece(pWhite, Position('e', 2), Position('e', 4));
+    EXPECT_THROW(pSession->movePiece(pWhite, Position('d', 2), Position('d', 4)), std::logic_error);
+    EXPECT_EQ(pSession->getGameState(), GameState::BLACK_MOVE);
+    EXPECT_EQ(pSession->getVersion(), version + 1);
+}
+
+// Test that a horcrux is chosen once, from the player's own pieces, and never once play has started
+TEST(GameRegistry, HorcruxSelectionRejectedOutsideChoosing) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+
+    EXPECT_THROW(pSession->selectHorcrux(pBlack, MIN_WHITE_HORCRUXE_ID), std::logic_error);
+    EXPECT_EQ(pBlack->getHorcruxID(), INVALID_HORCRUXE_ID);
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    EXPECT_THROW(pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID + 1), std::logic_error);
+    pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID);
+
+    pSession->movePiece(pWhite, Position('e', 2), Position('e', 4));
+    const uint64_t version = pSession->getVersion();
+    EXPECT_THROW(pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID + 1), std::logic_error);
+    EXPECT_EQ(pWhite->getHorcruxID(), static_cast<int>(MIN_WHITE_HORCRUXE_ID));
+    EXPECT_EQ(pSession->getGameState(), GameState::BLACK_MOVE);
+    EXPECT_EQ(pSession->getVersion(), version);
+
+    // The turn was not rewound, so black still moves next
+    EXPECT_THROW(pSession->movePiece(pWhite, Position('d', 2), Position('d', 4)), std::logic_error);
+    pSession->movePiece(pBlack, Position('e', 7), Position('e', 5));
+}
+
+// Test that horcrux guesses are refused before play starts and after the game has ended
+TEST(GameRegistry, HorcruxGuessRejectedOutsidePlay) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    Player* pBlack = pSession->findPlayer("black-1");
+
+    EXPECT_THROW(pSession->guessHorcrux(pWhite, MIN_BLACK_HORCRUXE_ID), std::logic_error);
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pBlack, MIN_BLACK_HORCRUXE_ID);
+
+    // Fool's mate
+    pSession->movePiece(pWhite, Position('f', 2), Position('f', 3));
+    pSession->movePiece(pBlack, Position('e', 7), Position('e', 5));
+    pSession->movePiece(pWhite, Position('g', 2), Position('g', 4));
+    pSession->movePiece(pBlack, Position('d', 8), Position('h', 4));
+    ASSERT_EQ(pSession->getGameState(), GameState::ENDED);
+
+    const uint64_t version = pSession->getVersion();
+    const int guessesLeft = pWhite->getNumberOfHorcruxGuessesLeft();
+    EXPECT_THROW(pSession->guessHorcrux(pWhite, MIN_BLACK_HORCRUXE_ID + 1), std::logic_error);
+    EXPECT_EQ(pWhite->getNumberOfHorcruxGuessesLeft(), guessesLeft);
+    EXPECT_EQ(pSession->getVersion(), version);
+}
+
+// Test that a move naming a square off the board is refused rather than looked up
+TEST(GameRegistry, MoveRejectedOffBoard) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pSession->findPlayer("black-1"), MIN_BLACK_HORCRUXE_ID);
+
+    EXPECT_EQ(pSession->getGame().getPieceFromPosition(Position('z', 9)), nullptr);
+    EXPECT_THROW(pSession->movePiece(pWhite, Position('z', 9), Position('a', 1)), std::logic_error);
+    EXPECT_THROW(pSession->movePiece(pWhite, Position('e', 2), Position('e', 0)), std::logic_error);
+    EXPECT_EQ(pSession->getGameState(), GameState::WHITE_MOVE);
+}
+
+// Test that the one-pass legal move list matches the per-piece positions it replaces in snapshots
+TEST(GameRegistry, LegalMovesMatchAvailablePositions) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Game& game = pSession->getGame();
+
+    MoveList moves;
+    game.getLegalMoves(Color::WHITE, moves);
+    EXPECT_EQ(moves.size(), 20U);
+    for (const CompactMove& move : moves) {
+        const Position from = toPosition(move.getFrom());
+        EXPECT_EQ(game.getAvailablePositions(game.getPieceFromPosition(from), from).count(toPosition(move.getTo())), 1U);
+    }
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "logger.h"
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Collects everything the logger writes
+struct CapturedOutput {
+    std::mutex mutex;
+    std::string text;
+
+    Logger::Sink sink() {
+        return [this](const char* data, size_t size) {
+            std::lock_guard<std::mutex> lock(mutex);
+            text.append(data, size);
+        };
+    }
+
+    std::vector<std::string> lines() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> result;
+        std::istringstream in(text);
+        for (std::string line; std::getline(in, line);) {result.push_back(line);}
+        return result;
+    }
+};
+
+} // namespace
+
+// Test that a line carries its level, message and fields, quoting values with spaces
+TEST(Logger, FormatsStructuredFields) {
+    CapturedOutput output;
+    Logger logger(output.sink());
+    logger.log(LogLevel::WARNING, "Move rejected", {{"gameID", "game-1"}, {"version", 7}, {"reason", "not your turn"}});
+    logger.flush();
+
+    const std::vector<std::string> lines = output.lines();
+    ASSERT_EQ(lines.size(), 1U);
+    EXPECT_NE(lines[0].find("Z WARNING Move rejected gameID=game-1 version=7 reason=\"not your turn\""), std::string::npos);
+}
+
+// Test that lines below the run-time level are dropped and long lines are cut short
+TEST(Logger, LevelAndLength) {
+    CapturedOutput output;
+    Logger logger(output.sink());
+    logger.setLevel(LogLevel::INFO);
+    logger.log(LogLevel::DEBUG, "hidden");
+    logger.log(LogLevel::INFO, std::string(1000, 'x'));
+    logger.flush();
+
+    const std::vector<std::string> lines = output.lines();
+    ASSERT_EQ(lines.size(), 1U);
+    EXPECT_EQ(lines[0].size(), static_cast<size_t>(LOG_RECORD_BYTES - 1));
+}
+
+// Test that every line from many threads arrives once and a full ring drops instead of blocking
+TEST(Logger, ConcurrentProducers) {
+    CapturedOutput output;
+    Logger logger(output.sink(), 64);
+    const int threads = 4;
+    const int linesPerThread = 2000;
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threads; ++t) {
+        producers.emplace_back([&logger, t]() {
+            for (int i = 0; i < linesPerThread; ++i) {
+                logger.log(LogLevel::INFO, "tick", {{"thread", t}, {"i", i}});
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    logger.flush();
+
+    EXPECT_EQ(output.lines().size() + logger.getDropped(), static_cast<size_t>(threads * linesPerThread));
+}
+
+// Test that logs below the compile-time level do not even evaluate their arguments
+TEST(Logger, CompileTimeFilter) {
+    int evaluated = 0;
+    auto expensive = [&evaluated]() {
+        evaluated++;
+        return std::string("value");
+    };
+    CHESS_LOG_DEBUG("debug", {{"field", expensive()}});
+    EXPECT_EQ(evaluated, CHESS_LOG_MIN_LEVEL <= 0 ? 1 : 0);
+}
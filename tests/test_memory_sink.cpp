@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+#include "memory_sink.h"
+
+// Test that a game's rows go through the same lifecycle as in MySQL, from create to kill
+TEST(MemorySink, AppliesEvents) {
+    MemorySink sink;
+    sink.writeBatch({
+        {PersistEventType::CREATE_GAME, "g1", "", 0},
+        {PersistEventType::CREATE_PLAYER, "", "white-1", 0},
+        {PersistEventType::CREATE_PLAYER, "", "black-1", 1},
+        {PersistEventType::GAME_STATE, "g1", "", 2},
+        {PersistEventType::PLAYER_HORCRUX, "", "black-1", 20},
+    });
+
+    int state = -1;
+    ASSERT_TRUE(sink.findGameState("g1", state));
+    EXPECT_EQ(state, 2);
+    StoredPlayer player;
+    ASSERT_TRUE(sink.findPlayer("black-1", player));
+    EXPECT_EQ(player.color, 1);
+    EXPECT_EQ(player.horcruxID, 20);
+    ASSERT_TRUE(sink.findPlayer("white-1", player));
+    EXPECT_EQ(player.horcruxID, NO_HORCRUX);
+
+    sink.writeBatch({
+        {PersistEventType::REMOVE_PLAYER, "", "white-1", 0},
+        {PersistEventType::KILL_GAME, "g1", "", 0},
+    });
+    EXPECT_FALSE(sink.findGameState("g1", state));
+    EXPECT_FALSE(sink.findPlayer("white-1", player));
+    EXPECT_EQ(sink.getGameCount(), 0U);
+    EXPECT_EQ(sink.getPlayerCount(), 1U);
+}
+
+// Test that the sink stands in for MySQL behind the write-behind queue
+TEST(MemorySink, BehindWriteBehindQueue) {
+    MemorySink sink;
+    WriteBehindConfig config;
+    config.flushInterval = std::chrono::milliseconds(1);
+    WriteBehindQueue queue(sink, config);
+
+    for (int i = 0; i < 100; ++i) {
+        queue.enqueue({PersistEventType::CREATE_GAME, "g" + std::to_string(i), "", 0});
+        queue.enqueue({PersistEventType::GAME_STATE, "g" + std::to_string(i), "", 4});
+    }
+    queue.flush();
+
+    EXPECT_EQ(sink.getGameCount(), 100U);
+    int state = -1;
+    ASSERT_TRUE(sink.findGameState("g42", state));
+    EXPECT_EQ(state, 4);
+}
+
+// Test that an update arriving after a delete does not bring the row back
+TEST(MemorySink, UpdatesDoNotResurrectDeletedRows) {
+    MemorySink sink;
+    sink.writeBatch({
+        {PersistEventType::CREATE_GAME, "g1", "", 0},
+        {PersistEventType::CREATE_PLAYER, "", "white-1", 0},
+        {PersistEventType::KILL_GAME, "g1", "", 0},
+        {PersistEventType::REMOVE_PLAYER, "", "white-1", 0},
+        {PersistEventType::GAME_STATE, "g1", "", 5},
+        {PersistEventType::PLAYER_HORCRUX, "", "white-1", 3},
+    });
+
+    int state = -1;
+    StoredPlayer player;
+    EXPECT_FALSE(sink.findGameState("g1", state));
+    EXPECT_FALSE(sink.findPlayer("white-1", player));
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "metrics.h"
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Test that bucket indexes never decrease and each bucket spans at most a quarter of its lower bound
+TEST(Metrics, BucketsAreLogLinear) {
+    EXPECT_EQ(LatencyHistogram::bucketIndex(0), 0U);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(7), 7U);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(8), 8U);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(1023), LatencyHistogram::bucketIndex(1024) - 1);
+    EXPECT_EQ(LatencyHistogram::bucketIndex(1024), LatencyHistogram::bucketIndex(1279));
+    EXPECT_NE(LatencyHistogram::bucketIndex(1279), LatencyHistogram::bucketIndex(1280));
+    EXPECT_EQ(LatencyHistogram::bucketIndex(~0ULL), static_cast<size_t>(HISTOGRAM_BUCKETS - 1));
+
+    size_t previous = 0;
+    for (uint64_t nanos = 1; nanos < (1ULL << 20); nanos += nanos / 7 + 1) {
+        const size_t index = LatencyHistogram::bucketIndex(nanos);
+        EXPECT_GE(index, previous);
+        previous = index;
+    }
+}
+
+// Test that a snapshot counts every value and splits them at the bucket bounds
+TEST(Metrics, HistogramSnapshot) {
+    LatencyHistogram histogram;
+    histogram.record(uint64_t{500});
+    histogram.record(uint64_t{2000});
+    histogram.record(std::chrono::milliseconds(3));
+
+    const HistogramSnapshot snapshot = histogram.getSnapshot();
+    EXPECT_EQ(snapshot.count, 3U);
+    EXPECT_EQ(snapshot.sumNanos, 3002500U);
+    EXPECT_EQ(snapshot.countBelow(10), 1U);     // Below 1024 ns
+    EXPECT_EQ(snapshot.countBelow(10, 3), 1U);  // Below 1792 ns
+    EXPECT_EQ(snapshot.countBelow(11), 2U);
+    EXPECT_EQ(snapshot.countBelow(22), 3U);     // Below about 4 ms
+
+    // Quantiles come back as the end of their bucket, within a quarter of the value
+    EXPECT_EQ(snapshot.quantileNanos(0.3), 512U);
+    EXPECT_EQ(snapshot.quantileNanos(0.5), 2048U);
+    EXPECT_GE(snapshot.quantileNanos(0.99), 3000000U);
+    EXPECT_LE(snapshot.quantileNanos(0.99), 3750000U);
+    EXPECT_EQ(HistogramSnapshot().quantileNanos(0.5), 0U);
+}
+
+// Test that counts from many threads add up exactly
+TEST(Metrics, ConcurrentRecording) {
+    Counter counter;
+    LatencyHistogram histogram;
+    const int threads = 8;
+    const int perThread = 10000;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&counter, &histogram]() {
+            for (int i = 0; i < perThread; ++i) {
+                counter.add();
+                histogram.record(static_cast<uint64_t>(i));
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(counter.getValue(), static_cast<uint64_t>(threads * perThread));
+    EXPECT_EQ(histogram.getSnapshot().count, static_cast<uint64_t>(threads * perThread));
+}
+
+// Test that the registry hands out one metric per name and labels, and exposes them in Prometheus format
+TEST(Metrics, RegistryExposition) {
+    MetricsRegistry registry;
+    Counter& errors = registry.counter("errors_total", "route=\"/a\"");
+    EXPECT_EQ(&registry.counter("errors_total", "route=\"/a\""), &errors);
+    EXPECT_NE(&registry.counter("errors_total", "route=\"/b\""), &errors);
+    errors.add(2);
+
+    LatencyHistogram& duration = registry.histogram("duration_seconds", "route=\"/a\"");
+    duration.record(std::chrono::microseconds(3));
+    registry.histogram("duration_seconds", "route=\"/b\"");
+
+    std::ostringstream out;
+    registry.write(out);
+    const std::string text = out.str();
+
+    EXPECT_NE(text.find("# TYPE errors_total counter\nerrors_total{route=\"/a\"} 2\nerrors_total{route=\"/b\"} 0\n"), std::string::npos);
+    EXPECT_EQ(text.find("# TYPE duration_seconds histogram"), text.rfind("# TYPE duration_seconds histogram"));
+    EXPECT_NE(text.find("duration_seconds_bucket{route=\"/a\",le=\"2.048e-06\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("duration_seconds_bucket{route=\"/a\",le=\"3.072e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("duration_seconds_bucket{route=\"/a\",le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("duration_seconds_count{route=\"/a\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("duration_seconds_count{route=\"/b\"} 0\n"), std::string::npos);
+}
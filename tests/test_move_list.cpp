@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+#include "move_list.h"
+
+TEST(CompactMove, PacksFromToAndFlag) {
+    CompactMove move(toSquare(Position('e', 7)), toSquare(Position('d', 8)), MoveFlag::QUEEN_PROMOTION_CAPTURE);
+    EXPECT_EQ(move.getFrom(), toSquare(Position('e', 7)));
+    EXPECT_EQ(move.getTo(), toSquare(Position('d', 8)));
+    EXPECT_TRUE(move.isCapture());
+    EXPECT_TRUE(move.isPromotion());
+    EXPECT_EQ(move.getPromotionType(), PieceType::QUEEN);
+    EXPECT_EQ(sizeof(CompactMove), 2u);
+}
+
+TEST(MoveList, AddMovesFlagsCaptures) {
+    MoveList moves;
+    int from = toSquare(Position('a', 1));
+    Bitboard targets = squareBit(toSquare(Position('a', 2))) | squareBit(toSquare(Position('b', 1)));
+    moves.addMoves(from, targets, squareBit(toSquare(Position('b', 1))));
+
+    ASSERT_EQ(moves.size(), 2u);
+    EXPECT_TRUE(moves.contains(from, toSquare(Position('b', 1))));
+    EXPECT_EQ(moves.getTargets(), targets);
+    for (const CompactMove& move : moves) {
+        EXPECT_EQ(move.isCapture(), move.getTo() == toSquare(Position('b', 1)));
+    }
+
+    moves.clear();
+    EXPECT_TRUE(moves.empty());
+}
+
+TEST(MoveList, AddPromotionsAddsFourMoves) {
+    MoveList moves;
+    moves.addPromotions(toSquare(Position('b', 7)), toSquare(Position('b', 8)), false);
+    ASSERT_EQ(moves.size(), 4u);
+    EXPECT_EQ(moves[0].getPromotionType(), PieceType::QUEEN);
+    EXPECT_FALSE(moves[0].isCapture());
+    EXPECT_EQ(moves.toPositions().size(), 1u);
+}
@@ -0,0 +1,48 @@
+#include "gtest/gtest.h"
+#include "fen.h"
+#include "perft.h"
+
+namespace {
+
+// Keeps the suite fast while still reaching promotions, castling and en passant in every position
+const uint64_t MAX_TEST_NODES = 500000;
+
+}
+
+// Test every reference position against its known node counts
+TEST(Perft, ReferencePositions) {
+    BoardRules rules;
+    for (const PerftPosition& position : referencePerftPositions()) {
+        Board board;
+        Color side = loadFen(board, position.fen);
+        for (size_t depth = 1; depth <= position.nodes.size() && position.nodes[depth - 1] <= MAX_TEST_NODES; ++depth) {
+            EXPECT_EQ(perft(board, rules, side, depth), position.nodes[depth - 1])
+                << position.name << " at depth " << depth;
+        }
+        EXPECT_EQ(toFen(board, side).substr(0, 20), std::string(position.fen).substr(0, 20))
+            << position.name << " was not restored by unmakeMove";
+    }
+}
+
+// Test that divide adds up to the full count
+TEST(Perft, DivideSumsToPerft) {
+    BoardRules rules;
+    Board board;
+    Color side = loadFen(board, referencePerftPositions()[1].fen);
+
+    uint64_t total = 0;
+    auto divide = perftDivide(board, rules, side, 2);
+    for (const auto& entry : divide) {
+        total += entry.second;
+    }
+    EXPECT_EQ(divide.size(), 48);
+    EXPECT_EQ(total, 2039);
+}
+
+// Test that the threaded root split finds the same count
+TEST(Perft, ParallelMatchesSerial) {
+    BoardRules rules;
+    Board board;
+    Color side = loadFen(board, START_FEN);
+    EXPECT_EQ(perftParallel(board, rules, side, 3, 4), 8902);
+}
@@ -0,0 +1,50 @@
+#include "gtest/gtest.h"
+#include "position_history.h"
+
+// Test that the halfmove clock counts up and resets on irreversible moves
+TEST(PositionHistory, HalfmoveClock) {
+    PositionHistory history;
+    history.push(1, true);
+    history.push(2, false);
+    history.push(3, false);
+    EXPECT_EQ(history.getHalfmoveClock(), 2);
+
+    history.push(4, true);
+    EXPECT_EQ(history.getHalfmoveClock(), 0);
+}
+
+// Test that repetitions are counted for the same side to move only
+TEST(PositionHistory, RepetitionCount) {
+    PositionHistory history;
+    for (ZobristKey key : {10, 11, 12, 13, 10, 11, 12, 13, 10}) {
+        history.push(key, false);
+    }
+    EXPECT_EQ(history.repetitionCount(), 3);
+
+    // The same key at an odd distance belongs to the other side to move
+    history.push(10, false);
+    EXPECT_EQ(history.repetitionCount(), 1);
+}
+
+// Test that nothing before an irreversible move is counted
+TEST(PositionHistory, RepetitionStopsAtIrreversibleMove) {
+    PositionHistory history;
+    for (ZobristKey key : {10, 11, 10, 11}) {
+        history.push(key, false);
+    }
+    history.push(12, true);
+    history.push(11, false);
+    history.push(10, false);
+    EXPECT_EQ(history.repetitionCount(), 1);
+}
+
+// Test that the ring keeps working past its capacity
+TEST(PositionHistory, WrapsAround) {
+    PositionHistory history;
+    for (int ply = 0; ply < 3 * HISTORY_CAPACITY; ++ply) {
+        history.push(ply % 4, false);
+    }
+    EXPECT_EQ(history.size(), 3 * HISTORY_CAPACITY);
+    EXPECT_EQ(history.getHalfmoveClock(), 3 * HISTORY_CAPACITY - 1);
+    EXPECT_EQ(history.repetitionCount(), HISTORY_CAPACITY / 4);
+}
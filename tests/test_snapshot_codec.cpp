@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+#include "snapshot_codec.h"
+#include "fen.h"
+
+namespace {
+
+GameSnapshot sampleSnapshot() {
+    GameSnapshot snapshot{};
+    for (int i = 0; i < NUMBER_OF_PIECES; ++i) {
+        snapshot.pieceSquares[i] = static_cast<uint8_t>(i * 2);
+    }
+    snapshot.pieceSquares[5] = CAPTURED_SQUARE;
+    snapshot.castlingRights = 0x5;
+    snapshot.enPassantSquare = 20;
+    snapshot.sideToMove = 1;
+    snapshot.gameState = 3;
+    snapshot.halfmoveClock = 300;
+    snapshot.fullmoveNumber = 412;
+    snapshot.players[0] = PlayerSnapshot{3, 2, true, false, false};
+    snapshot.players[1] = PlayerSnapshot{20, 1, false, true, true};
+    return snapshot;
+}
+
+} // namespace
+
+// Test that every field survives an encode and decode
+TEST(SnapshotCodec, RoundTrip) {
+    const GameSnapshot snapshot = sampleSnapshot();
+    const SnapshotBytes bytes = encodeSnapshot(snapshot);
+    EXPECT_EQ(bytes[0], SNAPSHOT_VERSION);
+    EXPECT_EQ(decodeSnapshot(bytes.data(), bytes.size()), snapshot);
+
+    GameSnapshot noEnPassant = snapshot;
+    noEnPassant.enPassantSquare = NO_SQUARE;
+    const SnapshotBytes noEnPassantBytes = encodeSnapshot(noEnPassant);
+    EXPECT_EQ(decodeSnapshot(noEnPassantBytes.data(), noEnPassantBytes.size()), noEnPassant);
+}
+
+// Test that blobs of the wrong size, version or content are refused
+TEST(SnapshotCodec, RejectsBadBlobs) {
+    SnapshotBytes bytes = encodeSnapshot(sampleSnapshot());
+    EXPECT_THROW(decodeSnapshot(bytes.data(), bytes.size() - 1), std::runtime_error);
+
+    SnapshotBytes corrupted = bytes;
+    corrupted[10] ^= 0x1;
+    EXPECT_THROW(decodeSnapshot(corrupted.data(), corrupted.size()), std::runtime_error);
+
+    SnapshotBytes futureVersion = bytes;
+    futureVersion[0] = SNAPSHOT_VERSION + 1;
+    futureVersion[SNAPSHOT_BYTES - 1] ^= static_cast<uint8_t>(SNAPSHOT_VERSION ^ (SNAPSHOT_VERSION + 1));
+    EXPECT_THROW(decodeSnapshot(futureVersion.data(), futureVersion.size()), std::runtime_error);
+}
+
+// Test that a blob whose checksum still matches is refused when a field is out of range
+TEST(SnapshotCodec, RejectsOutOfRangeFields) {
+    auto decodes = [](const GameSnapshot& snapshot) {
+        const SnapshotBytes bytes = encodeSnapshot(snapshot);
+        decodeSnapshot(bytes.data(), bytes.size());
+    };
+    EXPECT_NO_THROW(decodes(sampleSnapshot()));
+
+    GameSnapshot offBoard = sampleSnapshot();
+    offBoard.pieceSquares[0] = 0x80;
+    EXPECT_THROW(decodes(offBoard), std::runtime_error);
+
+    GameSnapshot sharedSquare = sampleSnapshot();
+    sharedSquare.pieceSquares[1] = sharedSquare.pieceSquares[2];
+    EXPECT_THROW(decodes(sharedSquare), std::runtime_error);
+
+    GameSnapshot enPassantOffRank = sampleSnapshot();
+    enPassantOffRank.enPassantSquare = 28;      // e4
+    EXPECT_THROW(decodes(enPassantOffRank), std::runtime_error);
+    enPassantOffRank.enPassantSquare = 44;      // e6
+    EXPECT_NO_THROW(decodes(enPassantOffRank));
+
+    GameSnapshot unknownState = sampleSnapshot();
+    unknownState.gameState = static_cast<uint8_t>(GameState::ENDED) + 1;
+    EXPECT_THROW(decodes(unknownState), std::runtime_error);
+
+    GameSnapshot unknownResult = sampleSnapshot();
+    unknownResult.gameEndType = static_cast<uint8_t>(GameEndType::STALEMATE) + 1;
+    EXPECT_THROW(decodes(unknownResult), std::runtime_error);
+
+    GameSnapshot unknownHorcrux = sampleSnapshot();
+    unknownHorcrux.players[1].horcruxID = NUMBER_OF_PIECES + 1;
+    EXPECT_THROW(decodes(unknownHorcrux), std::runtime_error);
+}
+
+// Test that the text form shows the position, counters and both horcruxes
+TEST(SnapshotCodec, TextForm) {
+    Player white(Color::WHITE);
+    Player black(Color::BLACK);
+    Board board;
+    BoardRules rules;
+    Game game(&white, &black, &board, &rules);
+    game.startGame();
+    EXPECT_EQ(toSnapshotText(game), std::string(START_FEN) + " -:2 -:2");
+
+    white.setHorcruxID(15);     // Queen on d1
+    black.setHorcruxID(32);     // King on e8
+    game.checkHorcruxSet();
+    game.movePiece(Move(game.getPieceFromPosition(Position('e', 2)), Position('e', 2), Position('e', 4)), &white);
+    game.horcruxGuess(32, &white, &black);
+
+    // No black pawn can take on e3, so the board leaves the en passant square unset
+    EXPECT_EQ(toSnapshotText(game),
+              "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1 d1:1 e8!:2");
+}
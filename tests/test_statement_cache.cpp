@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+#include "statement_cache.h"
+#include <vector>
+
+namespace {
+
+struct FakeStatement {
+    std::string query;
+};
+
+} // namespace
+
+// Test that each query is prepared once and served from the cache afterwards
+TEST(StatementCache, PreparesOncePerQuery) {
+    std::vector<std::string> prepared;
+    StatementCache<FakeStatement> cache([&prepared](const std::string& query) {
+        prepared.push_back(query);
+        return std::make_unique<FakeStatement>(FakeStatement{query});
+    });
+
+    FakeStatement& first = cache.get("SELECT 1");
+    FakeStatement& again = cache.get("SELECT 1");
+    cache.get("SELECT 2");
+
+    EXPECT_EQ(&first, &again);
+    EXPECT_EQ(prepared, (std::vector<std::string>{"SELECT 1", "SELECT 2"}));
+    EXPECT_EQ(cache.getHits(), 1U);
+    EXPECT_EQ(cache.getMisses(), 2U);
+    EXPECT_EQ(cache.size(), 2U);
+}
+
+// Test that a full cache starts over instead of growing
+TEST(StatementCache, StaysWithinCapacity) {
+    int prepares = 0;
+    StatementCache<FakeStatement> cache([&prepares](const std::string& query) {
+        prepares++;
+        return std::make_unique<FakeStatement>(FakeStatement{query});
+    }, 2);
+
+    cache.get("a");
+    cache.get("b");
+    cache.get("c");
+    EXPECT_LE(cache.size(), 2U);
+    EXPECT_EQ(cache.get("c").query, "c");
+    EXPECT_EQ(prepares, 3);
+}
+
+// Test that a failed prepare leaves nothing behind
+TEST(StatementCache, FailedPrepareIsNotCached) {
+    bool isFailing = true;
+    StatementCache<FakeStatement> cache([&isFailing](const std::string& query) {
+        if (isFailing) {throw std::runtime_error("syntax error");}
+        return std::make_unique<FakeStatement>(FakeStatement{query});
+    });
+
+    EXPECT_THROW(cache.get("SELECT"), std::runtime_error);
+    EXPECT_EQ(cache.size(), 0U);
+    isFailing = false;
+    EXPECT_EQ(cache.get("SELECT").query, "SELECT");
+}
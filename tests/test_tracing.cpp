@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+#include "game_registry.h"
+#include "tracing.h"
+#include <sstream>
+#include <thread>
+
+// Test that spans nest under the open trace and do nothing without one
+TEST(Tracing, SpansNestInOpenTrace) {
+    Tracer tracer;
+    tracer.setSlowThreshold(std::chrono::nanoseconds(0));
+    {
+        TraceSpan ignored("ignored");
+    }
+    EXPECT_EQ(Tracer::active(), nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t traceID = tracer.begin("/game/move");
+    {
+        TraceSpan outer("outer");
+        TraceSpan inner("inner");
+    }
+    {
+        TraceSpan second("second");
+    }
+    tracer.end(traceID, "/game/move", start);
+    EXPECT_EQ(Tracer::active(), nullptr);
+
+    const std::vector<CompletedTrace> traces = tracer.getSlowTraces();
+    ASSERT_EQ(traces.size(), 1U);
+    EXPECT_EQ(traces[0].traceID, traceID);
+    EXPECT_EQ(traces[0].route, "/game/move");
+    ASSERT_EQ(traces[0].spans.size(), 3U);
+    EXPECT_STREQ(traces[0].spans[0].name, "outer");
+    EXPECT_EQ(traces[0].spans[0].depth, 0);
+    EXPECT_EQ(traces[0].spans[1].depth, 1);
+    EXPECT_EQ(traces[0].spans[2].depth, 0);
+    EXPECT_LE(traces[0].spans[1].startNanos + traces[0].spans[1].durationNanos,
+              traces[0].spans[0].startNanos + traces[0].spans[0].durationNanos);
+}
+
+// Test that only slow requests are kept, and that a request finished on another thread keeps its total
+TEST(Tracing, KeepsOnlySlowRequests) {
+    Tracer tracer;
+    tracer.setSlowThreshold(std::chrono::hours(1));
+    const auto start = std::chrono::steady_clock::now();
+    tracer.end(tracer.begin("/fast"), "/fast", start);
+    EXPECT_TRUE(tracer.getSlowTraces().empty());
+
+    tracer.setSlowThreshold(std::chrono::nanoseconds(0));
+    const uint64_t traceID = tracer.begin("/game/state");
+    std::thread([&tracer, traceID, start]() {
+        tracer.end(traceID, "/game/state", start);
+    }).join();
+    // The trace is still open here, since it was finished elsewhere
+    EXPECT_NE(Tracer::active(), nullptr);
+    tracer.end(tracer.begin("/next"), "/next", start);
+
+    const std::vector<CompletedTrace> traces = tracer.getSlowTraces();
+    ASSERT_EQ(traces.size(), 2U);
+    EXPECT_EQ(traces[0].route, "/game/state");
+    EXPECT_TRUE(traces[0].spans.empty());
+    EXPECT_EQ(traces[1].route, "/next");
+}
+
+// Test that the ring keeps the newest traces and a trace keeps a bounded number of spans
+TEST(Tracing, Bounded) {
+    Tracer tracer;
+    tracer.setSlowThreshold(std::chrono::nanoseconds(0));
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TRACE_RING_CAPACITY + 5; ++i) {
+        const uint64_t traceID = tracer.begin("/game/board");
+        for (int span = 0; span < TRACE_MAX_SPANS + 3; ++span) {
+            TraceSpan guard("span");
+        }
+        tracer.end(traceID, "/game/board", start);
+    }
+
+    const std::vector<CompletedTrace> traces = tracer.getSlowTraces();
+    ASSERT_EQ(traces.size(), static_cast<size_t>(TRACE_RING_CAPACITY));
+    EXPECT_LT(traces.front().traceID, traces.back().traceID);
+    EXPECT_EQ(traces.back().spans.size(), static_cast<size_t>(TRACE_MAX_SPANS));
+    EXPECT_EQ(traces.back().droppedSpans, 3U);
+}
+
+// Test that a traced move shows the session, rules and log spans, and both export formats carry them
+TEST(Tracing, TracedMoveExports) {
+    GameRegistry registry;
+    auto pSession = registry.create("game-1", "white-1");
+    pSession->join("black-1");
+    Player* pWhite = pSession->findPlayer("white-1");
+    pSession->selectHorcrux(pWhite, MIN_WHITE_HORCRUXE_ID);
+    pSession->selectHorcrux(pSession->findPlayer("black-1"), MIN_BLACK_HORCRUXE_ID);
+
+    Tracer tracer;
+    tracer.setSlowThreshold(std::chrono::nanoseconds(0));
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t traceID = tracer.begin("/game/move");
+    pSession->movePiece(pWhite, Position('e', 2), Position('e', 4));
+    tracer.end(traceID, "/game/move", start);
+
+    std::ostringstream text;
+    writeTraceText(text, tracer.getSlowTraces());
+    EXPECT_NE(text.str().find("/game/move"), std::string::npos);
+    EXPECT_NE(text.str().find("  GameSession::movePiece"), std::string::npos);
+    EXPECT_NE(text.str().find("    BoardRules::isValidMove"), std::string::npos);
+    EXPECT_NE(text.str().find("      BoardRules::generateValidMoves"), std::string::npos);
+    EXPECT_NE(text.str().find("    Game::checkGameOver"), std::string::npos);
+
+    std::ostringstream chrome;
+    writeChromeTrace(chrome, tracer.getSlowTraces());
+    EXPECT_EQ(chrome.str().rfind("{\"traceEvents\":[{\"name\":\"/game/move\",\"ph\":\"X\"", 0), 0U);
+    EXPECT_NE(chrome.str().find("{\"name\":\"BoardRules::isValidMove\",\"ph\":\"X\""), std::string::npos);
+}
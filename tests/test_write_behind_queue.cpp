@@ -0,0 +1,274 @@
+#include "gtest/gtest.h"
+#include "write_behind_queue.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+class FakeSink : public PersistenceSink {
+    public:
+        void writeBatch(const std::vector<PersistEvent>& events) override {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (failuresLeft_ > 0) {
+                failuresLeft_--;
+                throw std::runtime_error("deadlock found");
+            }
+            batches_.push_back(events);
+        }
+
+        void failNext(int count) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            failuresLeft_ = count;
+        }
+
+        std::vector<std::vector<PersistEvent>> getBatches() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return batches_;
+        }
+
+        std::vector<PersistEvent> getWritten() {
+            std::vector<PersistEvent> written;
+            for (const auto& batch : getBatches()) {
+                written.insert(written.end(), batch.begin(), batch.end());
+            }
+            return written;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::vector<PersistEvent>> batches_;
+        int failuresLeft_ = 0;
+};
+
+PersistEvent stateEvent(const std::string& gameID, int state) {
+    return PersistEvent{PersistEventType::GAME_STATE, gameID, "", state};
+}
+
+} // namespace
+
+// Test that only the last update per game and per player survives, with creates and deletes untouched
+TEST(WriteBehindQueue, CoalescesUpdates) {
+    const std::vector<PersistEvent> events = {
+        {PersistEventType::CREATE_GAME, "g1", "", 0},
+        stateEvent("g1", 1),
+        {PersistEventType::PLAYER_HORCRUX, "", "p1", 3},
+        stateEvent("g2", 1),
+        stateEvent("g1", 2),
+        {PersistEventType::PLAYER_HORCRUX, "", "p1", 5},
+        {PersistEventType::KILL_GAME, "g2", "", 0},
+    };
+    const std::vector<PersistEvent> expected = {
+        {PersistEventType::CREATE_GAME, "g1", "", 0},
+        stateEvent("g2", 1),
+        stateEvent("g1", 2),
+        {PersistEventType::PLAYER_HORCRUX, "", "p1", 5},
+        {PersistEventType::KILL_GAME, "g2", "", 0},
+    };
+    EXPECT_EQ(WriteBehindQueue::coalesce(events), expected);
+}
+
+// Test that a full batch is written without waiting for the interval
+TEST(WriteBehindQueue, FlushesOnSize) {
+    FakeSink sink;
+    WriteBehindConfig config;
+    config.flushSize = 3;
+    config.flushInterval = std::chrono::milliseconds(60000);
+    WriteBehindQueue queue(sink, config);
+
+    for (int game = 0; game < 3; ++game) {
+        queue.enqueue(stateEvent("g" + std::to_string(game), 1));
+    }
+    for (int i = 0; i < 500 && sink.getBatches().empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    ASSERT_EQ(sink.getBatches().size(), 1U);
+    EXPECT_EQ(sink.getBatches()[0].size(), 3U);
+}
+
+// Test that a lone event is written once the interval passes
+TEST(WriteBehindQueue, FlushesOnInterval) {
+    FakeSink sink;
+    WriteBehindConfig config;
+    config.flushSize = 100;
+    config.flushInterval = std::chrono::milliseconds(5);
+    WriteBehindQueue queue(sink, config);
+
+    queue.enqueue(stateEvent("g1", 1));
+    for (int i = 0; i < 500 && sink.getBatches().empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(sink.getWritten(), std::vector<PersistEvent>{stateEvent("g1", 1)});
+}
+
+// Test that a failed batch is retried rather than lost
+TEST(WriteBehindQueue, RetriesFailedBatch) {
+    FakeSink sink;
+    sink.failNext(2);
+    WriteBehindConfig config;
+    config.flushInterval = std::chrono::milliseconds(1);
+    WriteBehindQueue queue(sink, config);
+
+    queue.enqueue(stateEvent("g1", 1));
+    queue.flush();
+    EXPECT_EQ(sink.getWritten(), std::vector<PersistEvent>{stateEvent("g1", 1)});
+    EXPECT_EQ(queue.getStats().failures, 2U);
+    EXPECT_EQ(queue.getStats().written, 1U);
+}
+
+// Test that a batch failing maxAttempts times is dead-lettered next to the WAL and later batches still land
+TEST(WriteBehindQueue, DeadLettersFailingBatch) {
+    const std::string walPath = ::testing::TempDir() + "write_behind_dead_test.wal";
+    std::remove(walPath.c_str());
+    std::remove((walPath + ".dead").c_str());
+
+    FakeSink sink;
+    sink.failNext(3);
+    WriteBehindConfig config;
+    config.walPath = walPath;
+    config.flushInterval = std::chrono::milliseconds(1);
+    config.maxAttempts = 3;
+    config.retryBackoff = std::chrono::milliseconds(1);
+    {
+        WriteBehindQueue queue(sink, config);
+        queue.enqueue(stateEvent("g1", 1));
+        queue.flush();
+        EXPECT_EQ(queue.getStats().failures, 3U);
+        EXPECT_EQ(queue.getStats().deadLettered, 1U);
+        EXPECT_EQ(queue.getStats().written, 0U);
+
+        queue.enqueue(stateEvent("g2", 1));
+        queue.flush();
+        EXPECT_EQ(sink.getWritten(), std::vector<PersistEvent>{stateEvent("g2", 1)});
+    }
+
+    std::ifstream dead(walPath + ".dead");
+    std::string line;
+    ASSERT_TRUE(std::getline(dead, line));
+    EXPECT_EQ(line, "2\tg1\t\t1");
+    EXPECT_FALSE(std::getline(dead, line));
+
+    // Nothing dead-lettered comes back on the next start
+    FakeSink emptySink;
+    {
+        WriteBehindQueue queue(emptySink, config);
+        queue.flush();
+    }
+    EXPECT_TRUE(emptySink.getWritten().empty());
+    std::remove(walPath.c_str());
+    std::remove((walPath + ".dead").c_str());
+}
+
+// Test that the destructor writes whatever is still pending
+TEST(WriteBehindQueue, DrainsOnShutdown) {
+    FakeSink sink;
+    {
+        WriteBehindConfig config;
+        config.flushInterval = std::chrono::milliseconds(60000);
+        WriteBehindQueue queue(sink, config);
+        queue.enqueue(stateEvent("g1", 1));
+        queue.enqueue(stateEvent("g2", 1));
+    }
+    EXPECT_EQ(sink.getWritten().size(), 2U);
+}
+
+// Test that events acknowledged through the WAL are replayed by the next queue on the same path
+TEST(WriteBehindQueue, ReplaysWal) {
+    const std::string walPath = ::testing::TempDir() + "write_behind_test.wal";
+    std::remove(walPath.c_str());
+    std::remove((walPath + ".flushing").c_str());
+
+    WriteBehindConfig config;
+    config.walPath = walPath;
+    config.flushInterval = std::chrono::milliseconds(1);
+    {
+        // A sink that never succeeds stands in for a crash before the commit
+        FakeSink downSink;
+        downSink.failNext(1000000);
+        WriteBehindQueue queue(downSink, config);
+        queue.enqueue({PersistEventType::CREATE_PLAYER, "", "p1", 1});
+        queue.enqueue(stateEvent("g1", 2));
+    }
+
+    FakeSink sink;
+    {
+        WriteBehindQueue queue(sink, config);
+        queue.flush();
+    }
+    const std::vector<PersistEvent> expected = {{PersistEventType::CREATE_PLAYER, "", "p1", 1}, stateEvent("g1", 2)};
+    EXPECT_EQ(sink.getWritten(), expected);
+
+    // Once committed, nothing is replayed again
+    FakeSink emptySink;
+    {
+        WriteBehindQueue queue(emptySink, config);
+        queue.flush();
+    }
+    EXPECT_TRUE(emptySink.getWritten().empty());
+    std::remove(walPath.c_str());
+}
+
+// Test that a WAL line cut short before its newline is not replayed, even when every field is there
+TEST(WriteBehindQueue, SkipsTornWalLine) {
+    const std::string walPath = ::testing::TempDir() + "write_behind_torn_test.wal";
+    std::remove((walPath + ".flushing").c_str());
+    {
+        std::ofstream wal(walPath, std::ios::trunc);
+        wal << "3\t\tp1\t21\n" << "3\t\tp2\t2";    // p2's horcrux ID 21 torn after its first digit
+    }
+
+    WriteBehindConfig config;
+    config.walPath = walPath;
+    config.flushInterval = std::chrono::milliseconds(1);
+    FakeSink sink;
+    {
+        WriteBehindQueue queue(sink, config);
+        queue.flush();
+    }
+    const std::vector<PersistEvent> expected = {{PersistEventType::PLAYER_HORCRUX, "", "p1", 21}};
+    EXPECT_EQ(sink.getWritten(), expected);
+    std::remove(walPath.c_str());
+}
+
+// Test that producers sharing WAL fsyncs still get every event written exactly once
+TEST(WriteBehindQueue, ConcurrentWalEnqueue) {
+    const std::string walPath = ::testing::TempDir() + "write_behind_group_test.wal";
+    std::remove(walPath.c_str());
+    std::remove((walPath + ".flushing").c_str());
+
+    WriteBehindConfig config;
+    config.walPath = walPath;
+    config.flushSize = 16;
+    config.flushInterval = std::chrono::milliseconds(1);
+    FakeSink sink;
+    const int threads = 8;
+    const int perThread = 50;
+    {
+        WriteBehindQueue queue(sink, config);
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&queue, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    queue.enqueue({PersistEventType::CREATE_GAME, "g" + std::to_string(t * perThread + i), "", 0});
+                }
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        queue.flush();
+        EXPECT_EQ(queue.getStats().written, static_cast<uint64_t>(threads * perThread));
+    }
+    EXPECT_EQ(sink.getWritten().size(), static_cast<size_t>(threads * perThread));
+
+    // Everything was committed, so nothing is left to replay
+    FakeSink emptySink;
+    {
+        WriteBehindQueue queue(emptySink, config);
+        queue.flush();
+    }
+    EXPECT_TRUE(emptySink.getWritten().empty());
+    std::remove(walPath.c_str());
+}
@@ -0,0 +1,73 @@
+#include "gtest/gtest.h"
+#include "fen.h"
+#include "board_rules.h"
+
+namespace {
+
+// Walks every line to `depth`, checking the incremental key against a full recompute on the way
+void expectKeysMatch(Board& board, const BoardRules& rules, int depth) {
+    ASSERT_EQ(board.getZobristKey(), board.computeZobristKey());
+    if (depth == 0) {return;}
+
+    MoveList moves;
+    rules.generateLegalMoves(board, board.getSideToMove(), moves);
+    for (const CompactMove& move : moves) {
+        const ZobristKey before = board.getZobristKey();
+        const UndoRecord undo = board.makeMove(move);
+        expectKeysMatch(board, rules, depth - 1);
+        board.unmakeMove(move, undo);
+        ASSERT_EQ(board.getZobristKey(), before);
+    }
+}
+
+CompactMove quiet(const Position& from, const Position& to) {
+    return CompactMove(toSquare(from), toSquare(to));
+}
+
+}
+
+// Test that the incremental key follows captures, castling, en passant and promotions
+TEST(Zobrist, IncrementalMatchesRecomputed) {
+    BoardRules rules;
+    Board board;
+    loadFen(board, "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+    expectKeysMatch(board, rules, 3);
+}
+
+// Test that reaching the same position by another route gives the same key
+TEST(Zobrist, TranspositionsShareAKey) {
+    Board board;
+    loadFen(board, START_FEN);
+    const ZobristKey start = board.getZobristKey();
+
+    board.makeMove(quiet(Position('g', 1), Position('f', 3)));
+    EXPECT_NE(board.getZobristKey(), start);
+    board.makeMove(quiet(Position('g', 8), Position('f', 6)));
+    board.makeMove(quiet(Position('f', 3), Position('g', 1)));
+    board.makeMove(quiet(Position('f', 6), Position('g', 8)));
+    EXPECT_EQ(board.getZobristKey(), start);
+}
+
+// Test that side to move and an unusable en passant square are handled
+TEST(Zobrist, SideToMoveAndEnPassant) {
+    Board white, black;
+    loadFen(white, "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1");
+    loadFen(black, "4k3/8/8/8/8/8/4P3/4K3 b - - 0 1");
+    EXPECT_NE(white.getZobristKey(), black.getZobristKey());
+
+    // No black pawn can take on e3, so the double push leaves no en passant square behind
+    white.makeMove(CompactMove(toSquare(Position('e', 2)), toSquare(Position('e', 4)), MoveFlag::DOUBLE_PAWN_PUSH));
+    Board pushed;
+    loadFen(pushed, "4k3/8/8/8/4P3/8/8/4K3 b - - 0 1");
+    EXPECT_EQ(white.getEnPassantSquare(), NO_SQUARE);
+    EXPECT_EQ(white.getZobristKey(), pushed.getZobristKey());
+}
+
+// Test that every square hashes differently
+TEST(Zobrist, PositionHashIsInjectiveOnTheBoard) {
+    std::unordered_set<size_t> hashes;
+    for (int square = 0; square < NUMBER_OF_SQUARES; ++square) {
+        hashes.insert(std::hash<Position>()(toPosition(square)));
+    }
+    EXPECT_EQ(hashes.size(), NUMBER_OF_SQUARES);
+}